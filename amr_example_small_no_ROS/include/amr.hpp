@@ -10,5 +10,20 @@
 #include "amr_unit.hpp"
 #include "basic_routines.hpp"
 #include "basic_structs.hpp"
+#include "catalog_distance_matrix.hpp"
+#include "catalog_path_table.hpp"
+#include "distance_matrix.hpp"
+#include "distance_metrics.hpp"
+#include "order_directory_watcher.hpp"
+#include "order_file_filters.hpp"
+#include "order_file_scanner.hpp"
+#include "order_index.hpp"
+#include "order_store.hpp"
+#include "path_cache.hpp"
+#include "path_evaluator.hpp"
+#include "path_solvers.hpp"
+#include "small_path_solvers.hpp"
+#include "thread_pool.hpp"
+#include "warehouse_graph.hpp"
 
 #endif  // INCLUDE_AMR_HPP_
@@ -5,6 +5,9 @@
 #ifndef INCLUDE_AMR_TASK_EXECUTORS_HPP_
 #define INCLUDE_AMR_TASK_EXECUTORS_HPP_
 
+#include <chrono>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <mutex>
 #include <string>
@@ -69,6 +72,17 @@ class MoveExecutor : public TaskExecutor {
   AMR::Position _target_position;  //!< Target position for an AMR unit.
 };
 
+/**
+ * @brief Information about an order that is needed before its pickup order
+ * is determined.
+ */
+struct ResolvedOrder {
+  bool _found = false;                 //!< Whether the order was found.
+  AMR::Coordinates2D _delivery_point;  //!< Delivery point of the order.
+  AMR::ProcessedProductParts
+      _processed_product_parts;  //!< Product parts of the ordered products.
+};
+
 /**
  * @brief Task executor that is used to let an AMR unit process an order.
  *
@@ -80,9 +94,15 @@ class OrderExecutor : public TaskExecutor {
    *
    * @param[in] order_id  Id of the order that is executed.
    * @param[in] order_description   Description of the order that is executed.
+   * @param[in] planning_budget_ms  Time in milliseconds that may be spent on
+   * determining the pickup order. If it is 0, the planning budget of the
+   * executing AMR unit is used.
    */
-  OrderExecutor(const uint32_t order_id, const std::string& order_description)
-      : _order_id(order_id), _order_description(order_description){};
+  OrderExecutor(const uint32_t order_id, const std::string& order_description,
+                const uint32_t planning_budget_ms = 0)
+      : _order_id(order_id),
+        _order_description(order_description),
+        _planning_budget_ms(planning_budget_ms){};
 
   /**
    * @brief Lets a given AMR unit execute the operation corresponding to the
@@ -95,7 +115,41 @@ class OrderExecutor : public TaskExecutor {
   virtual void execute(AMR::AmrUnit& target_unit,
                        std::ostream& stream = std::cout) const;
 
+  /**
+   * @brief Starts to look up the order and to aggregate its product parts
+   * on the thread pool of the unit, so that the information is available
+   * when the order is executed.
+   *
+   * @param[in] target_unit AMR unit that will execute the order. It has to
+   * outlive the lookup.
+   */
+  void prefetch(AMR::AmrUnit& target_unit);
+
+  /**
+   * @brief Checks whether the lookup started by @ref prefetch is finished.
+   *
+   * @return true The order was prefetched, and @ref execute uses the result
+   * if the order was found.
+   * @return false  The order was not prefetched or the lookup is running.
+   */
+  bool isPrefetched() const {
+    return _resolved_order.valid() &&
+           _resolved_order.wait_for(std::chrono::seconds(0)) ==
+               std::future_status::ready;
+  }
+
  private:
+  /**
+   * @brief Looks up an order and aggregates the product parts of its
+   * products.
+   *
+   * @param[in] target_unit AMR unit that executes the order.
+   * @param[in] order_id  Id of the order.
+   * @return Information about the order.
+   */
+  static ResolvedOrder resolveOrder(AMR::AmrUnit& target_unit,
+                                    const uint32_t order_id);
+
   /**
    * @brief Prints the delivery path of the given order.
    *
@@ -126,14 +180,20 @@ class OrderExecutor : public TaskExecutor {
    * @param[out] processed_product_parts Properly processed product parts. (See
    * the definition of the struct for clarification)
    */
-  void processOrderedProducts(
+  static void processOrderedProducts(
       const std::vector<long long int>& ordered_products,
       const std::vector<AMR::Product>& all_products,
-      AMR::ProcessedProductParts& processed_product_parts) const;
+      AMR::ProcessedProductParts& processed_product_parts);
 
   uint32_t _order_id;  //!< Id of the order that is executed.
   std::string
       _order_description;  //!< Description of the order that is executed.
+  uint32_t _planning_budget_ms;  //!< Planning budget of the order in
+                                 //!< milliseconds, 0 if the budget of the
+                                 //!< AMR unit is used.
+  std::shared_future<ResolvedOrder>
+      _resolved_order;  //!< Result of @ref prefetch, invalid if the order
+                        //!< was not prefetched.
 };
 
 /**
@@ -147,6 +207,10 @@ struct TaskQueue {
   std::queue<AMR::TaskExecutor*>
       _queue;      //!< Queue to store incoming task messages.
   bool _shutdown;  //!< Boolean that signals that a shutdown is desired.
+  std::function<void(AMR::OrderExecutor&)>
+      _prefetch;  //!< Called for every order before it is queued while
+                  //!< holding @ref _mutex, may be empty. Orders received
+                  //!< after the shutdown are neither prefetched nor queued.
 };
 
 }  // namespace AMR
@@ -13,6 +13,16 @@
 #include "amr_interface.hpp"
 #include "amr_task_executors.hpp"
 #include "basic_structs.hpp"
+#include "catalog_distance_matrix.hpp"
+#include "catalog_path_table.hpp"
+#include "order_directory_watcher.hpp"
+#include "order_file_filters.hpp"
+#include "order_index.hpp"
+#include "order_store.hpp"
+#include "path_cache.hpp"
+#include "path_solvers.hpp"
+#include "thread_pool.hpp"
+#include "warehouse_graph.hpp"
 
 namespace AMR {
 
@@ -86,10 +96,180 @@ class AmrUnit {
     return _all_product_parts;
   }
 
+  /**
+   * @brief Get the options used to determine the pickup order of orders.
+   *
+   * @return @ref _path_solver_options.
+   */
+  const AMR::PathSolverOptions& getPathSolverOptions() const {
+    return _path_solver_options;
+  }
+
+  /**
+   * @brief Set the options used to determine the pickup order of orders.
+   *
+   * The path cache is cleared, since its entries might have been determined
+   * by different solvers.
+   *
+   * @param[in] options New options.
+   */
+  void setPathSolverOptions(const AMR::PathSolverOptions& options) {
+    _path_solver_options = options;
+    _path_cache.clear();
+  }
+
+  /**
+   * @brief Get the distances between the locations of the catalog.
+   *
+   * @return @ref _catalog_distances.
+   */
+  const AMR::CatalogDistanceMatrix& getCatalogDistances() const {
+    return _catalog_distances;
+  }
+
+  /**
+   * @brief Set the largest number of bytes used to store the distances
+   * between the locations of the catalog. It takes effect when the unit
+   * starts running.
+   *
+   * @param[in] memory_cap_bytes  Memory cap; 0 means that there is no cap.
+   */
+  void setCatalogDistanceMemoryCap(const size_t memory_cap_bytes) {
+    _catalog_distance_memory_cap = memory_cap_bytes;
+  }
+
+  /**
+   * @brief Get the table of shortest paths between the catalog locations.
+   *
+   * @return @ref _catalog_path_table.
+   */
+  const AMR::CatalogPathTable& getCatalogPathTable() const {
+    return _catalog_path_table;
+  }
+
+  /**
+   * @brief Get the graph of the aisles of the warehouse.
+   *
+   * @return @ref _warehouse_graph. It is empty if no graph is configured.
+   */
+  const AMR::WarehouseGraph& getWarehouseGraph() const {
+    return _warehouse_graph;
+  }
+
+  /**
+   * @brief Get the index of the orders in the orders subdirectory.
+   *
+   * @return @ref _order_index. It is built when the unit starts running.
+   */
+  const AMR::OrderIndex& getOrderIndex() const { return _order_index; }
+
+  /**
+   * @brief Get the filters of the order ids of the order files.
+   *
+   * @return @ref _order_file_filters. They are built when the unit starts
+   * running.
+   */
+  const AMR::OrderFileFilters& getOrderFileFilters() const {
+    return _order_file_filters;
+  }
+
+  /**
+   * @brief Set the path of the persisted order index. It takes effect when
+   * the unit starts running.
+   *
+   * @param[in] index_path  Path of the index file; an empty path disables
+   * persisting the index. By default, the index is stored as
+   * ".order_index" in the orders subdirectory.
+   */
+  void setOrderIndexPath(const std::string& index_path) {
+    _order_index_path = index_path;
+  }
+
+  /**
+   * @brief Get the compiled store of the orders.
+   *
+   * @return @ref _order_store. It is opened when the unit starts running, if
+   * the store file exists.
+   */
+  const AMR::OrderStore& getOrderStore() const { return _order_store; }
+
+  /**
+   * @brief Set the path of the compiled order store, which is written by the
+   * order_compiler executable. It takes effect when the unit starts running.
+   *
+   * @param[in] store_path  Path of the store file; an empty path disables
+   * the store. By default, the store is "orders.store" in the orders
+   * subdirectory.
+   */
+  void setOrderStorePath(const std::string& store_path) {
+    _order_store_path = store_path;
+  }
+
+  /**
+   * @brief Resolves several orders at once, e.g. when a wave of orders
+   * arrives.
+   *
+   * The orders are looked up in the compiled store, then in one pass over
+   * the order index. Orders whose files changed since they were indexed, and
+   * all orders if the index is not built, are searched in one pass over all
+   * order files.
+   *
+   * @param[in] order_ids  Ids of the orders whose information is wanted.
+   * @param[out] orders  Information about the orders, in the order of
+   * @p order_ids.
+   * @return Ids of the orders that were not found, without duplicates.
+   */
+  std::vector<uint32_t> findOrders(const std::vector<uint32_t>& order_ids,
+                                   std::vector<AMR::OrderInformation>& orders);
+
+  /**
+   * @brief Get the cache of determined pickup orders.
+   *
+   * @return @ref _path_cache.
+   */
+  AMR::PathCache& getPathCache() { return _path_cache; }
+
+  /**
+   * @brief Set the number of most recent order files whose orders are solved
+   * and inserted into the path cache when the unit starts running.
+   *
+   * @param[in] n_days Number of order files (one per day). 0 disables the
+   * preloading.
+   */
+  void setPathCachePreloadDays(const size_t n_days) {
+    _path_cache_preload_days = n_days;
+  }
+
+  /**
+   * @brief Get the pool shared by the order lookup, the precomputations on
+   * the catalog and the parallel solvers.
+   *
+   * @return @ref _thread_pool. It is started when the unit starts running.
+   */
+  AMR::ThreadPool& getThreadPool() { return _thread_pool; }
+
+  /**
+   * @brief Set the number of threads of the pool. It takes effect when the
+   * unit starts running.
+   *
+   * @param[in] n_threads  Number of threads; 0 means the number of hardware
+   * threads.
+   */
+  void setThreadPoolSize(const size_t n_threads) {
+    _thread_pool_size = n_threads;
+  }
+
+  /**
+   * @brief Prepares the AmrUnit for executing tasks: starts the thread pool,
+   * parses the configuration, builds the precomputed tables and indexes the
+   * order files. It is called by @ref run.
+   */
+  void initialize();
+
   /**
    * @brief Lets the AmrUnit run.
    *
-   * When calling this routine the AmrInterface starts to listen for messages
+   * The unit is initialized first. Then the AmrInterface starts to listen for messages
    * and fills the task queue with tasks, which are then executed.
    *
    * The AmrUnit can be turned off by sending a message to the
@@ -99,6 +279,10 @@ class AmrUnit {
   void run();
 
  private:
+  AMR::ThreadPool _thread_pool;  //!< Pool executing all parallel work of the
+                                 //!< unit.
+  size_t _thread_pool_size;  //!< Number of threads of @ref _thread_pool, 0
+                             //!< for the number of hardware threads.
   AMR::Interface* _interface;   //!< Interface handling incoming tasks;
   AMR::TaskQueue* _task_queue;  //!< Incoming tasks are added into this queue in
                                 //!< a thread safe manner.
@@ -121,6 +305,35 @@ class AmrUnit {
                            //!< NOTE: One could store this outside of the
                            //!< unit, to allow several units to access the same
                            //!< vector (if desired).
+  AMR::PathSolverOptions
+      _path_solver_options;  //!< Options used to determine the pickup order.
+  AMR::CatalogDistanceMatrix
+      _catalog_distances;  //!< Distances between the locations of the
+                           //!< catalog, computed when the unit starts running.
+  size_t _catalog_distance_memory_cap;  //!< Memory cap in bytes for
+                                        //!< @ref _catalog_distances, 0 if
+                                        //!< there is no cap.
+  AMR::CatalogPathTable
+      _catalog_path_table;  //!< Shortest paths between the locations of the
+                            //!< catalog, built when the unit starts running.
+  AMR::WarehouseGraph
+      _warehouse_graph;  //!< Graph of the aisles, read from the configuration
+                         //!< subdirectory if present.
+  AMR::OrderIndex _order_index;  //!< Position of every order in the order
+                                 //!< files, built when the unit starts
+                                 //!< running.
+  std::string _order_index_path;  //!< Path of the persisted order index.
+  AMR::OrderFileFilters
+      _order_file_filters;  //!< Filters of the order ids of every order
+                            //!< file, built when the unit starts running.
+  AMR::OrderDirectoryWatcher
+      _order_watcher;  //!< Updates @ref _order_index while the unit is
+                       //!< running.
+  AMR::OrderStore _order_store;    //!< Compiled store of the orders.
+  std::string _order_store_path;   //!< Path of the compiled order store.
+  AMR::PathCache _path_cache;  //!< Cache of determined pickup orders.
+  size_t _path_cache_preload_days;  //!< Number of order files used to fill
+                                    //!< @ref _path_cache on start.
 };
 }  // namespace AMR
 
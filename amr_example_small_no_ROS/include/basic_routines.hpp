@@ -7,6 +7,7 @@
 #define INCLUDE_BASIC_ROUTINES_HPP_
 
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include <mutex>    //  std::mutex
@@ -15,11 +16,45 @@
 #include <limits>
 
 #include "basic_structs.hpp"
+#include "catalog_distance_matrix.hpp"
+#include "catalog_path_table.hpp"
+#include "distance_matrix.hpp"
+#include "distance_metrics.hpp"
+#include "order_file_filters.hpp"
+#include "order_file_scanner.hpp"
+#include "order_store.hpp"
+#include "path_solvers.hpp"
+#include "small_path_solvers.hpp"
+#include "thread_pool.hpp"
+#include "warehouse_graph.hpp"
 
 namespace AMR {
 
-void parseSingleFile(const std::string& file_path, uint32_t order_id, AMR::Coordinates2D& delivery_point,
-                         std::vector<long long int>& ordered_products, std::mutex& mutex, bool& order_found);
+/**
+ * @brief Searches a single order file for an order.
+ *
+ * The file is scanned by @ref AMR::scanOrderFile, or parsed by yaml-cpp if
+ * the scanner rejects it. If the same order id occurs more than once in the
+ * file, the first record is used.
+ *
+ * @param[in] file_path  Path of the order file.
+ * @param[in] order_id  Id of the order whose information is wanted.
+ * @param[in,out] delivery_point Delivery point of the order.
+ * @param[in,out] ordered_products Products of the order.
+ * @param[in,out] token  State shared with the searches of other files, or
+ * nullptr. The search stops as soon as a file with higher precedence
+ * contains the order.
+ * @param[in] file  Number of the file for @p token.
+ * @return true The order was found. The output variables are only changed
+ * in this case.
+ * @return false  The order was not found or the search was stopped.
+ */
+bool parseSingleFile(const std::string &file_path, const uint32_t order_id,
+                     AMR::Coordinates2D &delivery_point,
+                     std::vector<long long int> &ordered_products,
+                     AMR::OrderSearchToken *token = nullptr,
+                     const size_t file = 0);
+
 /**
  * @brief Determines the length of a given path
  *
@@ -34,17 +69,90 @@ void parseSingleFile(const std::string& file_path, uint32_t order_id, AMR::Coord
  * @param pickup_order  Specifies the order in which the part locations are
  * visited. It is a vector of pairwise different integers in the set
  * {0, ..., n-1} where n is the number of parts given.
+ * @param metric  Metric in which the distances are measured.
  * @return double
  */
+double determinePathLength(
+    const AMR::Coordinates2D &starting_point,
+    const std::vector<Coordinates2D> &part_locations,
+    const AMR::Coordinates2D &delivery_point,
+    const std::vector<int> &pickup_order,
+    const AMR::DistanceMetric metric = DistanceMetric::kEuclidean);
+
+/**
+ * @brief Determines the length of a given path in a metric known at compile
+ * time.
+ *
+ * @tparam Metric  Policy class of the metric, see distance_metrics.hpp.
+ * @param starting_point  Starting point of the path.
+ * @param part_locations  Points on the path between the starting and the end
+ * point.
+ * @param delivery_point  End point of the path.
+ * @param pickup_order  Order in which the part locations are visited.
+ * @return Length of the path.
+ */
+template <typename Metric>
 double determinePathLength(const AMR::Coordinates2D &starting_point,
                            const std::vector<Coordinates2D> &part_locations,
                            const AMR::Coordinates2D &delivery_point,
-                           const std::vector<int> &pickup_order);
+                           const std::vector<int> &pickup_order) {
+  if (pickup_order.empty()) {
+    return computeDistance<Metric>(starting_point, delivery_point);
+  }
+  double path_length =
+      computeDistance<Metric>(starting_point, part_locations[pickup_order[0]]);
+  for (size_t i = 0; i < pickup_order.size() - 1; ++i) {
+    path_length += computeDistance<Metric>(part_locations[pickup_order[i]],
+                                           part_locations[pickup_order[i + 1]]);
+  }
+  path_length += computeDistance<Metric>(part_locations[pickup_order.back()],
+                                         delivery_point);
+  return path_length;
+}
+
+/**
+ * @brief Merges part locations that share a pickup point into route nodes.
+ *
+ * Two locations share a pickup point if both of their coordinates differ by
+ * at most @p epsilon. Each route node is placed at the first location
+ * assigned to it, and a location is only compared with these first
+ * locations, so the locations of a node are never farther apart than
+ * 2 * @p epsilon.
+ *
+ * @param[in] part_locations  Locations of all parts which have to be
+ * collected.
+ * @param[in] epsilon  Largest coordinate difference of merged locations.
+ * @param[out] route_nodes  Coordinates of the route nodes, in the order of
+ * their first location.
+ * @param[out] node_of_location  Index of the route node of each location.
+ */
+void collapseColocatedLocations(
+    const std::vector<Coordinates2D> &part_locations, const double epsilon,
+    std::vector<Coordinates2D> &route_nodes,
+    std::vector<int> &node_of_location);
+
+/**
+ * @brief Expands the order in which route nodes are visited into the order
+ * in which the part locations are visited.
+ *
+ * The locations of a route node are visited one after the other, in
+ * ascending order of their indices.
+ *
+ * @param[in] route_order  Order in which the route nodes are visited.
+ * @param[in] node_of_location  Index of the route node of each location, as
+ * determined by @ref AMR::collapseColocatedLocations.
+ * @param[out] pickup_order  Order in which the part locations are visited.
+ */
+void expandRouteOrder(const std::vector<int> &route_order,
+                      const std::vector<int> &node_of_location,
+                      std::vector<int> &pickup_order);
 
 /**
  * @brief Determines the geometrically shortest path connecting a given starting
  * and delivery point while collecting several parts on the way.
  *
+ * The path is determined with the default @ref AMR::PathSolverOptions.
+ *
  * @param[in] starting_point  Starting point of the path.
  * @param[in] part_locations  Vector containing the locations of all parts which
  * have to be collected.
@@ -57,6 +165,99 @@ void determineShortestPath(const AMR::Coordinates2D &starting_point,
                            const AMR::Coordinates2D &delivery_point,
                            std::vector<int> &pickup_order);
 
+/**
+ * @brief Determines the geometrically shortest path connecting a given starting
+ * and delivery point while collecting several parts on the way.
+ *
+ * Orders with at most @ref AMR::PathSolverOptions::_heuristic_cutoff part
+ * locations are solved exactly by @ref AMR::solveHeldKarp, which runs in
+ * O(2^n * n^2) for n part locations. Larger orders are solved by
+ * @ref AMR::solveHeuristic, whose path is short but not necessarily the
+ * shortest one.
+ *
+ * If a planning budget is set, a heuristic path is determined first, and the
+ * exact solver only runs until the budget is used up. The shorter of the
+ * heuristic path and the best path of the exact solver is returned then.
+ *
+ * Part locations that share a pickup point (see
+ * @ref AMR::collapseColocatedLocations) are merged into one route node before
+ * solving, which can reduce the number of nodes considerably. Orders with at
+ * most @ref AMR::kSmallSolverDispatchLimit route nodes are solved by
+ * @ref AMR::solveSmall regardless of the selected exact solver, since it
+ * takes only microseconds and needs no distance matrix.
+ *
+ * If a warehouse graph is given, all distances are travel distances through
+ * its aisles instead of straight lines, and the small solvers are not used.
+ *
+ * @param[in] starting_point  Starting point of the path.
+ * @param[in] part_locations  Vector containing the locations of all parts which
+ * have to be collected.
+ * @param[in] delivery_point  Delivery coordinates of the order.
+ * @param[in,out] pickup_order  Order in which the products have to be picked
+ * up.
+ * @param[in] options  Options that select and configure the solvers.
+ * @param[in] catalog_distances  If not null, the distances between the part
+ * locations are taken from it instead of being computed.
+ * @param[in] warehouse_graph  If not null, the graph of the aisles on which
+ * the distances are measured. It takes precedence over @p catalog_distances.
+ * @return Length of the path and whether it is proven to be the shortest.
+ */
+AMR::PathSolverResult determineShortestPath(
+    const AMR::Coordinates2D &starting_point,
+    const std::vector<Coordinates2D> &part_locations,
+    const AMR::Coordinates2D &delivery_point, std::vector<int> &pickup_order,
+    const AMR::PathSolverOptions &options,
+    const AMR::CatalogDistanceMatrix *catalog_distances = nullptr,
+    const AMR::WarehouseGraph *warehouse_graph = nullptr);
+
+/**
+ * @brief Determines the pickup order of an order as the AMR unit does when
+ * it executes the order: orders of a catalog that is covered by the
+ * precomputed path table are looked up, all others are solved by
+ * @ref AMR::determineShortestPath.
+ *
+ * @param[in] starting_point  Starting point of the path.
+ * @param[in] part_locations  Vector containing the locations of all parts which
+ * have to be collected.
+ * @param[in] delivery_point  Delivery coordinates of the order.
+ * @param[in,out] pickup_order  Order in which the products have to be picked
+ * up.
+ * @param[in] options  Options that select and configure the solvers.
+ * @param[in] catalog_table  If not null, the precomputed path table of the
+ * catalog.
+ * @param[in] catalog_distances  If not null, the distances between the part
+ * locations are taken from it instead of being computed.
+ * @param[in] warehouse_graph  If not null, the graph of the aisles on which
+ * the distances are measured.
+ * @param[out] reusable  Whether the pickup order may be reused for later
+ * orders with the same parts and points. Paths cut short by the planning
+ * budget depend on the timing, so they are not reusable.
+ * @return Length of the path and whether it is proven to be the shortest.
+ */
+AMR::PathSolverResult determineOrderPath(
+    const AMR::Coordinates2D &starting_point,
+    const std::vector<Coordinates2D> &part_locations,
+    const AMR::Coordinates2D &delivery_point, std::vector<int> &pickup_order,
+    const AMR::PathSolverOptions &options,
+    const AMR::CatalogPathTable *catalog_table,
+    const AMR::CatalogDistanceMatrix *catalog_distances,
+    const AMR::WarehouseGraph *warehouse_graph, bool &reusable);
+
+/**
+ * @brief Overload of @ref AMR::determineShortestPath that uses a precomputed
+ * distance matrix of the order.
+ *
+ * @param[in] distances  Distances between the starting point, the part
+ * locations and the delivery point.
+ * @param[in,out] pickup_order  Order in which the products have to be picked
+ * up.
+ * @param[in] options  Options that select and configure the solvers.
+ * @return Length of the path and whether it is proven to be the shortest.
+ */
+AMR::PathSolverResult determineShortestPath(
+    const AMR::DistanceMatrix &distances, std::vector<int> &pickup_order,
+    const AMR::PathSolverOptions &options);
+
 /**
  * @brief Parses the configuration file in the proper subdirectory and
  * fills a given vector with the products in this file.
@@ -73,6 +274,56 @@ void parseConfigurationFiles(const std::string &dir_path,
                              std::vector<AMR::Product> &all_products,
                              std::vector<AMR::ProductPart> &all_product_parts);
 
+/**
+ * @brief Parses the optional settings file `settings.yaml` in the
+ * configuration directory, which adjusts the options of a deployment.
+ *
+ * The supported key is `distance_metric` (one of `euclidean`,
+ * `squared_euclidean`, `manhattan` and `chebyshev`). Options that are not
+ * given in the file are left unchanged.
+ *
+ * @param[in] dir_path  Path to the directory containing the configuration
+ * files.
+ * @param[in,out] options  Options that are adjusted.
+ * @return true The file does not exist or was parsed.
+ * @return false  The file is invalid.
+ */
+bool parseSettingsFile(const std::string &dir_path,
+                       AMR::PathSolverOptions &options);
+
+/**
+ * @brief Parses the planning budget of an order message.
+ *
+ * @param[in] text  Value of the key `planning_budget_ms`.
+ * @param[out] planning_budget_ms  Budget in milliseconds. It is 0 if the
+ * value is rejected.
+ * @return true The value is a non-negative integer that fits 32 bits.
+ * @return false  The value was rejected.
+ */
+bool parsePlanningBudget(const std::string &text,
+                         uint32_t &planning_budget_ms);
+
+/**
+ * @brief Checks whether a file name is the name of an order file.
+ *
+ * @param[in] file_name  Name of the file, without directory.
+ * @return true The name has the form orders_<date>.yaml.
+ * @return false  The file is not an order file.
+ */
+bool isOrderFileName(const std::string &file_name);
+
+/**
+ * @brief Lists the order files in a directory.
+ *
+ * Order files are named orders_<date>.yaml, with the date given as YYYYMMDD,
+ * so sorting the names sorts the files by date.
+ *
+ * @param[in] dir_path  Path to the directory containing the order files.
+ * @return Paths of all order files, sorted by name. The vector is empty if
+ * the directory does not exist.
+ */
+std::vector<std::string> listOrderFiles(const std::string &dir_path);
+
 /**
  * @brief Parses all order files in the proper subdirectory searching for
  * information about an order whose id is known.
@@ -82,18 +333,61 @@ void parseConfigurationFiles(const std::string &dir_path,
  * Otherwise, the return value is set to false and the output variables are
  * not changed.
  *
+ * The files are searched in parallel, and large files are split into chunks
+ * at record boundaries that are searched in parallel as well. If the order
+ * id occurs in several files, the record in the file whose name sorts first
+ * is used, and within a file the first record; the searches of all later
+ * chunks stop as soon as an earlier chunk contains the order.
+ *
  * @param[in] dir_path  Path to the directory containing the order
  * files.
  * @param[in] order_id  Id of the order whose information is wanted.
  * @param[in,out] delivery_point Delivery point of the order.
  * @param[in,out] ordered_products Products of the order.
+ * @param[in] thread_pool  Pool that searches the files. If it is null, a
+ * thread is started for each chunk.
+ * @param[in] order_store  Compiled store of the order files, or nullptr. If
+ * it is open and contains the order, no file is parsed. Orders published
+ * after the store was compiled are searched in the files.
+ * @param[in] order_file_filters  Filters of the order ids of the files, or
+ * nullptr. Files whose filter rules out the order are not opened.
  * @return true The order was found.
  * @return false  The order was not found.
  */
-bool parseAllFilesToFindOrder(const std::string &dir_path,
-                              const uint32_t order_id,
-                              AMR::Coordinates2D &delivery_point,
-                              std::vector<long long int> &ordered_products);
+bool parseAllFilesToFindOrder(
+    const std::string &dir_path, const uint32_t order_id,
+    AMR::Coordinates2D &delivery_point,
+    std::vector<long long int> &ordered_products,
+    AMR::ThreadPool *thread_pool = nullptr,
+    const AMR::OrderStore *order_store = nullptr,
+    const AMR::OrderFileFilters *order_file_filters = nullptr);
+
+/**
+ * @brief Parses all order files in the proper subdirectory searching for
+ * information about several orders at once.
+ *
+ * Every file is read once for all orders, and the files, or chunks of large
+ * files, are searched in parallel. Orders are looked up in the same way as by
+ * @ref parseAllFilesToFindOrder, i.e. if an order id occurs in several files,
+ * the record in the file whose name sorts first is used.
+ *
+ * @param[in] dir_path  Path to the directory containing the order files.
+ * @param[in] order_ids  Ids of the orders whose information is wanted. They
+ * may contain duplicates.
+ * @param[out] orders  Information about the orders, in the order of
+ * @p order_ids.
+ * @param[in] thread_pool  Pool that searches the files. If it is null, a
+ * thread is started for each chunk.
+ * @param[in] order_store  Compiled store of the order files, or nullptr.
+ * Orders contained in it are not searched in the files.
+ * @return Ids of the orders that were not found, without duplicates and in
+ * the order of their first occurrence in @p order_ids.
+ */
+std::vector<uint32_t> parseAllFilesToFindOrders(
+    const std::string &dir_path, const std::vector<uint32_t> &order_ids,
+    std::vector<AMR::OrderInformation> &orders,
+    AMR::ThreadPool *thread_pool = nullptr,
+    const AMR::OrderStore *order_store = nullptr);
 
 }  // namespace AMR
 #endif  //#ifndef INCLUDE_BASIC_ROUTINES_HPP_
\ No newline at end of file
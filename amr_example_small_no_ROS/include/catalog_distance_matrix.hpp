@@ -0,0 +1,168 @@
+/** @file catalog_distance_matrix.hpp
+ * @brief Defines the matrix of distances between all pickup locations of the
+ * catalog, which is computed once when the configuration is parsed.
+ */
+
+#ifndef INCLUDE_CATALOG_DISTANCE_MATRIX_HPP_
+#define INCLUDE_CATALOG_DISTANCE_MATRIX_HPP_
+
+#include <cstddef>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "basic_structs.hpp"
+#include "distance_metrics.hpp"
+
+namespace AMR {
+
+/**
+ * @brief Allocator that aligns memory to cache lines.
+ *
+ * @tparam T  Type of the allocated elements.
+ */
+template <typename T>
+struct CacheAlignedAllocator {
+  static constexpr size_t kAlignment = 64;  //!< Size of a cache line.
+  typedef T value_type;
+  CacheAlignedAllocator() = default;
+  template <typename U>
+  CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+  T* allocate(const size_t n) {
+    // aligned_alloc requires the size to be a multiple of the alignment
+    size_t bytes = (n * sizeof(T) + kAlignment - 1) / kAlignment * kAlignment;
+    void* memory = std::aligned_alloc(kAlignment, bytes);
+    if (!memory) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T*>(memory);
+  }
+  void deallocate(T* pointer, const size_t) { std::free(pointer); }
+  template <typename U>
+  bool operator==(const CacheAlignedAllocator<U>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const CacheAlignedAllocator<U>&) const {
+    return false;
+  }
+};
+
+/**
+ * @brief Distances between all distinct pickup locations of the catalog.
+ *
+ * The matrix is symmetric, so only its lower triangle is stored. By default
+ * it is packed row by row into a single cache-aligned array. If a memory cap
+ * is set and the packed triangle exceeds it, the triangle is split into
+ * square tiles of @ref kTileSize locations. Tiles are computed when they are
+ * first accessed and kept in a direct-mapped tile cache that respects the
+ * cap, so distances between nearby locations (by index) share a tile.
+ *
+ * The distances are computed exactly as by @ref AMR::DistanceMatrix in the
+ * same metric, so using the catalog does not change any path length.
+ */
+class CatalogDistanceMatrix {
+ public:
+  /**
+   * @brief Storage layouts of the matrix.
+   *
+   */
+  enum class Layout {
+    kPacked,  //!< The whole lower triangle, packed row by row.
+    kTiled    //!< Tiles of the lower triangle, computed on demand.
+  };
+
+  static constexpr size_t kTileSize = 64;  //!< Edge length of a tile.
+
+  /**
+   * @brief Construct a new, empty matrix.
+   */
+  CatalogDistanceMatrix()
+      : _layout(Layout::kPacked),
+        _metric(DistanceMetric::kEuclidean),
+        _n_locations(0),
+        _n_tile_slots(0){};
+
+  /**
+   * @brief Computes the distances between the locations of all product
+   * parts. Parts with identical coordinates share a location.
+   *
+   * @param[in] all_product_parts  Vector containing all available parts.
+   * @param[in] memory_cap_bytes  Largest number of bytes used to store the
+   * distances. 0 means that there is no cap and the packed layout is used.
+   * @param[in] metric  Metric in which the distances are measured.
+   */
+  void build(const std::vector<AMR::ProductPart>& all_product_parts,
+             const size_t memory_cap_bytes = 0,
+             const AMR::DistanceMetric metric = DistanceMetric::kEuclidean);
+
+  /**
+   * @brief Get the storage layout chosen by @ref build.
+   *
+   * @return @ref _layout.
+   */
+  Layout getLayout() const { return _layout; }
+
+  /**
+   * @brief Get the metric in which the distances are measured.
+   *
+   * @return @ref _metric.
+   */
+  AMR::DistanceMetric getMetric() const { return _metric; }
+
+  /**
+   * @brief Get the number of distinct pickup locations.
+   *
+   * @return @ref _n_locations.
+   */
+  size_t getNumberOfLocations() const { return _n_locations; }
+
+  /**
+   * @brief Looks up the index of a pickup location.
+   *
+   * @param[in] location  Coordinates of the location.
+   * @return Index of the location, or -1 if it does not belong to the catalog.
+   */
+  int findLocation(const AMR::Coordinates2D& location) const;
+
+  /**
+   * @brief Copies the distances between several locations.
+   *
+   * @param[in] locations  Indices of the locations.
+   * @param[out] distances  Row-major matrix of the distances between the
+   * locations, resized to locations.size()^2 entries.
+   */
+  void getDistances(const std::vector<int>& locations,
+                    std::vector<double>& distances) const;
+
+ private:
+  /**
+   * @brief Distance between the locations @p i and @p j with i > j. The
+   * caller must hold @ref _mutex for the tiled layout.
+   */
+  double lowerTriangleEntry(const size_t i, const size_t j) const;
+
+  Layout _layout;               //!< Layout chosen by @ref build.
+  AMR::DistanceMetric _metric;  //!< Metric of the distances.
+  size_t _n_locations;          //!< Number of distinct pickup locations.
+  std::vector<AMR::Coordinates2D> _locations;  //!< Distinct pickup locations.
+  std::vector<double> _x;  //!< x coordinates of @ref _locations.
+  std::vector<double> _y;  //!< y coordinates of @ref _locations.
+  std::map<std::pair<double, double>, int>
+      _location_index;  //!< Maps coordinates to their location.
+  std::vector<double, CacheAlignedAllocator<double>>
+      _packed;  //!< Packed lower triangle (without the diagonal).
+  size_t _n_tile_slots;  //!< Number of tiles kept in @ref _tiles.
+  mutable std::vector<double, CacheAlignedAllocator<double>>
+      _tiles;  //!< Tile cache, kTileSize^2 distances per slot.
+  mutable std::vector<size_t> _tile_tags;  //!< Tile stored in each slot.
+  mutable std::mutex _mutex;  //!< Mutex to ensure thread safe access of the
+                              //!< tile cache.
+};
+
+}  // namespace AMR
+
+#endif  // INCLUDE_CATALOG_DISTANCE_MATRIX_HPP_
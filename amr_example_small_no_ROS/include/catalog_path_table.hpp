@@ -0,0 +1,138 @@
+/** @file catalog_path_table.hpp
+ * @brief Defines a table of shortest paths between the pickup locations of the
+ * catalog, which answers orders without a search.
+ */
+
+#ifndef INCLUDE_CATALOG_PATH_TABLE_HPP_
+#define INCLUDE_CATALOG_PATH_TABLE_HPP_
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "basic_structs.hpp"
+#include "distance_metrics.hpp"
+#include "thread_pool.hpp"
+
+namespace AMR {
+
+/**
+ * @brief Largest number of distinct pickup locations for which a
+ * @ref AMR::CatalogPathTable can be built.
+ *
+ * The table stores m^2 * 2^(m-1) floats for m locations, i.e. 32 MB for
+ * m = 16 and 800 MB for m = 20.
+ */
+constexpr size_t kCatalogTableMaxLocations = 20;
+
+/**
+ * @brief Shortest paths through all subsets of the pickup locations of the
+ * catalog.
+ *
+ * The part locations are fixed once the configuration is parsed; only the
+ * starting and delivery points differ between orders. For a catalog with m
+ * distinct pickup locations, the table stores for every first location f,
+ * every set S of other locations and every last location l in S the length
+ * of the shortest path that starts at f, visits all locations in S and ends
+ * at l. It is filled by the Held-Karp recurrence once per first location,
+ * in parallel.
+ *
+ * An order visiting the set T of locations is then answered in O(|T|^2) by
+ * minimizing d(start, f) + D[f][T \ {f}][l] + d(l, delivery) over f and l.
+ * The entries are stored as floats to halve the memory, so among paths whose
+ * lengths differ by less than the float precision any one may be chosen.
+ */
+class CatalogPathTable {
+ public:
+  /**
+   * @brief Construct a new, empty table.
+   */
+  CatalogPathTable()
+      : _metric(DistanceMetric::kEuclidean), _n_locations(0), _half(0){};
+
+  /**
+   * @brief Builds the table for the locations of all product parts.
+   *
+   * Parts with identical coordinates share a location. If there are more
+   * than @p max_locations distinct locations, no table is built.
+   *
+   * @param[in] all_product_parts  Vector containing all available parts.
+   * @param[in] max_locations  Largest number of distinct locations for which
+   * the table is built. Values above @ref kCatalogTableMaxLocations are
+   * capped.
+   * @param[in] n_threads  Number of threads used to fill the table. If it is
+   * 0, the size of @p thread_pool or the number of hardware threads is used.
+   * @param[in] metric  Metric in which the distances are measured.
+   * @param[in] thread_pool  Pool that fills the table, or nullptr to start
+   * threads.
+   * @return true The table was built.
+   * @return false  The catalog has too many locations.
+   */
+  bool build(const std::vector<AMR::ProductPart>& all_product_parts,
+             const size_t max_locations = 16, unsigned int n_threads = 0,
+             const AMR::DistanceMetric metric = DistanceMetric::kEuclidean,
+             AMR::ThreadPool* thread_pool = nullptr);
+
+  /**
+   * @brief Checks whether the table was built.
+   *
+   * @return true The table can be used by @ref solve.
+   * @return false  The table is empty.
+   */
+  bool isAvailable() const { return !_table.empty(); }
+
+  /**
+   * @brief Get the number of distinct pickup locations of the catalog.
+   *
+   * @return @ref _n_locations.
+   */
+  size_t getNumberOfLocations() const { return _n_locations; }
+
+  /**
+   * @brief Determines the shortest path of an order by looking it up.
+   *
+   * @param[in] starting_point  Starting point of the path.
+   * @param[in] part_locations  Locations of all parts which have to be
+   * collected. Each must be one of the locations of the catalog.
+   * @param[in] delivery_point  End point of the path.
+   * @param[out] pickup_order  Order in which the parts are picked up.
+   * @param[out] path_length  Length of the path.
+   * @return true The order was solved.
+   * @return false  The table is not available or a location does not belong
+   * to the catalog; the output variables are not changed.
+   */
+  bool solve(const AMR::Coordinates2D& starting_point,
+             const std::vector<Coordinates2D>& part_locations,
+             const AMR::Coordinates2D& delivery_point,
+             std::vector<int>& pickup_order, double& path_length) const;
+
+ private:
+  /**
+   * @brief Position of the entry for the first location @p first, the set
+   * of other locations with the compressed index @p compressed_subset and
+   * the last location @p last.
+   */
+  size_t index(const size_t first, const size_t compressed_subset,
+               const size_t last) const {
+    return (first * _half + compressed_subset) * _n_locations + last;
+  }
+
+  /**
+   * @brief Fills the entries of the first location @p first.
+   */
+  void fillFirstLocation(const size_t first);
+
+  AMR::DistanceMetric _metric;  //!< Metric of the distances.
+  size_t _n_locations;  //!< Number of distinct pickup locations.
+  size_t _half;         //!< Number of subsets of the other locations.
+  std::vector<AMR::Coordinates2D> _locations;  //!< Distinct pickup locations.
+  std::map<std::pair<double, double>, int>
+      _location_index;          //!< Maps coordinates to their location.
+  std::vector<float> _distances;  //!< Row-major distances of the locations.
+  std::vector<float> _table;      //!< Shortest path lengths, see @ref index.
+};
+
+}  // namespace AMR
+
+#endif  // INCLUDE_CATALOG_PATH_TABLE_HPP_
@@ -0,0 +1,195 @@
+/** @file distance_matrix.hpp
+ * @brief Defines the distance matrix of an order, which is used by all path
+ * solvers to evaluate pickup orders.
+ */
+
+#ifndef INCLUDE_DISTANCE_MATRIX_HPP_
+#define INCLUDE_DISTANCE_MATRIX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "basic_structs.hpp"
+#include "distance_metrics.hpp"
+
+namespace AMR {
+// forward declarations
+class CatalogDistanceMatrix;
+class WarehouseGraph;
+
+/**
+ * @brief Instruction sets that can be used to evaluate path lengths.
+ *
+ */
+enum class SimdLevel {
+  kScalar,  //!< Plain C++.
+  kSse2,    //!< Two pickup orders are evaluated at once.
+  kAvx2     //!< Four pickup orders are evaluated at once using gathers.
+};
+
+/**
+ * @brief Determines the best instruction set supported by the CPU.
+ *
+ * The result is determined at run-time, so the same binary can be used on
+ * CPUs with and without AVX2.
+ *
+ * @return Best supported instruction set.
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * @brief Distances between all nodes of the path of an order.
+ *
+ * For an order with n part locations, node 0 is the starting point, node
+ * i + 1 is the part location i and node n + 1 is the delivery point. The
+ * distances are computed once on construction and stored in a row-major
+ * (n+2)x(n+2) matrix.
+ */
+class DistanceMatrix {
+ public:
+  /**
+   * @brief Construct a new distance matrix.
+   *
+   * @param[in] starting_point  Starting point of the path.
+   * @param[in] part_locations  Locations of all parts which have to be
+   * collected.
+   * @param[in] delivery_point  End point of the path.
+   * @param[in] metric  Metric in which the distances are measured.
+   */
+  DistanceMatrix(const AMR::Coordinates2D& starting_point,
+                 const std::vector<Coordinates2D>& part_locations,
+                 const AMR::Coordinates2D& delivery_point,
+                 const AMR::DistanceMetric metric = DistanceMetric::kEuclidean);
+
+  /**
+   * @brief Construct a new distance matrix, taking the distances between the
+   * part locations from the precomputed distances of the catalog.
+   *
+   * Only the rows of the starting point and the delivery point are computed,
+   * in the metric of the catalog. If a part location does not belong to the
+   * catalog, all distances are computed.
+   *
+   * @param[in] starting_point  Starting point of the path.
+   * @param[in] part_locations  Locations of all parts which have to be
+   * collected.
+   * @param[in] delivery_point  End point of the path.
+   * @param[in] catalog_distances  Distances between the locations of the
+   * catalog.
+   */
+  DistanceMatrix(const AMR::Coordinates2D& starting_point,
+                 const std::vector<Coordinates2D>& part_locations,
+                 const AMR::Coordinates2D& delivery_point,
+                 const AMR::CatalogDistanceMatrix& catalog_distances);
+
+  /**
+   * @brief Construct a new distance matrix using the travel distances through
+   * the aisles of the warehouse.
+   *
+   * @param[in] starting_point  Starting point of the path.
+   * @param[in] part_locations  Locations of all parts which have to be
+   * collected.
+   * @param[in] delivery_point  End point of the path.
+   * @param[in] warehouse_graph  Graph of the aisles.
+   */
+  DistanceMatrix(const AMR::Coordinates2D& starting_point,
+                 const std::vector<Coordinates2D>& part_locations,
+                 const AMR::Coordinates2D& delivery_point,
+                 const AMR::WarehouseGraph& warehouse_graph);
+
+  /**
+   * @brief Get the number of part locations.
+   *
+   * @return @ref _n_parts.
+   */
+  size_t getNumberOfParts() const { return _n_parts; }
+
+  /**
+   * @brief Get the number of nodes, i.e. the number of part locations plus 2.
+   *
+   * @return @ref _n_nodes.
+   */
+  size_t getNumberOfNodes() const { return _n_nodes; }
+
+  /**
+   * @brief Get the node of the delivery point.
+   *
+   * @return Index of the delivery point.
+   */
+  size_t getDeliveryNode() const { return _n_nodes - 1; }
+
+  /**
+   * @brief Get the distance between two nodes.
+   *
+   * @param[in] from  First node.
+   * @param[in] to  Second node.
+   * @return Distance between the nodes.
+   */
+  double operator()(const size_t from, const size_t to) const {
+    return _distances[from * _n_nodes + to];
+  }
+
+  /**
+   * @brief Get the distances from a node to all nodes.
+   *
+   * @param[in] from  Node whose distances are wanted.
+   * @return Pointer to the row of the node.
+   */
+  const double* getRow(const size_t from) const {
+    return &_distances[from * _n_nodes];
+  }
+
+  /**
+   * @brief Determines the length of the path of a single pickup order.
+   *
+   * @param[in] pickup_order  Array of n pairwise different part indices in
+   * {0, ..., n-1}.
+   * @return Length of the path.
+   */
+  double determinePathLength(const int* pickup_order) const;
+
+  /**
+   * @brief Determines the path lengths of several pickup orders at once.
+   *
+   * The instruction set returned by @ref AMR::detectSimdLevel is used.
+   *
+   * @param[in] pickup_orders  Array of @p n_orders pickup orders of n part
+   * indices each, stored one after the other.
+   * @param[in] n_orders  Number of pickup orders.
+   * @param[out] path_lengths  Array of @p n_orders path lengths.
+   */
+  void evaluatePathLengths(const int32_t* pickup_orders, const size_t n_orders,
+                           double* path_lengths) const;
+
+  /**
+   * @brief Determines the path lengths of several pickup orders at once using
+   * a given instruction set.
+   *
+   * @param[in] pickup_orders  Array of @p n_orders pickup orders of n part
+   * indices each, stored one after the other.
+   * @param[in] n_orders  Number of pickup orders.
+   * @param[out] path_lengths  Array of @p n_orders path lengths.
+   * @param[in] simd_level  Instruction set to use. It must be supported by
+   * the CPU.
+   */
+  void evaluatePathLengths(const int32_t* pickup_orders, const size_t n_orders,
+                           double* path_lengths,
+                           const SimdLevel simd_level) const;
+
+ private:
+  /**
+   * @brief Computes the distances from the nodes in [begin, end) to all
+   * nodes with a higher index.
+   */
+  void computeDistances(const std::vector<const AMR::Coordinates2D*>& nodes,
+                        const size_t begin, const size_t end,
+                        const AMR::DistanceMetric metric);
+
+  size_t _n_parts;                  //!< Number of part locations.
+  size_t _n_nodes;                  //!< Number of nodes.
+  std::vector<double> _distances;  //!< Row-major distance matrix.
+};
+
+}  // namespace AMR
+
+#endif  // INCLUDE_DISTANCE_MATRIX_HPP_
@@ -0,0 +1,162 @@
+/** @file distance_metrics.hpp
+ * @brief Defines the metrics in which the distance between two points can be
+ * measured.
+ *
+ * Every metric is a policy class with a static member function
+ * distance(x_diff, y_diff). Code that is templated on a policy has no
+ * run-time dispatch in its inner loops; the run-time selection of
+ * @ref AMR::DistanceMetric is resolved once per call by
+ * @ref AMR::dispatchMetric.
+ */
+
+#ifndef INCLUDE_DISTANCE_METRICS_HPP_
+#define INCLUDE_DISTANCE_METRICS_HPP_
+
+#include <math.h>
+
+#include <cstddef>
+#include <string>
+
+#include "basic_structs.hpp"
+
+namespace AMR {
+
+/**
+ * @brief Metrics that can be selected for a deployment.
+ *
+ */
+enum class DistanceMetric {
+  kEuclidean,         //!< @ref AMR::EuclideanMetric
+  kSquaredEuclidean,  //!< @ref AMR::SquaredEuclideanMetric
+  kManhattan,         //!< @ref AMR::ManhattanMetric
+  kChebyshev          //!< @ref AMR::ChebyshevMetric
+};
+
+/**
+ * @brief Straight-line distance, for units that can drive in any direction.
+ */
+struct EuclideanMetric {
+  static constexpr DistanceMetric kMetric = DistanceMetric::kEuclidean;
+  static double distance(const double x_diff, const double y_diff) {
+    return sqrt(x_diff * x_diff + y_diff * y_diff);
+  }
+};
+
+/**
+ * @brief Squared straight-line distance.
+ *
+ * It avoids the square root, but a path length is then the sum of the
+ * squared leg lengths, which favors many short legs over a few long ones.
+ * It is meant for ranking candidates, not for reporting travel distances.
+ */
+struct SquaredEuclideanMetric {
+  static constexpr DistanceMetric kMetric = DistanceMetric::kSquaredEuclidean;
+  static double distance(const double x_diff, const double y_diff) {
+    return x_diff * x_diff + y_diff * y_diff;
+  }
+};
+
+/**
+ * @brief Rectilinear distance, for units that only drive along the axes.
+ */
+struct ManhattanMetric {
+  static constexpr DistanceMetric kMetric = DistanceMetric::kManhattan;
+  static double distance(const double x_diff, const double y_diff) {
+    return fabs(x_diff) + fabs(y_diff);
+  }
+};
+
+/**
+ * @brief Largest coordinate difference, for units whose axes are driven
+ * independently at the same speed.
+ */
+struct ChebyshevMetric {
+  static constexpr DistanceMetric kMetric = DistanceMetric::kChebyshev;
+  static double distance(const double x_diff, const double y_diff) {
+    const double x_abs = fabs(x_diff);
+    const double y_abs = fabs(y_diff);
+    return x_abs > y_abs ? x_abs : y_abs;
+  }
+};
+
+/**
+ * @brief Calls a function with the policy class of a metric.
+ *
+ * @param[in] metric  Selected metric.
+ * @param[in] function  Callable that accepts any policy object, e.g. a
+ * generic lambda.
+ * @return The result of @p function.
+ */
+template <typename Function>
+auto dispatchMetric(const DistanceMetric metric, Function&& function) {
+  switch (metric) {
+    case DistanceMetric::kSquaredEuclidean:
+      return function(SquaredEuclideanMetric());
+    case DistanceMetric::kManhattan:
+      return function(ManhattanMetric());
+    case DistanceMetric::kChebyshev:
+      return function(ChebyshevMetric());
+    default:
+      return function(EuclideanMetric());
+  }
+}
+
+/**
+ * @brief Distance between two points in a metric known at compile time.
+ *
+ * @tparam Metric  Policy class of the metric.
+ * @param[in] from  First point.
+ * @param[in] to  Second point.
+ * @return Distance between the points.
+ */
+template <typename Metric>
+double computeDistance(const AMR::Coordinates2D& from,
+                       const AMR::Coordinates2D& to) {
+  return Metric::distance(to._x - from._x, to._y - from._y);
+}
+
+/**
+ * @brief Distance between two points in a metric selected at run-time.
+ *
+ * @param[in] metric  Selected metric.
+ * @param[in] from  First point.
+ * @param[in] to  Second point.
+ * @return Distance between the points.
+ */
+double computeDistance(const DistanceMetric metric,
+                       const AMR::Coordinates2D& from,
+                       const AMR::Coordinates2D& to);
+
+/**
+ * @brief Computes the distances from a point to several points at once.
+ *
+ * The best instruction set returned by @ref AMR::detectSimdLevel is used.
+ * All instruction sets produce bitwise identical results, which are also
+ * identical to @ref AMR::computeDistance.
+ *
+ * @param[in] metric  Selected metric.
+ * @param[in] from  Point from which the distances are measured.
+ * @param[in] x  Array of the x coordinates of @p n points.
+ * @param[in] y  Array of the y coordinates of @p n points.
+ * @param[in] n  Number of points.
+ * @param[out] distances  Array of @p n distances.
+ */
+void computeDistanceRow(const DistanceMetric metric,
+                        const AMR::Coordinates2D& from, const double* x,
+                        const double* y, const size_t n, double* distances);
+
+/**
+ * @brief Converts the name of a metric, as used in the settings file, into
+ * the metric.
+ *
+ * @param[in] name  One of "euclidean", "squared_euclidean", "manhattan" and
+ * "chebyshev".
+ * @param[out] metric  The metric, unchanged if the name is unknown.
+ * @return true The name is known.
+ * @return false  The name is unknown.
+ */
+bool parseDistanceMetric(const std::string& name, DistanceMetric& metric);
+
+}  // namespace AMR
+
+#endif  // INCLUDE_DISTANCE_METRICS_HPP_
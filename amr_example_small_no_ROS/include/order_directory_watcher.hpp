@@ -0,0 +1,100 @@
+/** @file order_directory_watcher.hpp
+ * @brief Defines the watcher that keeps the order index up to date while new
+ * order files are published.
+ */
+
+#ifndef INCLUDE_ORDER_DIRECTORY_WATCHER_HPP_
+#define INCLUDE_ORDER_DIRECTORY_WATCHER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+
+#include "order_file_filters.hpp"
+#include "order_index.hpp"
+
+namespace AMR {
+
+/**
+ * @brief Watches the directory of the order files with inotify and updates an
+ * @ref AMR::OrderIndex, and optionally the @ref AMR::OrderFileFilters,
+ * whenever an order file is created, appended to, replaced or removed.
+ *
+ * The events are handled by a thread of the watcher. Events that arrive
+ * together are collected, so every changed file is indexed once. If the
+ * kernel dropped events, the whole index is refreshed. On systems without
+ * inotify, @ref start fails and the index is only built when the unit starts.
+ */
+class OrderDirectoryWatcher {
+ public:
+  /**
+   * @brief Construct a new, stopped watcher.
+   */
+  OrderDirectoryWatcher()
+      : _inotify_descriptor(-1),
+        _stop_descriptors{-1, -1},
+        _n_updates(0){};
+
+  OrderDirectoryWatcher(const OrderDirectoryWatcher&) = delete;
+  OrderDirectoryWatcher& operator=(const OrderDirectoryWatcher&) = delete;
+
+  /**
+   * @brief Destroy the watcher after stopping it.
+   */
+  ~OrderDirectoryWatcher() { stop(); }
+
+  /**
+   * @brief Starts watching a directory. A running watcher is stopped first.
+   *
+   * @param[in] dir_path  Path to the directory containing the order files.
+   * It has to be the directory for which @p order_index was built.
+   * @param[in,out] order_index  Index that is updated. It has to outlive the
+   * watcher or the next call of @ref stop.
+   * @param[in,out] order_file_filters  Filters of the order files that are
+   * updated as well, or nullptr. They have to be built for @p dir_path and
+   * outlive the watcher like @p order_index.
+   * @return true The directory is watched.
+   * @return false  The directory could not be watched.
+   */
+  bool start(const std::string& dir_path, AMR::OrderIndex& order_index,
+             AMR::OrderFileFilters* order_file_filters = nullptr);
+
+  /**
+   * @brief Stops watching and waits for the thread of the watcher.
+   */
+  void stop();
+
+  /**
+   * @brief Checks whether a directory is watched.
+   *
+   * @return true @ref start succeeded.
+   * @return false  The watcher is stopped.
+   */
+  bool isRunning() const { return _thread.joinable(); }
+
+  /**
+   * @brief Get the number of updates of the index, e.g. to wait for a change
+   * in tests.
+   *
+   * @return Number of changed files and refreshes since the watcher started.
+   */
+  size_t getNumberOfUpdates() const { return _n_updates; }
+
+ private:
+  /**
+   * @brief Main loop of the thread, which waits for events until @ref stop
+   * is called.
+   */
+  void watchLoop(const std::string dir_path, AMR::OrderIndex* order_index,
+                 AMR::OrderFileFilters* order_file_filters);
+
+  int _inotify_descriptor;    //!< Inotify instance, or -1.
+  int _stop_descriptors[2];   //!< Pipe whose write end wakes the thread.
+  std::thread _thread;        //!< Thread handling the events.
+  std::atomic<size_t> _n_updates;  //!< Number of updates of the index.
+};
+
+}  // namespace AMR
+
+#endif  // INCLUDE_ORDER_DIRECTORY_WATCHER_HPP_
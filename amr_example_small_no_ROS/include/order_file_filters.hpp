@@ -0,0 +1,149 @@
+/** @file order_file_filters.hpp
+ * @brief Defines the summaries of the order ids contained in the order
+ * files, which allow skipping files that cannot contain an order.
+ */
+
+#ifndef INCLUDE_ORDER_FILE_FILTERS_HPP_
+#define INCLUDE_ORDER_FILE_FILTERS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace AMR {
+
+/**
+ * @brief Summary of a set of order ids: their range and a Bloom filter.
+ *
+ * @ref mayContain never fails for a contained id. For other ids within the
+ * range, it fails with a probability of about 1%.
+ */
+class OrderIdFilter {
+ public:
+  /**
+   * @brief Construct a new filter of the empty set.
+   */
+  OrderIdFilter() : _min_id(1), _max_id(0){};
+
+  /**
+   * @brief Construct a new filter of a set of order ids.
+   *
+   * @param[in] order_ids  Order ids; they may contain duplicates.
+   */
+  explicit OrderIdFilter(const std::vector<uint32_t>& order_ids);
+
+  /**
+   * @brief Checks whether an order id may be contained in the set.
+   *
+   * @param[in] order_id  Id of the order.
+   * @return true The id is probably contained.
+   * @return false  The id is certainly not contained.
+   */
+  bool mayContain(const uint32_t order_id) const;
+
+  /**
+   * @brief Get the smallest id of the set.
+   *
+   * @return Smallest id. It is larger than @ref getMaxId if the set is empty.
+   */
+  uint32_t getMinId() const { return _min_id; }
+
+  /**
+   * @brief Get the largest id of the set.
+   *
+   * @return Largest id.
+   */
+  uint32_t getMaxId() const { return _max_id; }
+
+ private:
+  //! Number of bits of the Bloom filter per id.
+  static constexpr size_t kBitsPerId = 10;
+  //! Number of bits set per id.
+  static constexpr size_t kNumberOfHashes = 7;
+
+  uint32_t _min_id;             //!< Smallest id of the set.
+  uint32_t _max_id;             //!< Largest id of the set.
+  std::vector<uint64_t> _bits;  //!< Bits of the Bloom filter.
+};
+
+/**
+ * @brief Filters of the order ids of all order files of a directory.
+ *
+ * A file that changed after its filter was built, and a file without a
+ * filter, may contain any id. Filters are refreshed by @ref updateFile, e.g.
+ * by an @ref AMR::OrderDirectoryWatcher. All member functions are
+ * thread-safe.
+ */
+class OrderFileFilters {
+ public:
+  /**
+   * @brief Builds the filters of all order files of a directory.
+   *
+   * @param[in] dir_path  Path to the directory containing the order files.
+   * @return Number of files with a filter.
+   */
+  size_t build(const std::string& dir_path);
+
+  /**
+   * @brief Builds the filter of a single file of the directory passed to
+   * @ref build again, or removes it if the file no longer exists.
+   *
+   * @param[in] file_name  Name of the file, relative to the directory.
+   * @return true The filters changed.
+   * @return false  The file is unchanged or could not be read.
+   */
+  bool updateFile(const std::string& file_name);
+
+  /**
+   * @brief Selects the order files that may contain an order.
+   *
+   * @param[in] file_paths  Paths of order files, e.g. by
+   * @ref AMR::listOrderFiles.
+   * @param[in] order_id  Id of the order.
+   * @return The paths of @p file_paths that may contain the order, in the
+   * same order.
+   */
+  std::vector<std::string> selectFiles(
+      const std::vector<std::string>& file_paths,
+      const uint32_t order_id) const;
+
+  /**
+   * @brief Get the number of files with a filter.
+   *
+   * @return Number of files.
+   */
+  size_t getNumberOfFiles() const {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _files.size();
+  }
+
+ private:
+  /**
+   * @brief Filter of an order file.
+   */
+  struct FilteredFile {
+    uint64_t _size;          //!< Size in bytes when the filter was built.
+    int64_t _mtime;          //!< Modification time when the filter was built.
+    OrderIdFilter _filter;   //!< Filter of the ids of the file.
+  };
+
+  /**
+   * @brief Reads the ids of an order file and builds its filter.
+   *
+   * @return true The file was read.
+   * @return false  The file could not be read.
+   */
+  static bool filterFile(const std::string& file_path, FilteredFile& file);
+
+  mutable std::shared_mutex _mutex;  //!< Protects all other members.
+  std::string _dir_path;  //!< Directory containing the order files.
+  std::map<std::string, FilteredFile>
+      _files;  //!< Filter of every file, by file name.
+};
+
+}  // namespace AMR
+
+#endif  // INCLUDE_ORDER_FILE_FILTERS_HPP_
@@ -0,0 +1,352 @@
+/** @file order_file_scanner.hpp
+ * @brief Defines a read-only memory mapping of a file and a scanner for order
+ * files that does not build a yaml document.
+ *
+ * The scanner only understands the layout in which the order files are
+ * written:
+ * @code
+ * - order: 1000001
+ *   cx: 748.944
+ *   cy: 474.71707
+ *   products:
+ *   - 902
+ * @endcode
+ * Records of other orders are skipped by searching for the next line that
+ * starts with "- ". Files or records in any other layout are rejected, so
+ * that the caller can fall back to yaml-cpp.
+ */
+
+#ifndef INCLUDE_ORDER_FILE_SCANNER_HPP_
+#define INCLUDE_ORDER_FILE_SCANNER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "basic_structs.hpp"
+
+namespace AMR {
+
+/**
+ * @brief Read-only memory mapping of a whole file. The mapping is removed
+ * when the object is destroyed.
+ */
+class MappedFile {
+ public:
+  /**
+   * @brief Construct a new, unmapped object.
+   */
+  MappedFile() : _data(nullptr), _size(0), _is_open(false){};
+
+  /**
+   * @brief Construct a new object and map a file.
+   *
+   * @param[in] file_path  Path of the file.
+   */
+  explicit MappedFile(const std::string& file_path) : MappedFile() {
+    open(file_path);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * @brief Destroy the object and remove the mapping.
+   */
+  ~MappedFile() { close(); }
+
+  /**
+   * @brief Maps a file, replacing the current mapping.
+   *
+   * @param[in] file_path  Path of the file.
+   * @param[in] sequential  Whether the file is read from the start to the
+   * end, so the kernel reads ahead. Otherwise it is accessed at random.
+   * @return true The file is mapped. Empty files are not mapped, but are
+   * valid with @ref size 0.
+   * @return false  The file could not be opened or mapped.
+   */
+  bool open(const std::string& file_path, const bool sequential = true);
+
+  /**
+   * @brief Removes the mapping.
+   */
+  void close();
+
+  /**
+   * @brief Checks whether a file is mapped.
+   *
+   * @return true @ref open succeeded.
+   * @return false  No file is mapped.
+   */
+  bool isOpen() const { return _is_open; }
+
+  /**
+   * @brief Get the content of the file.
+   *
+   * @return Pointer to the first of @ref size bytes.
+   */
+  const char* data() const { return _data; }
+
+  /**
+   * @brief Get the size of the file.
+   *
+   * @return Size in bytes.
+   */
+  size_t size() const { return _size; }
+
+ private:
+  const char* _data;  //!< Start of the mapping.
+  size_t _size;       //!< Size of the file in bytes.
+  bool _is_open;      //!< Whether a file is mapped.
+};
+
+/**
+ * @brief Result of scanning an order file or record.
+ */
+enum class ScanResult {
+  kFound,     //!< The order was found.
+  kNotFound,  //!< The order is not contained in the scanned text.
+  kRejected,  //!< The text is not in the layout known by the scanner.
+  kStopped    //!< The scan was stopped by an @ref AMR::OrderSearchToken.
+};
+
+/**
+ * @brief Information about an order, as result of a lookup of several
+ * orders.
+ */
+struct OrderInformation {
+  bool _found = false;                 //!< Whether the order was found.
+  AMR::Coordinates2D _delivery_point;  //!< Delivery point of the order.
+  std::vector<long long int>
+      _ordered_products;  //!< Products of the order.
+};
+
+/**
+ * @brief State shared by the scanners of several files that search for the
+ * same order.
+ *
+ * The files are numbered by precedence. If an order id occurs in several
+ * files, the file with the smallest number wins. Once a file reports a hit,
+ * the scanners of all files with larger numbers stop at their next record,
+ * while the files with smaller numbers are still searched to the end.
+ */
+class OrderSearchToken {
+ public:
+  /**
+   * @brief Construct a new token.
+   *
+   * @param[in] n_files  Number of searched files.
+   */
+  explicit OrderSearchToken(const size_t n_files) : _first_hit(n_files){};
+
+  /**
+   * @brief Checks whether the search of a file can be stopped, since a file
+   * with higher precedence contains the order.
+   *
+   * @param[in] file  Number of the file.
+   * @return true A file with a smaller number contains the order.
+   * @return false  The file still has to be searched.
+   */
+  bool isStopped(const size_t file) const {
+    return _first_hit.load(std::memory_order_relaxed) < file;
+  }
+
+  /**
+   * @brief Reports that a file contains the order.
+   *
+   * @param[in] file  Number of the file.
+   */
+  void reportHit(const size_t file) {
+    size_t first_hit = _first_hit.load(std::memory_order_relaxed);
+    while (file < first_hit &&
+           !_first_hit.compare_exchange_weak(first_hit, file,
+                                             std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * @brief Get the file that wins.
+   *
+   * @return Smallest number of a file that reported a hit, or the number of
+   * files if there was none.
+   */
+  size_t getFirstHit() const {
+    return _first_hit.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<size_t> _first_hit;  //!< Smallest file with a hit.
+};
+
+/**
+ * @brief Reads the size and modification time of a file, which identify the
+ * version of an order file.
+ *
+ * @param[in] file_path  Path of the file.
+ * @param[out] size  Size in bytes.
+ * @param[out] mtime  Modification time, in the ticks of the file system
+ * clock.
+ * @return true The file exists.
+ * @return false  The file could not be accessed.
+ */
+bool getFileStatus(const std::string& file_path, uint64_t& size,
+                   int64_t& mtime);
+
+/**
+ * @brief Checks whether the text in front of the first record of an order
+ * file only consists of blank lines, comments and a document start marker.
+ *
+ * @param[in] begin  Start of the file.
+ * @param[in] end  Start of the first record.
+ * @return true The text can be skipped.
+ * @return false  The file has a layout the scanner does not know.
+ */
+bool isPreamble(const char* begin, const char* end);
+
+/**
+ * @brief Finds the next record, i.e. the next line that starts with "- ".
+ *
+ * @param[in] from  Start of a line.
+ * @param[in] end  End of the text.
+ * @return Start of the record, or @p end if there is none.
+ */
+const char* findNextRecord(const char* from, const char* end);
+
+//! Size in bytes below which an order file is not split any further.
+constexpr size_t kMinimumChunkSize = size_t(1) << 20;
+
+/**
+ * @brief Splits the content of an order file into chunks that can be scanned
+ * independently. Every chunk but the first starts at a record.
+ *
+ * @param[in] data  Content of the file.
+ * @param[in] size  Size of the content in bytes.
+ * @param[in] max_chunks  Maximum number of chunks, e.g. the number of
+ * threads.
+ * @param[in] min_chunk_size  Approximate minimum size of a chunk in bytes.
+ * @return Offsets of the starts of the chunks, ascending and starting with
+ * 0. Chunk i ends at the start of chunk i + 1, the last one at @p size.
+ */
+std::vector<size_t> splitOrderFile(
+    const char* data, const size_t size, const size_t max_chunks,
+    const size_t min_chunk_size = kMinimumChunkSize);
+
+/**
+ * @brief Part of a mapped order file that is scanned by its own task.
+ */
+struct OrderFileChunk {
+  size_t _file;   //!< Index of the file.
+  size_t _begin;  //!< Offset of the first byte of the chunk.
+  size_t _end;    //!< Offset past the last byte of the chunk.
+};
+
+/**
+ * @brief Maps order files and splits each of them with
+ * @ref splitOrderFile, so that a large file is scanned by several threads.
+ *
+ * @param[in] file_paths  Paths of the files.
+ * @param[in] max_chunks  Maximum number of chunks per file, e.g. the number
+ * of threads.
+ * @param[in,out] mapped_files  Closed files, one per path, that are mapped.
+ * Files that cannot be read stay closed and have no chunks.
+ * @return Chunks in the order of the files and of their content.
+ */
+std::vector<OrderFileChunk> splitOrderFiles(
+    const std::vector<std::string>& file_paths, const size_t max_chunks,
+    std::vector<MappedFile>& mapped_files);
+
+/**
+ * @brief Reads the id of the order from the first line of a record.
+ *
+ * @param[in] record  Start of the record.
+ * @param[in] end  End of the text.
+ * @param[out] order_id  Id of the order.
+ * @return true The first line is "- order: <id>".
+ * @return false  The record has another layout.
+ */
+bool parseRecordOrderId(const char* record, const char* end,
+                        uint32_t& order_id);
+
+/**
+ * @brief Reads a whole record.
+ *
+ * @param[in] record  Start of the record.
+ * @param[in] end  End of the text. The record ends at the next record or at
+ * @p end.
+ * @param[out] order_id  Id of the order.
+ * @param[out] delivery_point Delivery point of the order.
+ * @param[out] ordered_products Products of the order; they are appended.
+ * @return ScanResult::kFound if the record was read, ScanResult::kRejected
+ * otherwise. The output variables are only changed in the first case.
+ */
+ScanResult parseOrderRecord(const char* record, const char* end,
+                            uint32_t& order_id,
+                            AMR::Coordinates2D& delivery_point,
+                            std::vector<long long int>& ordered_products);
+
+/**
+ * @brief Searches the content of an order file for an order.
+ *
+ * Only the first line of the records of other orders is read. If the same
+ * order id occurs more than once, the first record is used.
+ *
+ * @param[in] data  Content of the file.
+ * @param[in] size  Size of the content in bytes.
+ * @param[in] order_id  Id of the order whose information is wanted.
+ * @param[in,out] delivery_point Delivery point of the order.
+ * @param[in,out] ordered_products Products of the order.
+ * @param[in,out] token  State shared with the scanners of other files, or
+ * nullptr. It is checked between two records, and a hit is reported to it.
+ * @param[in] file  Number of the file for @p token.
+ * @return ScanResult::kFound or ScanResult::kNotFound,
+ * ScanResult::kRejected if the file has a layout the scanner does not know,
+ * or ScanResult::kStopped if a file with higher precedence contains the
+ * order. The output variables are only changed if the order is found.
+ */
+ScanResult scanOrderFile(const char* data, const size_t size,
+                         const uint32_t order_id,
+                         AMR::Coordinates2D& delivery_point,
+                         std::vector<long long int>& ordered_products,
+                         AMR::OrderSearchToken* token = nullptr,
+                         const size_t file = 0);
+
+/**
+ * @brief Reads the ids of all orders in the content of an order file.
+ *
+ * @param[in] data  Content of the file.
+ * @param[in] size  Size of the content in bytes.
+ * @param[out] order_ids  Ids of the orders, in the order of the file; they
+ * are appended.
+ * @return true The ids were read.
+ * @return false  The file has a layout the scanner does not know. In this
+ * case, @p order_ids may be partially set.
+ */
+bool scanOrderIds(const char* data, const size_t size,
+                  std::vector<uint32_t>& order_ids);
+
+/**
+ * @brief Searches the content of an order file for several orders in a
+ * single pass.
+ *
+ * If the same order id occurs more than once, the first record is used.
+ *
+ * @param[in] data  Content of the file.
+ * @param[in] size  Size of the content in bytes.
+ * @param[in] slots  Index in @p orders of every wanted order id.
+ * @param[in,out] orders  Information about the orders. Orders that are
+ * found are set; orders that are already marked as found are skipped.
+ * @return ScanResult::kFound if at least one order was found,
+ * ScanResult::kNotFound if none was found, or ScanResult::kRejected if the
+ * file has a layout the scanner does not know. In the last case, @p orders
+ * may be partially set.
+ */
+ScanResult scanOrderFile(const char* data, const size_t size,
+                         const std::unordered_map<uint32_t, size_t>& slots,
+                         std::vector<AMR::OrderInformation>& orders);
+
+}  // namespace AMR
+
+#endif  // INCLUDE_ORDER_FILE_SCANNER_HPP_
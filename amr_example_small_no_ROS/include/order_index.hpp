@@ -0,0 +1,256 @@
+/** @file order_index.hpp
+ * @brief Defines the index that maps order ids to their records in the order
+ * files, so that an order is found without parsing all files.
+ */
+
+#ifndef INCLUDE_ORDER_INDEX_HPP_
+#define INCLUDE_ORDER_INDEX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "basic_structs.hpp"
+#include "order_file_scanner.hpp"
+#include "thread_pool.hpp"
+
+namespace AMR {
+
+/**
+ * @brief Position of the record of an order in the order files.
+ *
+ */
+struct OrderRecord {
+  /**
+   * @brief Construct a new record.
+   *
+   * @param[in] file  Index of the file in the list of indexed files.
+   * @param[in] offset  Byte offset of the record in the file.
+   * @param[in] length  Length of the record in bytes.
+   */
+  OrderRecord(const uint32_t file = 0, const uint64_t offset = 0,
+              const uint64_t length = 0)
+      : _file(file), _offset(offset), _length(length){};
+  uint32_t _file;    //!< Index of the file in the list of indexed files.
+  uint64_t _offset;  //!< Byte offset of the record in the file.
+  uint64_t _length;  //!< Length of the record in bytes.
+};
+
+/**
+ * @brief Index of all orders in the order files of a directory.
+ *
+ * A record is a top-level entry of the yaml sequence of an order file, i.e.
+ * it starts with a line beginning with "- ". The index maps every order id
+ * to the file, byte offset and length of its record, so a lookup reads and
+ * parses a single record.
+ *
+ * The index can be persisted next to the order files. Each file is stored
+ * with its size and modification time, and only files for which these
+ * changed are scanned again. If an order id occurs more than once, the
+ * first record in the sorted order of the file names is used.
+ *
+ * Single files can be indexed again while the index is used, e.g. by an
+ * @ref AMR::OrderDirectoryWatcher. All member functions are thread-safe.
+ */
+class OrderIndex {
+ public:
+  /**
+   * @brief Result of a lookup.
+   *
+   */
+  enum class Status {
+    kFound,     //!< The order was found.
+    kNotFound,  //!< The order is not contained in the indexed files.
+    kOutdated   //!< The file of the order changed after it was indexed.
+  };
+
+  /**
+   * @brief Construct a new, empty index.
+   */
+  OrderIndex() : _built(false), _thread_pool(nullptr){};
+
+  /**
+   * @brief Indexes all order files of a directory.
+   *
+   * @param[in] dir_path  Path to the directory containing the order files.
+   * @param[in] index_path  Path of the persisted index. If it is not empty,
+   * the unchanged files are taken from it and the new index is written to
+   * it.
+   * @param[in] thread_pool  Pool that scans the files, or nullptr. Large
+   * files are split into chunks at record boundaries that are scanned in
+   * parallel. The pool is also used by @ref refresh and has to outlive the
+   * index.
+   * @return Number of files that had to be scanned.
+   */
+  size_t build(const std::string& dir_path, const std::string& index_path,
+               AMR::ThreadPool* thread_pool = nullptr);
+
+  /**
+   * @brief Checks whether the index was built.
+   *
+   * @return true @ref build was called.
+   * @return false  The index is empty.
+   */
+  bool isBuilt() const {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _built;
+  }
+
+  /**
+   * @brief Get the number of indexed orders.
+   *
+   * @return Number of distinct order ids.
+   */
+  size_t size() const {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _records.size();
+  }
+
+  /**
+   * @brief Get the number of indexed files.
+   *
+   * @return Number of files.
+   */
+  size_t getNumberOfFiles() const {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _files.size();
+  }
+
+  /**
+   * @brief Indexes the changes of a single file of the directory passed to
+   * @ref build, and persists the index if a path was given.
+   *
+   * New files are scanned completely. If a file only grew and its last
+   * record is unchanged, only the appended part is scanned, starting at the
+   * last record, since it might have been incomplete. Otherwise the file is
+   * scanned again. Files that no longer exist are removed from the index.
+   * The file is scanned without holding the lock of the index, new and
+   * rewritten files in chunks on the pool passed to @ref build.
+   *
+   * @param[in] file_name  Name of the file, relative to the directory.
+   * @return true The index changed.
+   * @return false  The file is unchanged or could not be read.
+   */
+  bool updateFile(const std::string& file_name);
+
+  /**
+   * @brief Builds the index again for the same directory and index path,
+   * scanning only the files that changed.
+   *
+   * @return Number of files that had to be scanned.
+   */
+  size_t refresh();
+
+  /**
+   * @brief Looks up the record of an order.
+   *
+   * @param[in] order_id  Id of the order.
+   * @param[out] record  Position of the record, if the order is indexed.
+   * @return true The order is indexed.
+   * @return false  The order is not indexed.
+   */
+  bool find(const uint32_t order_id, AMR::OrderRecord& record) const;
+
+  /**
+   * @brief Reads the information about an order from its record.
+   *
+   * The output variables are set as by @ref AMR::parseAllFilesToFindOrder,
+   * and are not changed unless the order is found.
+   *
+   * @param[in] order_id  Id of the order whose information is wanted.
+   * @param[in,out] delivery_point Delivery point of the order.
+   * @param[in,out] ordered_products Products of the order.
+   * @return Whether the order was found, or whether its file changed since
+   * it was indexed, in which case the index has to be rebuilt.
+   */
+  Status lookup(const uint32_t order_id, AMR::Coordinates2D& delivery_point,
+                std::vector<long long int>& ordered_products) const;
+
+  /**
+   * @brief Reads the information about several orders in one pass over the
+   * index. Every file is mapped once, and its records are read in the order
+   * of their offsets.
+   *
+   * @param[in] order_ids  Ids of the orders whose information is wanted.
+   * @param[out] orders  Information about the orders, in the order of
+   * @p order_ids.
+   * @return Result of the lookup of every order, in the order of
+   * @p order_ids.
+   */
+  std::vector<Status> lookup(const std::vector<uint32_t>& order_ids,
+                             std::vector<AMR::OrderInformation>& orders) const;
+
+ private:
+  //! Records of an order file, in file order.
+  using Records = std::vector<std::pair<uint32_t, OrderRecord>>;
+
+  /**
+   * @brief An indexed order file.
+   */
+  struct IndexedFile {
+    std::string _name;     //!< File name, relative to the directory.
+    uint64_t _size;        //!< Size in bytes when the file was indexed.
+    int64_t _mtime;        //!< Modification time when the file was indexed.
+    Records _records;  //!< Order ids and records of the file, in file order.
+  };
+
+  /**
+   * @brief Appends the records of the content of an order file that start
+   * at or after @p offset, which has to be the start of a line.
+   */
+  static void scanRecords(const char* begin, const char* end,
+                          const uint64_t offset, Records& records);
+
+  /**
+   * @brief Maps and scans whole order files and sets their sizes. The files
+   * are split into chunks that are scanned in parallel.
+   *
+   * @return Whether each file was read.
+   */
+  static std::vector<bool> scanFiles(const std::vector<std::string>& file_paths,
+                                     const std::vector<IndexedFile*>& files,
+                                     AMR::ThreadPool* thread_pool);
+
+  /**
+   * @brief Adds the records of a file, starting at the record with index
+   * @p first, to the record of every order id. An existing record of the
+   * same id is replaced if the new one takes precedence.
+   */
+  static void addRecords(const std::vector<IndexedFile>& files,
+                         const uint32_t file, const size_t first,
+                         std::unordered_map<uint32_t, OrderRecord>& records);
+
+  /**
+   * @brief Fills the record of every order id from all files.
+   */
+  static void buildRecords(const std::vector<IndexedFile>& files,
+                           std::unordered_map<uint32_t, OrderRecord>& records);
+
+  /**
+   * @brief Reads a persisted index. Returns an empty vector if the file does
+   * not exist or is invalid.
+   */
+  static std::vector<IndexedFile> load(const std::string& index_path);
+
+  /**
+   * @brief Writes the index to a file.
+   */
+  void save(const std::string& index_path) const;
+
+  mutable std::shared_mutex _mutex;  //!< Protects all other members.
+  bool _built;            //!< Whether @ref build was called.
+  std::string _dir_path;  //!< Directory containing the order files.
+  std::string _index_path;  //!< Path of the persisted index, or empty.
+  AMR::ThreadPool* _thread_pool;  //!< Pool that scans the files, or nullptr.
+  std::vector<IndexedFile> _files;  //!< Indexed files, in the order in which
+                                    //!< they were added.
+  std::unordered_map<uint32_t, OrderRecord>
+      _records;  //!< Record of every order id.
+};
+
+}  // namespace AMR
+
+#endif  // INCLUDE_ORDER_INDEX_HPP_
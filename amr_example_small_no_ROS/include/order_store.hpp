@@ -0,0 +1,177 @@
+/** @file order_store.hpp
+ * @brief Defines the compiled, binary store of the order history, which is
+ * memory-mapped and searched without parsing any yaml.
+ */
+
+#ifndef INCLUDE_ORDER_STORE_HPP_
+#define INCLUDE_ORDER_STORE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "basic_structs.hpp"
+#include "order_file_scanner.hpp"
+
+namespace AMR {
+
+/**
+ * @brief An order in the store. The products point into the mapped store and
+ * are valid as long as the store is open.
+ */
+struct StoredOrder {
+  float _x = 0.0f;                         //!< Delivery point, x coordinate.
+  float _y = 0.0f;                         //!< Delivery point, y coordinate.
+  const int64_t* _products = nullptr;      //!< First product of the order.
+  size_t _n_products = 0;                  //!< Number of products.
+  uint32_t _file = 0;  //!< Index of the order file the order was read from.
+};
+
+/**
+ * @brief Read-only store of all orders of the order files, compiled by the
+ * order_compiler executable.
+ *
+ * The store is a column layout in a single file:
+ * @code
+ * header:    "AMRORDS2", number of orders n, number of products m, number
+ *            of order files f (uint64)
+ * files:     f x (length of the path (uint64), absolute path, size in
+ *            bytes (uint64), modification time (int64))
+ * ids:       n x uint32, sorted ascending
+ * file:      n x uint32, order file of every order
+ * cx, cy:    n x float each
+ * offsets:   (n + 1) x uint64, products of order i are [offsets[i],
+ *            offsets[i + 1])
+ * products:  m x int64
+ * @endcode
+ * Every column starts at a multiple of 8 bytes. The file is mapped, and an
+ * order is found by a binary search of the id column, without allocating
+ * memory. Coordinates are stored in single precision.
+ *
+ * The store is a snapshot of the order files when it was compiled. If an
+ * order id occurs in several files, the record in the file whose name sorts
+ * first is stored. The size and modification time of every order file are
+ * stored as well, and @ref lookup does not return orders whose file changed
+ * since, so they are looked up in the files again.
+ */
+class OrderStore {
+ public:
+  /**
+   * @brief Construct a new, closed store.
+   */
+  OrderStore()
+      : _n_orders(0),
+        _ids(nullptr),
+        _files(nullptr),
+        _x(nullptr),
+        _y(nullptr),
+        _offsets(nullptr),
+        _products(nullptr){};
+
+  OrderStore(const OrderStore&) = delete;
+  OrderStore& operator=(const OrderStore&) = delete;
+
+  /**
+   * @brief Compiles all order files of a directory into a store file.
+   *
+   * @param[in] dir_path  Path to the directory containing the order files.
+   * @param[in] store_path  Path of the store file. It is replaced
+   * atomically, so an open store is not affected.
+   * @return true The store was written.
+   * @return false  An order file or the store file could not be accessed.
+   */
+  static bool compile(const std::string& dir_path,
+                      const std::string& store_path);
+
+  /**
+   * @brief Maps a store file, replacing the current one.
+   *
+   * @param[in] store_path  Path of the store file.
+   * @return true The store is open.
+   * @return false  The file does not exist or is not a valid store.
+   */
+  bool open(const std::string& store_path);
+
+  /**
+   * @brief Removes the mapping of the store.
+   */
+  void close();
+
+  /**
+   * @brief Checks whether a store is open.
+   *
+   * @return true @ref open succeeded.
+   * @return false  The store is closed.
+   */
+  bool isOpen() const { return _ids != nullptr; }
+
+  /**
+   * @brief Get the number of stored orders.
+   *
+   * @return Number of orders, 0 if the store is closed.
+   */
+  size_t size() const { return _n_orders; }
+
+  /**
+   * @brief Finds an order without allocating memory. Whether the order file
+   * of the order changed is not checked, see @ref isCurrent.
+   *
+   * @param[in] order_id  Id of the order.
+   * @param[out] order  The order, if it is stored.
+   * @return true The order is stored.
+   * @return false  The order is not stored, or the store is closed.
+   */
+  bool find(const uint32_t order_id, AMR::StoredOrder& order) const;
+
+  /**
+   * @brief Reads the information about an order, if its order file did not
+   * change since the store was compiled.
+   *
+   * The output variables are set as by @ref AMR::parseAllFilesToFindOrder,
+   * and are not changed unless the order is found.
+   *
+   * @param[in] order_id  Id of the order whose information is wanted.
+   * @param[in,out] delivery_point Delivery point of the order.
+   * @param[in,out] ordered_products Products of the order.
+   * @return true The order is stored.
+   * @return false  The order is not stored, its order file changed, or the
+   * store is closed.
+   */
+  bool lookup(const uint32_t order_id, AMR::Coordinates2D& delivery_point,
+              std::vector<long long int>& ordered_products) const;
+
+  /**
+   * @brief Checks whether an order file still has the size and modification
+   * time it had when the store was compiled.
+   *
+   * @param[in] file  Index of the order file, see @ref StoredOrder::_file.
+   * @return true The file is unchanged.
+   * @return false  The file changed or could not be accessed.
+   */
+  bool isCurrent(const uint32_t file) const;
+
+ private:
+  /**
+   * @brief An order file the store was compiled from.
+   */
+  struct SourceFile {
+    std::string _path;  //!< Absolute path of the file.
+    uint64_t _size;     //!< Size in bytes when the store was compiled.
+    int64_t _mtime;     //!< Modification time when the store was compiled.
+  };
+
+  AMR::MappedFile _file;     //!< Mapping of the store file.
+  size_t _n_orders;          //!< Number of orders.
+  const uint32_t* _ids;      //!< Sorted id column, or nullptr if closed.
+  const uint32_t* _files;    //!< Column of the order files of the orders.
+  const float* _x;           //!< Column of the x coordinates.
+  const float* _y;           //!< Column of the y coordinates.
+  const uint64_t* _offsets;  //!< Offsets of the products of every order.
+  const int64_t* _products;  //!< Products of all orders.
+  std::vector<SourceFile> _sources;  //!< Order files of the store.
+};
+
+}  // namespace AMR
+
+#endif  // INCLUDE_ORDER_STORE_HPP_
@@ -0,0 +1,181 @@
+/** @file path_cache.hpp
+ * @brief Defines a cache for pickup orders that were already determined.
+ */
+
+#ifndef INCLUDE_PATH_CACHE_HPP_
+#define INCLUDE_PATH_CACHE_HPP_
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "basic_structs.hpp"
+#include "catalog_distance_matrix.hpp"
+#include "catalog_path_table.hpp"
+#include "path_solvers.hpp"
+#include "warehouse_graph.hpp"
+
+namespace AMR {
+
+/**
+ * @brief Least recently used cache of solved pickup orders.
+ *
+ * The same product mixes are ordered again and again. An entry is identified
+ * by the sorted ids of the product parts of an order and by the starting and
+ * delivery point, which are quantized to a grid. Its value is the order in
+ * which the parts are picked up, given by their ids. The number of entries is
+ * bounded; when the cache is full, the least recently used entry is removed.
+ * The access to the cache is thread safe.
+ */
+class PathCache {
+ public:
+  /**
+   * @brief Construct a new, empty path cache.
+   *
+   * @param[in] capacity  Maximum number of entries.
+   * @param[in] grid_resolution  Edge length of the grid cells used to
+   * quantize the starting and delivery points. Points in the same cell are
+   * considered equal.
+   */
+  PathCache(const size_t capacity = 4096, const double grid_resolution = 1.0);
+
+  /**
+   * @brief Looks up the pickup order of an order.
+   *
+   * @param[in] part_ids  Sorted ids of the product parts of the order.
+   * @param[in] starting_point  Starting point of the path.
+   * @param[in] delivery_point  Delivery point of the path.
+   * @param[out] pickup_order  Ids of the product parts in the order in which
+   * they are picked up. It is only set if the order was found.
+   * @return true The order was found.
+   * @return false  The order was not found.
+   */
+  bool find(const std::vector<long long int>& part_ids,
+            const AMR::Coordinates2D& starting_point,
+            const AMR::Coordinates2D& delivery_point,
+            std::vector<long long int>& pickup_order);
+
+  /**
+   * @brief Inserts the pickup order of an order, replacing an existing entry.
+   *
+   * @param[in] part_ids  Sorted ids of the product parts of the order.
+   * @param[in] starting_point  Starting point of the path.
+   * @param[in] delivery_point  Delivery point of the path.
+   * @param[in] pickup_order  Ids of the product parts in the order in which
+   * they are picked up.
+   */
+  void insert(const std::vector<long long int>& part_ids,
+              const AMR::Coordinates2D& starting_point,
+              const AMR::Coordinates2D& delivery_point,
+              const std::vector<long long int>& pickup_order);
+
+  /**
+   * @brief Solves the orders of the most recent order files and inserts them.
+   *
+   * The orders of each file are replayed in sequence as the AMR unit would
+   * process them, i.e. every order starts at the delivery point of the
+   * previous one, and are solved by @ref AMR::determineOrderPath as when
+   * they are executed. Paths cut short by the planning budget are not
+   * inserted.
+   *
+   * @param[in] dir_path  Path to the directory containing the order files.
+   * @param[in] n_days  Number of most recent order files (one per day) that
+   * are replayed.
+   * @param[in] all_products  Vector containing all available products.
+   * @param[in] all_product_parts  Vector containing all available parts.
+   * @param[in] starting_point  Starting point of the first order.
+   * @param[in] options  Options used to solve the orders.
+   * @param[in] catalog_table  If not null, the precomputed path table of the
+   * catalog.
+   * @param[in] catalog_distances  If not null, the distances between the
+   * part locations of the catalog.
+   * @param[in] warehouse_graph  If not null, the graph of the aisles on which
+   * the distances are measured.
+   * @return Number of orders that were inserted.
+   */
+  size_t preload(const std::string& dir_path, const size_t n_days,
+                 const std::vector<AMR::Product>& all_products,
+                 const std::vector<AMR::ProductPart>& all_product_parts,
+                 const AMR::Coordinates2D& starting_point,
+                 const AMR::PathSolverOptions& options,
+                 const AMR::CatalogPathTable* catalog_table = nullptr,
+                 const AMR::CatalogDistanceMatrix* catalog_distances = nullptr,
+                 const AMR::WarehouseGraph* warehouse_graph = nullptr);
+
+  /**
+   * @brief Removes all entries. The counters are kept.
+   */
+  void clear();
+
+  /**
+   * @brief Get the number of entries.
+   *
+   * @return Number of entries.
+   */
+  size_t size() const;
+
+  /**
+   * @brief Get the number of successful lookups.
+   *
+   * @return @ref _hits.
+   */
+  uint64_t getHits() const;
+
+  /**
+   * @brief Get the number of failed lookups.
+   *
+   * @return @ref _misses.
+   */
+  uint64_t getMisses() const;
+
+ private:
+  /**
+   * @brief Key of an entry.
+   */
+  struct Key {
+    std::vector<long long int> _part_ids;  //!< Sorted part ids.
+    int64_t _start_x;     //!< Quantized x coordinate of the starting point.
+    int64_t _start_y;     //!< Quantized y coordinate of the starting point.
+    int64_t _delivery_x;  //!< Quantized x coordinate of the delivery point.
+    int64_t _delivery_y;  //!< Quantized y coordinate of the delivery point.
+    bool operator==(const Key& other) const {
+      return _start_x == other._start_x && _start_y == other._start_y &&
+             _delivery_x == other._delivery_x &&
+             _delivery_y == other._delivery_y &&
+             _part_ids == other._part_ids;
+    }
+  };
+
+  /**
+   * @brief Hash function for @ref Key.
+   */
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  typedef std::list<std::pair<Key, std::vector<long long int>>>
+      EntryList;  //!< Entries ordered from most to least recently used.
+
+  /**
+   * @brief Creates the key of an order.
+   */
+  Key makeKey(const std::vector<long long int>& part_ids,
+              const AMR::Coordinates2D& starting_point,
+              const AMR::Coordinates2D& delivery_point) const;
+
+  size_t _capacity;         //!< Maximum number of entries.
+  double _grid_resolution;  //!< Edge length of the quantization grid.
+  mutable std::mutex _mutex;  //!< Mutex to ensure thread safe access.
+  EntryList _entries;  //!< Entries ordered from most to least recently used.
+  std::unordered_map<Key, EntryList::iterator, KeyHash>
+      _index;       //!< Maps keys to their position in @ref _entries.
+  uint64_t _hits;    //!< Number of successful lookups.
+  uint64_t _misses;  //!< Number of failed lookups.
+};
+
+}  // namespace AMR
+
+#endif  // INCLUDE_PATH_CACHE_HPP_
@@ -0,0 +1,178 @@
+/** @file path_evaluator.hpp
+ * @brief Defines the kernels that evaluate many pickup orders at once, and a
+ * distance table whose precision is selected by a policy class.
+ *
+ * The distances of an order are stored as doubles by
+ * @ref AMR::DistanceMatrix. At warehouse scale, floats or integer
+ * millimeters are precise enough to rank pickup orders, and they allow
+ * twice as many orders to be evaluated per AVX2 instruction.
+ */
+
+#ifndef INCLUDE_PATH_EVALUATOR_HPP_
+#define INCLUDE_PATH_EVALUATOR_HPP_
+
+#include <math.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "distance_matrix.hpp"
+
+namespace AMR {
+
+/**
+ * @brief Stores distances as doubles, like @ref AMR::DistanceMatrix.
+ */
+struct DoublePrecision {
+  typedef double Value;
+  static Value quantize(const double distance) { return distance; }
+  static double toLength(const Value value) { return value; }
+};
+
+/**
+ * @brief Stores distances as floats, which have about 7 significant digits.
+ *
+ * The legs of a path are added in float, so long paths accumulate rounding
+ * errors of the order of 1e-7 times their length.
+ */
+struct FloatPrecision {
+  typedef float Value;
+  static Value quantize(const double distance) {
+    return static_cast<float>(distance);
+  }
+  static double toLength(const Value value) { return value; }
+};
+
+/**
+ * @brief Stores distances as integers in units of 1 / kScale coordinate
+ * units, i.e. millimeters if the coordinates are given in meters.
+ *
+ * Each distance is rounded once, and integer sums are exact, so the length
+ * of a path does not depend on the order in which its legs are added. Paths
+ * must be shorter than 2^31 / kScale coordinate units.
+ */
+struct FixedPointPrecision {
+  typedef int32_t Value;
+  static constexpr double kScale = 1000.0;  //!< Units per coordinate unit.
+  static Value quantize(const double distance) {
+    return static_cast<int32_t>(lround(distance * kScale));
+  }
+  static double toLength(const Value value) { return value / kScale; }
+};
+
+/**
+ * @brief Determines the path lengths of several pickup orders at once.
+ *
+ * All instruction sets add the legs of a path in the same sequence, so they
+ * produce bitwise identical results. SSE2 is only used for doubles; floats
+ * and integers are evaluated eight at a time with AVX2.
+ *
+ * @tparam Value  double, float or int32_t.
+ * @param[in] distances  Row-major matrix of the distances between the
+ * @p n_nodes nodes, numbered as in @ref AMR::DistanceMatrix.
+ * @param[in] n_nodes  Number of nodes.
+ * @param[in] pickup_orders  Array of @p n_orders pickup orders of
+ * n_nodes - 2 part indices each, stored one after the other.
+ * @param[in] n_orders  Number of pickup orders.
+ * @param[out] path_lengths  Array of @p n_orders path lengths.
+ * @param[in] simd_level  Instruction set to use. It must be supported by
+ * the CPU.
+ */
+template <typename Value>
+void evaluatePathLengthBatch(const Value* distances, const size_t n_nodes,
+                             const int32_t* pickup_orders,
+                             const size_t n_orders, Value* path_lengths,
+                             const SimdLevel simd_level);
+
+/**
+ * @brief Specialization for doubles, which also has an SSE2 kernel.
+ */
+template <>
+void evaluatePathLengthBatch<double>(const double* distances,
+                                     const size_t n_nodes,
+                                     const int32_t* pickup_orders,
+                                     const size_t n_orders,
+                                     double* path_lengths,
+                                     const SimdLevel simd_level);
+
+/**
+ * @brief Distances of an order, stored in the precision of a policy class.
+ *
+ * @tparam Precision  @ref AMR::DoublePrecision, @ref AMR::FloatPrecision or
+ * @ref AMR::FixedPointPrecision.
+ */
+template <typename Precision>
+class PathEvaluator {
+ public:
+  typedef typename Precision::Value Value;
+
+  /**
+   * @brief Construct a new evaluator by converting a distance matrix.
+   *
+   * @param[in] distances  Distances of the order.
+   */
+  explicit PathEvaluator(const AMR::DistanceMatrix& distances)
+      : _n_nodes(distances.getNumberOfNodes()),
+        _distances(_n_nodes * _n_nodes) {
+    for (size_t i = 0; i < _n_nodes; ++i) {
+      for (size_t j = 0; j < _n_nodes; ++j) {
+        _distances[i * _n_nodes + j] = Precision::quantize(distances(i, j));
+      }
+    }
+  }
+
+  /**
+   * @brief Get the number of nodes, i.e. the number of part locations plus 2.
+   *
+   * @return @ref _n_nodes.
+   */
+  size_t getNumberOfNodes() const { return _n_nodes; }
+
+  /**
+   * @brief Determines the length of the path of a single pickup order.
+   *
+   * @param[in] pickup_order  Array of n pairwise different part indices in
+   * {0, ..., n-1}.
+   * @return Length of the path in the precision of the policy.
+   */
+  Value determinePathLength(const int* pickup_order) const {
+    Value path_length = 0;
+    evaluatePathLengthBatch(_distances.data(), _n_nodes, pickup_order, 1,
+                            &path_length, SimdLevel::kScalar);
+    return path_length;
+  }
+
+  /**
+   * @brief Determines the path lengths of several pickup orders at once
+   * using the instruction set returned by @ref AMR::detectSimdLevel.
+   *
+   * @param[in] pickup_orders  Array of @p n_orders pickup orders of n part
+   * indices each, stored one after the other.
+   * @param[in] n_orders  Number of pickup orders.
+   * @param[out] path_lengths  Array of @p n_orders path lengths.
+   */
+  void evaluatePathLengths(const int32_t* pickup_orders, const size_t n_orders,
+                           Value* path_lengths) const {
+    evaluatePathLengthBatch(_distances.data(), _n_nodes, pickup_orders,
+                            n_orders, path_lengths, detectSimdLevel());
+  }
+
+  /**
+   * @brief Converts a path length of the policy into coordinate units.
+   *
+   * @param[in] path_length  Path length in the precision of the policy.
+   * @return Path length as a double.
+   */
+  static double toLength(const Value path_length) {
+    return Precision::toLength(path_length);
+  }
+
+ private:
+  size_t _n_nodes;                //!< Number of nodes.
+  std::vector<Value> _distances;  //!< Row-major distance matrix.
+};
+
+}  // namespace AMR
+
+#endif  // INCLUDE_PATH_EVALUATOR_HPP_
@@ -0,0 +1,414 @@
+/** @file path_solvers.hpp
+ * @brief Contains the solvers that determine the order in which the part
+ * locations of an order are visited.
+ *
+ * All solvers compute an open path with a fixed starting point and a fixed
+ * delivery point, i.e. the same path that is measured by
+ * @ref AMR::determinePathLength.
+ */
+
+#ifndef INCLUDE_PATH_SOLVERS_HPP_
+#define INCLUDE_PATH_SOLVERS_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "basic_structs.hpp"
+#include "distance_matrix.hpp"
+#include "thread_pool.hpp"
+
+namespace AMR {
+
+/**
+ * @brief Largest number of part locations for which the Held-Karp solver can
+ * be used.
+ *
+ * The dynamic programming table of the solver stores n * 2^(n-1) doubles,
+ * which amounts to roughly 1.6 GB for n = 24.
+ */
+constexpr size_t kHeldKarpMaxLocations = 24;
+
+/**
+ * @brief Lower bounds on the length of the remaining path that can be used
+ * by @ref AMR::solveBranchAndBound.
+ *
+ * Both bounds are admissible, i.e. they never exceed the length of the
+ * shortest path from the current location through all unvisited locations
+ * to the delivery point.
+ */
+enum class LowerBound {
+  kNearestNeighbor,  //!< Sum of the shortest incoming edge of every
+                     //!< unvisited location and the delivery point.
+  kMinimumSpanningTree  //!< Weight of a minimum spanning tree of the current
+                        //!< location, the unvisited locations and the
+                        //!< delivery point.
+};
+
+/**
+ * @brief Exact solvers that can be selected by @ref AMR::PathSolverOptions.
+ *
+ */
+enum class ExactSolver {
+  kHeldKarp,        //!< @ref AMR::solveHeldKarp
+  kBranchAndBound,  //!< @ref AMR::solveBranchAndBound
+  kExhaustive       //!< @ref AMR::solveExhaustive
+};
+
+/**
+ * @brief Options that control how @ref AMR::determineShortestPath determines
+ * the pickup order of an order.
+ *
+ */
+struct PathSolverOptions {
+  /**
+   * @brief Construct options with default values.
+   */
+  PathSolverOptions()
+      : _exact_solver(ExactSolver::kHeldKarp),
+        _heuristic_cutoff(22),
+        _neighbor_list_size(8),
+        _planning_budget_ms(0),
+        _colocation_epsilon(0.0),
+        _catalog_table_max_locations(16),
+        _distance_metric(DistanceMetric::kEuclidean),
+        _thread_pool(nullptr){};
+  ExactSolver _exact_solver;  //!< Solver used for orders with at most
+                              //!< @ref _heuristic_cutoff part locations. The
+                              //!< cutoff should be lowered to about 12 for
+                              //!< the exhaustive solver.
+  size_t _heuristic_cutoff;  //!< Orders with more part locations are solved
+                             //!< by @ref AMR::solveHeuristic instead of an
+                             //!< exact solver. Values above
+                             //!< @ref kHeldKarpMaxLocations are capped.
+  size_t _neighbor_list_size;  //!< Number of closest locations considered
+                               //!< for each location by the local search of
+                               //!< @ref AMR::solveHeuristic.
+  uint32_t _planning_budget_ms;  //!< Wall-clock time in milliseconds after
+                                 //!< which the exact solver is stopped and
+                                 //!< the shortest path found so far is used.
+                                 //!< 0 means that there is no limit.
+  double _colocation_epsilon;  //!< Part locations whose coordinates differ
+                               //!< by at most this value are merged into
+                               //!< one route node before solving. With 0,
+                               //!< only identical locations are merged.
+  size_t _catalog_table_max_locations;  //!< If the catalog has at most this
+                                        //!< many distinct pickup locations,
+                                        //!< orders are answered by a
+                                        //!< @ref AMR::CatalogPathTable.
+                                        //!< The table is built when the unit
+                                        //!< starts running; 0 disables it.
+  DistanceMetric _distance_metric;  //!< Metric in which the distances
+                                    //!< between all points are measured.
+  ThreadPool* _thread_pool;  //!< Pool to which the parallel solvers submit
+                             //!< their tasks. If it is null, they start
+                             //!< their own threads.
+};
+
+/**
+ * @brief Result of @ref AMR::determineShortestPath.
+ *
+ */
+struct PathSolverResult {
+  /**
+   * @brief Construct a new result.
+   *
+   * @param[in] path_length  Length of the determined path.
+   * @param[in] proven_optimal  Whether the path is known to be the shortest.
+   */
+  PathSolverResult(const double path_length, const bool proven_optimal)
+      : _path_length(path_length), _proven_optimal(proven_optimal){};
+  double _path_length;   //!< Length of the determined path.
+  bool _proven_optimal;  //!< True if an exact solver finished, false if the
+                         //!< path was found by the heuristic or the planning
+                         //!< budget ran out.
+};
+
+/**
+ * @brief Point in time after which the exact solvers stop their search.
+ *
+ * The solvers check the deadline periodically. A check that finds the
+ * deadline expired is remembered, so afterwards @ref isReached tells whether
+ * the search was cut short. The checks are thread safe.
+ */
+class Deadline {
+ public:
+  /**
+   * @brief Construct a deadline that expires after a given time.
+   *
+   * @param[in] budget  Time from now until the deadline expires.
+   */
+  explicit Deadline(const std::chrono::milliseconds budget)
+      : _end(std::chrono::steady_clock::now() + budget), _reached(false){};
+
+  /**
+   * @brief Checks whether the deadline has expired.
+   *
+   * @return true The deadline has expired; the search should stop.
+   * @return false  There is time left.
+   */
+  bool expired() const {
+    if (!_reached.load(std::memory_order_relaxed) &&
+        std::chrono::steady_clock::now() >= _end) {
+      _reached.store(true, std::memory_order_relaxed);
+    }
+    return _reached.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Checks whether a previous call of @ref expired returned true.
+   *
+   * @return true A solver noticed the deadline and stopped early.
+   * @return false  No solver was stopped by this deadline.
+   */
+  bool isReached() const { return _reached.load(std::memory_order_relaxed); }
+
+ private:
+  std::chrono::steady_clock::time_point _end;  //!< Expiration time.
+  mutable std::atomic<bool> _reached;  //!< Set by the first expired check.
+};
+
+/**
+ * @brief Counters reported by the search based solvers.
+ *
+ */
+struct PathSolverStatistics {
+  /**
+   * @brief Construct new statistics with all counters set to zero.
+   */
+  PathSolverStatistics() : _nodes_explored(0), _nodes_pruned(0){};
+  uint64_t _nodes_explored;  //!< Number of partial pickup orders visited.
+  uint64_t _nodes_pruned;    //!< Number of partial pickup orders discarded
+                             //!< because of their lower bound.
+};
+
+/**
+ * @brief Determines the shortest path by trying all permutations of the part
+ * locations.
+ *
+ * The run-time is in O(n! * n), so this solver is only usable for a small
+ * number of part locations. It is kept as a reference for the other solvers.
+ *
+ * @param[in] starting_point  Starting point of the path.
+ * @param[in] part_locations  Locations of all parts which have to be collected.
+ * @param[in] delivery_point  End point of the path.
+ * @param[out] pickup_order  Order in which the parts are picked up.
+ * @return Length of the shortest path.
+ */
+double solveBruteForce(const AMR::Coordinates2D &starting_point,
+                       const std::vector<Coordinates2D> &part_locations,
+                       const AMR::Coordinates2D &delivery_point,
+                       std::vector<int> &pickup_order);
+
+/**
+ * @brief Overload of @ref AMR::solveBruteForce that uses a precomputed
+ * distance matrix. The path lengths are evaluated in batches by
+ * @ref AMR::DistanceMatrix::evaluatePathLengths.
+ *
+ * @param[in] distances  Distance matrix of the order.
+ * @param[out] pickup_order  Order in which the parts are picked up.
+ * @return Length of the shortest path.
+ */
+double solveBruteForce(const AMR::DistanceMatrix &distances,
+                       std::vector<int> &pickup_order);
+
+/**
+ * @brief Determines the shortest path using the Held-Karp dynamic program.
+ *
+ * The table entry for a part j and a set S of parts not containing j stores
+ * the length of the shortest path that starts at @p starting_point, visits
+ * all parts in S and ends at part j. The table is filled layer by layer
+ * (sets of equal size), and each layer is split among several threads. The
+ * run-time is in O(2^n * n^2) and the memory consumption in O(2^n * n).
+ *
+ * @param[in] starting_point  Starting point of the path.
+ * @param[in] part_locations  Locations of all parts which have to be
+ * collected. At most @ref kHeldKarpMaxLocations locations are supported.
+ * @param[in] delivery_point  End point of the path.
+ * @param[out] pickup_order  Order in which the parts are picked up.
+ * @param[in] n_threads  Number of threads used to fill the table. If it is 0,
+ * the number of hardware threads is used.
+ * @return Length of the shortest path.
+ */
+double solveHeldKarp(const AMR::Coordinates2D &starting_point,
+                     const std::vector<Coordinates2D> &part_locations,
+                     const AMR::Coordinates2D &delivery_point,
+                     std::vector<int> &pickup_order,
+                     unsigned int n_threads = 0);
+
+/**
+ * @brief Overload of @ref AMR::solveHeldKarp that uses a precomputed distance
+ * matrix.
+ *
+ * The table yields no path before it is complete. If the deadline expires
+ * earlier, the path of @ref AMR::solveNearestNeighbor is returned instead.
+ *
+ * @param[in] distances  Distance matrix of the order.
+ * @param[out] pickup_order  Order in which the parts are picked up.
+ * @param[in] n_threads  Number of threads used to fill the table. If it is 0,
+ * the number of hardware threads is used.
+ * @param[in] deadline  If not null, the filling of the table is stopped when
+ * the deadline expires.
+ * @param[in] thread_pool  Pool that fills the layers of the table. If it is
+ * null, threads are started for every layer.
+ * @return Length of the shortest path.
+ */
+double solveHeldKarp(const AMR::DistanceMatrix &distances,
+                     std::vector<int> &pickup_order,
+                     unsigned int n_threads = 0,
+                     const Deadline *deadline = nullptr,
+                     AMR::ThreadPool *thread_pool = nullptr);
+
+/**
+ * @brief Determines the shortest path by trying all permutations of the part
+ * locations, evaluating each permutation incrementally.
+ *
+ * The permutations are visited in lexicographic order. Consecutive
+ * permutations share a prefix, so the lengths of all prefixes of the current
+ * permutation are cached and only the legs of the changed suffix are added
+ * again. On average only a constant number of legs changes, so the run-time
+ * is in O(n!) instead of the O(n! * n) of @ref AMR::solveBruteForce.
+ *
+ * The permutations are split by their leading parts into tasks, which are
+ * processed by several threads. The threads share the length of the
+ * shortest path found so far, and permutations whose prefix is already
+ * longer are skipped. The result does not depend on the number of threads
+ * and equals the one of @ref AMR::solveBruteForce, i.e. the first of several
+ * shortest pickup orders in lexicographic order.
+ *
+ * If the deadline expires, the shortest path found so far is returned. It is
+ * at least as short as the path of @ref AMR::solveNearestNeighbor.
+ *
+ * @param[in] distances  Distance matrix of the order.
+ * @param[out] pickup_order  Order in which the parts are picked up.
+ * @param[in] n_threads  Number of threads used. If it is 0, the number of
+ * hardware threads is used.
+ * @param[in] deadline  If not null, the search is stopped when the deadline
+ * expires.
+ * @param[in] thread_pool  Pool that processes the tasks. If it is null,
+ * threads are started.
+ * @return Length of the shortest path.
+ */
+double solveExhaustive(const AMR::DistanceMatrix &distances,
+                       std::vector<int> &pickup_order,
+                       unsigned int n_threads = 0,
+                       const Deadline *deadline = nullptr,
+                       AMR::ThreadPool *thread_pool = nullptr);
+
+/**
+ * @brief Determines a path by always moving to the closest part location that
+ * has not been visited yet.
+ *
+ * The result is usually not the shortest path, but it is computed in O(n^2)
+ * and used as a starting point for the other solvers.
+ *
+ * @param[in] starting_point  Starting point of the path.
+ * @param[in] part_locations  Locations of all parts which have to be collected.
+ * @param[in] delivery_point  End point of the path.
+ * @param[out] pickup_order  Order in which the parts are picked up.
+ * @return Length of the determined path.
+ */
+double solveNearestNeighbor(const AMR::Coordinates2D &starting_point,
+                            const std::vector<Coordinates2D> &part_locations,
+                            const AMR::Coordinates2D &delivery_point,
+                            std::vector<int> &pickup_order);
+
+/**
+ * @brief Overload of @ref AMR::solveNearestNeighbor that uses a precomputed
+ * distance matrix.
+ *
+ * @param[in] distances  Distance matrix of the order.
+ * @param[out] pickup_order  Order in which the parts are picked up.
+ * @return Length of the determined path.
+ */
+double solveNearestNeighbor(const AMR::DistanceMatrix &distances,
+                            std::vector<int> &pickup_order);
+
+/**
+ * @brief Determines the shortest path by a depth-first branch-and-bound
+ * search.
+ *
+ * The search starts with the path of @ref AMR::solveNearestNeighbor as the
+ * best known path. A partial pickup order is discarded as soon as the length
+ * of its prefix plus a lower bound for the rest of the path is not shorter
+ * than the best known path. Unvisited locations are explored closest first.
+ *
+ * @param[in] starting_point  Starting point of the path.
+ * @param[in] part_locations  Locations of all parts which have to be collected.
+ * @param[in] delivery_point  End point of the path.
+ * @param[out] pickup_order  Order in which the parts are picked up.
+ * @param[in] lower_bound  Lower bound used to prune partial pickup orders.
+ * @param[out] statistics  If not null, the search counters are written here.
+ * @return Length of the shortest path.
+ */
+double solveBranchAndBound(
+    const AMR::Coordinates2D &starting_point,
+    const std::vector<Coordinates2D> &part_locations,
+    const AMR::Coordinates2D &delivery_point, std::vector<int> &pickup_order,
+    const LowerBound lower_bound = LowerBound::kMinimumSpanningTree,
+    PathSolverStatistics *statistics = nullptr);
+
+/**
+ * @brief Overload of @ref AMR::solveBranchAndBound that uses a precomputed
+ * distance matrix.
+ *
+ * If the deadline expires, the shortest path found so far is returned.
+ *
+ * @param[in] distances  Distance matrix of the order.
+ * @param[out] pickup_order  Order in which the parts are picked up.
+ * @param[in] lower_bound  Lower bound used to prune partial pickup orders.
+ * @param[out] statistics  If not null, the search counters are written here.
+ * @param[in] deadline  If not null, the search is stopped when the deadline
+ * expires.
+ * @return Length of the shortest path.
+ */
+double solveBranchAndBound(
+    const AMR::DistanceMatrix &distances, std::vector<int> &pickup_order,
+    const LowerBound lower_bound = LowerBound::kMinimumSpanningTree,
+    PathSolverStatistics *statistics = nullptr,
+    const Deadline *deadline = nullptr);
+
+/**
+ * @brief Determines a short path for a large number of part locations.
+ *
+ * The path of @ref AMR::solveNearestNeighbor is improved by a local search
+ * until no improving move is left. The local search applies 2-opt moves
+ * (reversal of a subpath) and Or-opt moves (relocation of up to three
+ * consecutive locations, optionally reversed). Only moves that connect a
+ * location to one of its @p neighbor_list_size closest locations are tried.
+ * The starting point and the delivery point always stay at the ends of the
+ * path. The result is not necessarily the shortest path.
+ *
+ * @param[in] starting_point  Starting point of the path.
+ * @param[in] part_locations  Locations of all parts which have to be collected.
+ * @param[in] delivery_point  End point of the path.
+ * @param[out] pickup_order  Order in which the parts are picked up.
+ * @param[in] neighbor_list_size  Number of closest locations considered for
+ * each location.
+ * @return Length of the determined path.
+ */
+double solveHeuristic(const AMR::Coordinates2D &starting_point,
+                      const std::vector<Coordinates2D> &part_locations,
+                      const AMR::Coordinates2D &delivery_point,
+                      std::vector<int> &pickup_order,
+                      const size_t neighbor_list_size = 8);
+
+/**
+ * @brief Overload of @ref AMR::solveHeuristic that uses a precomputed distance
+ * matrix.
+ *
+ * @param[in] distances  Distance matrix of the order.
+ * @param[out] pickup_order  Order in which the parts are picked up.
+ * @param[in] neighbor_list_size  Number of closest locations considered for
+ * each location.
+ * @return Length of the determined path.
+ */
+double solveHeuristic(const AMR::DistanceMatrix &distances,
+                      std::vector<int> &pickup_order,
+                      const size_t neighbor_list_size = 8);
+
+}  // namespace AMR
+
+#endif  // INCLUDE_PATH_SOLVERS_HPP_
@@ -0,0 +1,223 @@
+/** @file small_path_solvers.hpp
+ * @brief Contains exact path solvers that are specialized at compile time for
+ * orders with few part locations.
+ *
+ * Most orders only visit a handful of part locations. For these, the generic
+ * solvers spend more time on allocating their vectors and distance matrix
+ * than on the search itself. The solvers in this file keep all their state
+ * in fixed-size arrays on the stack and evaluate a permutation table that is
+ * generated at compile time.
+ */
+
+#ifndef INCLUDE_SMALL_PATH_SOLVERS_HPP_
+#define INCLUDE_SMALL_PATH_SOLVERS_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "basic_structs.hpp"
+#include "distance_metrics.hpp"
+
+namespace AMR {
+
+/**
+ * @brief Largest number of part locations handled by @ref AMR::solveSmall.
+ *
+ * The permutation table for n locations has n! entries of n bytes, i.e.
+ * 315 KiB for n = 8.
+ */
+constexpr size_t kSmallSolverMaxLocations = 8;
+
+/**
+ * @brief Largest number of part locations for which
+ * @ref AMR::determineShortestPath uses @ref AMR::solveSmall.
+ *
+ * The number of evaluated permutations grows with n!, so from about 7
+ * locations on @ref AMR::solveHeldKarp is faster despite its allocations.
+ */
+constexpr size_t kSmallSolverDispatchLimit = 6;
+
+namespace small_path_solvers {
+
+/**
+ * @brief Computes n! at compile time.
+ */
+constexpr size_t factorial(const size_t n) {
+  return n <= 1 ? 1 : n * factorial(n - 1);
+}
+
+/**
+ * @brief All permutations of {0, ..., N-1} in lexicographic order.
+ */
+template <size_t N>
+struct PermutationTable {
+  static constexpr size_t kCount = factorial(N);  //!< Number of permutations.
+  std::array<std::array<uint8_t, N>, kCount>
+      _permutations;  //!< Permutations in lexicographic order.
+};
+
+/**
+ * @brief Generates the permutation table for N locations at compile time.
+ *
+ * std::next_permutation is not constexpr before C++20, so the step is
+ * written out here.
+ */
+template <size_t N>
+constexpr PermutationTable<N> makePermutationTable() {
+  PermutationTable<N> table{};
+  std::array<uint8_t, N> permutation{};
+  for (size_t i = 0; i < N; ++i) {
+    permutation[i] = static_cast<uint8_t>(i);
+  }
+  for (size_t p = 0; p < PermutationTable<N>::kCount; ++p) {
+    table._permutations[p] = permutation;
+    size_t pivot = N - 1;
+    while (pivot > 0 && permutation[pivot - 1] >= permutation[pivot]) {
+      --pivot;
+    }
+    if (pivot == 0) {
+      break;
+    }
+    --pivot;
+    size_t successor = N - 1;
+    while (permutation[successor] <= permutation[pivot]) {
+      --successor;
+    }
+    uint8_t swapped = permutation[pivot];
+    permutation[pivot] = permutation[successor];
+    permutation[successor] = swapped;
+    for (size_t i = pivot + 1, j = N - 1; i < j; ++i, --j) {
+      swapped = permutation[i];
+      permutation[i] = permutation[j];
+      permutation[j] = swapped;
+    }
+  }
+  return table;
+}
+
+/**
+ * @brief Permutation table for N locations, evaluated at compile time.
+ */
+template <size_t N>
+inline constexpr PermutationTable<N> kPermutationTable =
+    makePermutationTable<N>();
+
+/**
+ * @brief Node at position I of the path given by a permutation. Nodes are
+ * numbered as in @ref AMR::DistanceMatrix.
+ */
+template <size_t N, size_t I>
+constexpr size_t pathNode(const std::array<uint8_t, N> &permutation) {
+  if constexpr (I == 0) {
+    return 0;
+  } else if constexpr (I == N + 1) {
+    return N + 1;
+  } else {
+    return size_t{permutation[I - 1]} + 1;
+  }
+}
+
+/**
+ * @brief Sums the N + 1 legs of the path given by a permutation.
+ *
+ * The fold expression is unrolled by the compiler. The legs are added from
+ * the starting point to the delivery point, in the same sequence as in
+ * @ref AMR::DistanceMatrix::determinePathLength, so the results are bitwise
+ * identical.
+ */
+template <size_t N, size_t... I>
+inline double sumLegs(const std::array<double, (N + 2) * (N + 2)> &distances,
+                      const std::array<uint8_t, N> &permutation,
+                      std::index_sequence<I...>) {
+  return (0.0 + ... +
+          distances[pathNode<N, I>(permutation) * (N + 2) +
+                    pathNode<N, I + 1>(permutation)]);
+}
+
+}  // namespace small_path_solvers
+
+/**
+ * @brief Determines the shortest path for a number of part locations that is
+ * known at compile time.
+ *
+ * All permutations of the compile-time permutation table are evaluated, so
+ * the result is the first of several shortest pickup orders in lexicographic
+ * order, just as for @ref AMR::solveBruteForce. No memory is allocated.
+ *
+ * @tparam N  Number of part locations, 1 <= N <= kSmallSolverMaxLocations.
+ * @tparam Metric  Policy class of the metric, see distance_metrics.hpp.
+ * @param[in] starting_point  Starting point of the path.
+ * @param[in] part_locations  Array of the N locations of all parts which have
+ * to be collected.
+ * @param[in] delivery_point  End point of the path.
+ * @param[out] pickup_order  Order in which the parts are picked up.
+ * @return Length of the shortest path.
+ */
+template <size_t N, typename Metric = EuclideanMetric>
+double solveSmall(const AMR::Coordinates2D &starting_point,
+                  const AMR::Coordinates2D *part_locations,
+                  const AMR::Coordinates2D &delivery_point,
+                  std::array<int, N> &pickup_order) {
+  static_assert(N >= 1 && N <= kSmallSolverMaxLocations,
+                "unsupported number of part locations");
+  constexpr size_t n_nodes = N + 2;
+  // the distances are computed exactly as by AMR::DistanceMatrix
+  std::array<const AMR::Coordinates2D *, n_nodes> nodes;
+  nodes[0] = &starting_point;
+  for (size_t i = 0; i < N; ++i) {
+    nodes[i + 1] = &part_locations[i];
+  }
+  nodes[n_nodes - 1] = &delivery_point;
+  std::array<double, n_nodes * n_nodes> distances{};
+  for (size_t i = 0; i < n_nodes; ++i) {
+    for (size_t j = i + 1; j < n_nodes; ++j) {
+      double distance = computeDistance<Metric>(*nodes[i], *nodes[j]);
+      distances[i * n_nodes + j] = distance;
+      distances[j * n_nodes + i] = distance;
+    }
+  }
+
+  const auto &permutations =
+      small_path_solvers::kPermutationTable<N>._permutations;
+  double shortest_path_length = std::numeric_limits<double>::max();
+  size_t best = 0;
+  for (size_t p = 0; p < permutations.size(); ++p) {
+    const double path_length = small_path_solvers::sumLegs<N>(
+        distances, permutations[p], std::make_index_sequence<N + 1>());
+    if (path_length < shortest_path_length) {
+      shortest_path_length = path_length;
+      best = p;
+    }
+  }
+  for (size_t i = 0; i < N; ++i) {
+    pickup_order[i] = permutations[best][i];
+  }
+  return shortest_path_length;
+}
+
+/**
+ * @brief Determines the shortest path for at most
+ * @ref kSmallSolverMaxLocations part locations by dispatching to the
+ * specialization of @ref AMR::solveSmall for the number of locations.
+ *
+ * @param[in] starting_point  Starting point of the path.
+ * @param[in] part_locations  Locations of all parts which have to be
+ * collected.
+ * @param[in] delivery_point  End point of the path.
+ * @param[out] pickup_order  Order in which the parts are picked up.
+ * @param[in] metric  Metric in which the distances are measured.
+ * @return Length of the shortest path.
+ */
+double solveSmall(const AMR::Coordinates2D &starting_point,
+                  const std::vector<Coordinates2D> &part_locations,
+                  const AMR::Coordinates2D &delivery_point,
+                  std::vector<int> &pickup_order,
+                  const DistanceMetric metric = DistanceMetric::kEuclidean);
+
+}  // namespace AMR
+
+#endif  // INCLUDE_SMALL_PATH_SOLVERS_HPP_
@@ -0,0 +1,248 @@
+/** @file thread_pool.hpp
+ * @brief Defines the work-stealing thread pool to which the order lookup, the
+ * loading of the catalog and the parallel solvers submit their tasks.
+ */
+
+#ifndef INCLUDE_THREAD_POOL_HPP_
+#define INCLUDE_THREAD_POOL_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace AMR {
+
+/**
+ * @brief Parts of the application whose use of the pool is counted
+ * separately.
+ */
+enum class ThreadPoolSubsystem {
+  kOrderLookup,  //!< Search of the order files.
+  kCatalog,      //!< Precomputations on the catalog when the unit starts.
+  kSolver        //!< Parallel solvers of the shortest path.
+};
+
+//! Number of values of @ref AMR::ThreadPoolSubsystem.
+constexpr size_t kNumberOfThreadPoolSubsystems = 3;
+
+/**
+ * @brief Get the name of a subsystem, e.g. for printing statistics.
+ *
+ * @param[in] subsystem  Subsystem.
+ * @return Name in lowercase words.
+ */
+const char* getSubsystemName(const ThreadPoolSubsystem subsystem);
+
+/**
+ * @brief Time the pool spent on the tasks of a subsystem.
+ */
+struct ThreadPoolStatistics {
+  uint64_t _n_tasks = 0;        //!< Number of executed tasks, including the
+                                //!< calls executed by the caller of run().
+  double _busy_seconds = 0.0;   //!< Run-time of the tasks on the workers,
+                                //!< without the nested tasks they waited
+                                //!< for. Calls executed by other threads
+                                //!< are not counted.
+  double _utilization = 0.0;    //!< Busy time divided by the time since the
+                                //!< start of the pool times its size, at
+                                //!< most 1.
+};
+
+/**
+ * @brief Pool of worker threads, each with its own queue of tasks.
+ *
+ * Tasks submitted by a worker are pushed to its own queue, all other tasks
+ * are distributed round-robin. A worker takes the most recent task of its own
+ * queue and, if that is empty, steals the oldest task of another queue.
+ *
+ * @ref run waits until a group of tasks is finished. Meanwhile, the waiting
+ * thread executes pending tasks of the same group itself, so tasks may call
+ * @ref run without blocking a worker. Tasks of other groups and submitted
+ * tasks are left to the workers, so e.g. a lookup submitted in the
+ * background never delays the caller of @ref run.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @brief Construct a new pool without workers. @ref start has to be called
+   * before tasks are executed in parallel.
+   */
+  ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * @brief Destroy the pool after finishing all submitted tasks.
+   */
+  ~ThreadPool() { stop(); }
+
+  /**
+   * @brief Starts the workers. A running pool is stopped first.
+   *
+   * @param[in] n_threads  Number of workers. If it is 0, the number of
+   * hardware threads is used.
+   */
+  void start(size_t n_threads = 0);
+
+  /**
+   * @brief Finishes all submitted tasks and stops the workers.
+   */
+  void stop();
+
+  /**
+   * @brief Get the number of workers.
+   *
+   * @return Number of workers, 0 if the pool is not started.
+   */
+  size_t getSize() const { return _threads.size(); }
+
+  /**
+   * @brief Submits a task without waiting for it. If the pool is not
+   * running, e.g. because it is being stopped, the task is executed by the
+   * calling thread.
+   *
+   * @param[in] subsystem  Subsystem the task is counted for.
+   * @param[in] task  Task to execute.
+   */
+  void submit(const ThreadPoolSubsystem subsystem,
+              std::function<void()> task);
+
+  /**
+   * @brief Executes a function on several workers and waits until all of
+   * them returned. The calling thread executes the first call itself.
+   *
+   * @param[in] subsystem  Subsystem the calls are counted for.
+   * @param[in] n_workers  Number of calls.
+   * @param[in] work  Function that is called with the indices
+   * 0, ..., n_workers - 1.
+   */
+  void run(const ThreadPoolSubsystem subsystem, const size_t n_workers,
+           const std::function<void(size_t)>& work);
+
+  /**
+   * @brief Get the use of the pool by a subsystem.
+   *
+   * @param[in] subsystem  Subsystem.
+   * @return Counters since the pool was started.
+   */
+  ThreadPoolStatistics getStatistics(const ThreadPoolSubsystem subsystem) const;
+
+ private:
+  /**
+   * @brief A submitted task.
+   */
+  struct Task {
+    std::function<void()> _function;  //!< Function to execute.
+    ThreadPoolSubsystem _subsystem;   //!< Subsystem the task is counted for.
+    const void* _group;  //!< Group of @ref run the task belongs to, or
+                         //!< nullptr for a submitted task.
+  };
+
+  /**
+   * @brief Queue of a worker.
+   */
+  struct WorkerQueue {
+    std::mutex _mutex;         //!< Protects @ref _tasks.
+    std::deque<Task> _tasks;   //!< Pending tasks.
+  };
+
+  /**
+   * @brief Takes a pending task.
+   *
+   * @param[in] worker  Index of the worker, or @ref getSize for a thread
+   * that is not a worker, which only steals.
+   * @param[out] task  Task that was taken.
+   * @return true A task was taken.
+   * @return false  No task is pending.
+   */
+  bool takeTask(const size_t worker, Task& task);
+
+  /**
+   * @brief Takes a pending task of a group of @ref run.
+   *
+   * @param[in] group  Group of the task.
+   * @param[out] task  Task that was taken.
+   * @return true A task was taken.
+   * @return false  No task of the group is pending.
+   */
+  bool takeGroupTask(const void* group, Task& task);
+
+  /**
+   * @brief Pushes a task to a queue and wakes a worker.
+   *
+   * @param[in,out] task  Task to push. It is moved from only if it was
+   * pushed.
+   * @return true The task was pushed.
+   * @return false  The pool is stopped or was not started; the caller has
+   * to execute the task itself.
+   */
+  bool push(Task& task);
+
+  /**
+   * @brief Executes a task and updates the counters of its subsystem.
+   */
+  void execute(const ThreadPoolSubsystem subsystem,
+               const std::function<void()>& function);
+
+  /**
+   * @brief Main loop of a worker.
+   */
+  void workerLoop(const size_t worker);
+
+  std::vector<std::unique_ptr<WorkerQueue>> _queues;  //!< Queue per worker.
+  std::vector<std::thread> _threads;                   //!< Workers.
+  std::mutex _wake_mutex;  //!< Protects the waiting of idle workers.
+  std::condition_variable _wake;     //!< Wakes idle workers.
+  std::atomic<size_t> _n_pending;    //!< Number of tasks in all queues.
+  std::atomic<size_t> _next_queue;   //!< Queue of the next external task.
+  bool _stop;                        //!< Whether the workers should stop.
+  std::chrono::steady_clock::time_point _start_time;  //!< Start of the pool.
+  std::array<std::atomic<uint64_t>, kNumberOfThreadPoolSubsystems>
+      _n_tasks;  //!< Number of executed tasks per subsystem.
+  std::array<std::atomic<uint64_t>, kNumberOfThreadPoolSubsystems>
+      _busy_nanoseconds;  //!< Run-time of the tasks per subsystem.
+};
+
+/**
+ * @brief Executes a function on several threads and waits until all of them
+ * returned.
+ *
+ * If a started pool is given, its workers are used. Otherwise a thread is
+ * started for each call but the first, which is executed by the calling
+ * thread.
+ *
+ * @param[in] thread_pool  Pool, or nullptr.
+ * @param[in] subsystem  Subsystem the calls are counted for.
+ * @param[in] n_workers  Number of calls.
+ * @param[in] work  Function that is called with the indices
+ * 0, ..., n_workers - 1.
+ */
+void runInParallel(AMR::ThreadPool* thread_pool,
+                   const ThreadPoolSubsystem subsystem, const size_t n_workers,
+                   const std::function<void(size_t)>& work);
+
+/**
+ * @brief Determines the number of threads used by a parallel routine.
+ *
+ * @param[in] n_threads  Number of threads requested by the caller. If it is
+ * 0, the size of the pool is used, or the number of hardware threads if
+ * there is no started pool.
+ * @param[in] thread_pool  Pool, or nullptr.
+ * @return Number of threads, at least 1.
+ */
+unsigned int resolveThreadCount(const unsigned int n_threads,
+                                const AMR::ThreadPool* thread_pool);
+
+}  // namespace AMR
+
+#endif  // INCLUDE_THREAD_POOL_HPP_
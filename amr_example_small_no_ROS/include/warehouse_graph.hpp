@@ -0,0 +1,158 @@
+/** @file warehouse_graph.hpp
+ * @brief Defines the graph of aisles on which the AMR units travel, which
+ * replaces the straight-line distances if it is configured.
+ */
+
+#ifndef INCLUDE_WAREHOUSE_GRAPH_HPP_
+#define INCLUDE_WAREHOUSE_GRAPH_HPP_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "basic_structs.hpp"
+#include "thread_pool.hpp"
+
+namespace AMR {
+
+/**
+ * @brief Undirected graph of aisle nodes with a precomputed table of travel
+ * distances from every pickup location of the catalog.
+ *
+ * Units cannot drive through racks, so the travel distance between two points
+ * is the length of the shortest path through the aisles: a point is
+ * connected in a straight line to its closest aisle node, and the nodes are
+ * connected by the edges of the graph. The graph is read from a yaml file of
+ * the form
+ *
+ *     nodes:
+ *       - {id: 0, cx: 0.0, cy: 0.0}
+ *       - {id: 1, cx: 0.0, cy: 100.0}
+ *     edges:
+ *       - {from: 0, to: 1}
+ *       - {from: 1, to: 2, length: 25.0}
+ *
+ * where the length of an edge defaults to the straight-line distance of its
+ * nodes. For every distinct pickup location, Dijkstra's algorithm is run once
+ * from its aisle node, and the distances to all nodes as well as the next
+ * node on the way back to the location are stored.
+ */
+class WarehouseGraph {
+ public:
+  /**
+   * @brief Construct a new, empty graph.
+   */
+  WarehouseGraph(){};
+
+  /**
+   * @brief Reads the graph from a yaml file.
+   *
+   * @param[in] file_path  Path to the graph file.
+   * @return true The graph was read.
+   * @return false  The file does not exist or is invalid; the graph is empty.
+   */
+  bool load(const std::string& file_path);
+
+  /**
+   * @brief Computes the distance table for the locations of all product
+   * parts. Parts with identical coordinates share a location.
+   *
+   * @param[in] all_product_parts  Vector containing all available parts.
+   * @param[in] n_threads  Number of threads used. If it is 0, the size of
+   * @p thread_pool or the number of hardware threads is used.
+   * @param[in] thread_pool  Pool that runs the searches, or nullptr to start
+   * threads.
+   */
+  void precompute(const std::vector<AMR::ProductPart>& all_product_parts,
+                  unsigned int n_threads = 0,
+                  AMR::ThreadPool* thread_pool = nullptr);
+
+  /**
+   * @brief Checks whether a graph was read.
+   *
+   * @return true The graph has nodes.
+   * @return false  The graph is empty.
+   */
+  bool isLoaded() const { return !_nodes.empty(); }
+
+  /**
+   * @brief Get the number of aisle nodes.
+   *
+   * @return Number of nodes.
+   */
+  size_t getNumberOfNodes() const { return _nodes.size(); }
+
+  /**
+   * @brief Determines the travel distance between two points.
+   *
+   * If one of the points is a precomputed pickup location, the distance is
+   * looked up; otherwise Dijkstra's algorithm is run.
+   *
+   * @param[in] from  First point.
+   * @param[in] to  Second point.
+   * @return Travel distance. It is infinite if the points are not connected.
+   */
+  double distance(const AMR::Coordinates2D& from,
+                  const AMR::Coordinates2D& to) const;
+
+  /**
+   * @brief Determines the aisle nodes passed on the way from a point to a
+   * precomputed pickup location.
+   *
+   * @param[in] from  Starting point.
+   * @param[in] location  Pickup location.
+   * @return Indices of the aisle nodes in the order in which they are passed,
+   * starting with the node closest to @p from. It is empty if @p location is
+   * not a pickup location or cannot be reached.
+   */
+  std::vector<int> getRoute(const AMR::Coordinates2D& from,
+                            const AMR::Coordinates2D& location) const;
+
+  /**
+   * @brief Get the coordinates of an aisle node.
+   *
+   * @param[in] node  Index of the node.
+   * @return Coordinates of the node.
+   */
+  const AMR::Coordinates2D& getNode(const size_t node) const {
+    return _nodes[node];
+  }
+
+ private:
+  /**
+   * @brief Determines the aisle node closest to a point.
+   */
+  size_t closestNode(const AMR::Coordinates2D& point) const;
+
+  /**
+   * @brief Runs Dijkstra's algorithm from a node.
+   *
+   * @param[in] source  Node from which the distances are determined.
+   * @param[out] distances  Distance from @p source to each node.
+   * @param[out] predecessors  Node preceding each node on its shortest path
+   * from @p source, -1 for @p source and unreachable nodes.
+   */
+  void shortestPaths(const size_t source, double* distances,
+                     int* predecessors) const;
+
+  std::vector<AMR::Coordinates2D> _nodes;  //!< Coordinates of the nodes.
+  std::vector<size_t> _adjacency_begin;    //!< Position of the first edge of
+                                           //!< each node in @ref _adjacency.
+  std::vector<std::pair<int, double>>
+      _adjacency;  //!< Neighbor and length of all edges, grouped by node.
+  std::map<std::pair<double, double>, int>
+      _location_index;  //!< Maps pickup coordinates to their location.
+  std::vector<size_t> _location_nodes;  //!< Aisle node of each location.
+  std::vector<double> _location_offsets;  //!< Distance from each location to
+                                          //!< its aisle node.
+  std::vector<double>
+      _distances;  //!< Distance from each location's node to every node.
+  std::vector<int> _next_hops;  //!< Next node from every node towards each
+                                //!< location's node, -1 at the location.
+};
+
+}  // namespace AMR
+
+#endif  // INCLUDE_WAREHOUSE_GRAPH_HPP_
@@ -3,6 +3,7 @@
 #include <yaml-cpp/yaml.h>
 
 #include "amr_task_executors.hpp"
+#include "basic_routines.hpp"
 
 namespace AMR {
 MqttInterface::MqttInterface(const std::string host, const int port,
@@ -88,10 +89,23 @@ void mqttMessageCallback([[maybe_unused]] struct mosquitto *mosq,
                     << std::endl;
           create_new_task = false;
         }
+        // the planning budget is optional, 0 selects the default of the unit.
+        // An invalid budget is ignored, so the order is still executed
+        uint32_t planning_budget_ms = 0;
+        const YAML::Node budget_yaml = msg_yaml["planning_budget_ms"];
+        if (budget_yaml &&
+            (!budget_yaml.IsScalar() ||
+             !parsePlanningBudget(budget_yaml.Scalar(), planning_budget_ms))) {
+          std::cout << "Warning: Rejected invalid planning_budget_ms in "
+                       "message for topic /AmrUnit/nextOrder, using the "
+                       "default budget"
+                    << std::endl;
+        }
         // check if unexpected key is included and print a warning
         for (auto it = msg_yaml.begin(); it != msg_yaml.end(); ++it) {
           std::string key = it->first.as<std::string>();
-          if (key != "order_id" && key != "description") {
+          if (key != "order_id" && key != "description" &&
+              key != "planning_budget_ms") {
             std::cout << "Warning: Received message in /AmrUnit/nextOrder with "
                          "unexpected key: "
                       << key << std::endl;
@@ -101,9 +115,23 @@ void mqttMessageCallback([[maybe_unused]] struct mosquitto *mosq,
         if (create_new_task) {
           // add the received order as new task to the queue
           OrderExecutor *newOrderExecutor =
-              new OrderExecutor(order_id, description);
+              new OrderExecutor(order_id, description, planning_budget_ms);
+          // the lookup of the order starts right away, while the unit is
+          // still busy with the queued tasks. Both happen while holding the
+          // mutex, so no lookup is started after the unit saw the shutdown
+          // and stopped its thread pool
           task_queue->_mutex.lock();
-          task_queue->_queue.push(newOrderExecutor);
+          if (task_queue->_shutdown) {
+            std::cout << "Warning: Dropped order " << order_id
+                      << " received after the signal to shut down"
+                      << std::endl;
+            delete newOrderExecutor;
+          } else {
+            if (task_queue->_prefetch) {
+              task_queue->_prefetch(*newOrderExecutor);
+            }
+            task_queue->_queue.push(newOrderExecutor);
+          }
           task_queue->_mutex.unlock();
         }
       } catch (const YAML::ParserException &e) {
@@ -113,6 +141,11 @@ void mqttMessageCallback([[maybe_unused]] struct mosquitto *mosq,
         std::cout << "\"{order_id: <order_id>, description: <description>}\""
                   << std::endl;
         std::cout << e.what() << std::endl;
+      } catch (const YAML::Exception &e) {
+        // e.g. an order id that is not a number
+        std::cout << "Error: Could not read message for topic "
+                     "/AmrUnit/nextOrder: "
+                  << e.what() << std::endl;
       }
     } else if (msg_topic == "/AmrUnit/currentPosition") {
       try {
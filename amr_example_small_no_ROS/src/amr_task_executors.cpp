@@ -1,5 +1,8 @@
 #include "amr_task_executors.hpp"
 
+#include <algorithm>
+#include <memory>
+
 #include "amr_unit.hpp"
 #include "basic_routines.hpp"
 
@@ -15,21 +18,17 @@ void OrderExecutor::execute(AMR::AmrUnit& target_unit,
                             std::ostream& stream) const {
   stream << "Working on order " << _order_id << "(" << _order_description << ")"
          << std::endl;
-  // initialize data
-  AMR::Coordinates2D delivery_point;
-  std::vector<long long int> ordered_products;
-  // get the information about the order by parsing all files
-  
-  bool found_order =
-      parseAllFilesToFindOrder(target_unit.getWorkingDirectory() + "/orders",
-                               _order_id, delivery_point, ordered_products);
+  // the order was looked up when it was queued. If it was not found then,
+  // it is looked up again, since its file might have been published since
+  const ResolvedOrder resolved_order =
+      _resolved_order.valid() && _resolved_order.get()._found
+          ? _resolved_order.get()
+          : resolveOrder(target_unit, _order_id);
+  const AMR::Coordinates2D& delivery_point = resolved_order._delivery_point;
 
-  if (found_order) {
-    AMR::ProcessedProductParts processed_product_parts;
-    // determine all the product parts and their quantities (different products
-    // can require the same parts)
-    processOrderedProducts(ordered_products, target_unit.get_all_products(),
-                           processed_product_parts);
+  if (resolved_order._found) {
+    const AMR::ProcessedProductParts& processed_product_parts =
+        resolved_order._processed_product_parts;
     // get the coordinates of the processed product parts and an auxiliary
     // structure to access the map entries according to their position (this is
     // not clever. it would probably be better to use a vector instead of a map
@@ -49,12 +48,49 @@ void OrderExecutor::execute(AMR::AmrUnit& target_unit,
       ++counter;
     }
 
-    // determine the pickup order (geometrically shortest path!)
+    // determine the pickup order (geometrically shortest path!), unless the
+    // same parts were already collected between the same points
     std::vector<int> pickup_order;
+    std::vector<long long int> pickup_part_ids;
     AMR::Coordinates2D starting_point =
         target_unit.getCurrentPosition()._coords_2d;
-    determineShortestPath(starting_point, parts_positions, delivery_point,
-                          pickup_order);
+    AMR::PathCache& path_cache = target_unit.getPathCache();
+    if (path_cache.find(processed_product_parts_position_to_key,
+                        starting_point, delivery_point, pickup_part_ids)) {
+      // the part ids are sorted, so their positions are found by bisection
+      for (long long int part_id : pickup_part_ids) {
+        pickup_order.push_back(static_cast<int>(
+            std::lower_bound(processed_product_parts_position_to_key.begin(),
+                             processed_product_parts_position_to_key.end(),
+                             part_id) -
+            processed_product_parts_position_to_key.begin()));
+      }
+    } else {
+      AMR::PathSolverOptions options = target_unit.getPathSolverOptions();
+      if (_planning_budget_ms > 0) {
+        options._planning_budget_ms = _planning_budget_ms;
+      }
+      options._thread_pool = &target_unit.getThreadPool();
+      const AMR::WarehouseGraph& warehouse_graph =
+          target_unit.getWarehouseGraph();
+      bool reusable = false;
+      AMR::PathSolverResult result = determineOrderPath(
+          starting_point, parts_positions, delivery_point, pickup_order,
+          options, &target_unit.getCatalogPathTable(),
+          &target_unit.getCatalogDistances(),
+          warehouse_graph.isLoaded() ? &warehouse_graph : nullptr, reusable);
+      if (!result._proven_optimal) {
+        stream << "Note: The path might not be the shortest one" << std::endl;
+      }
+      if (reusable) {
+        for (int position : pickup_order) {
+          pickup_part_ids.push_back(
+              processed_product_parts_position_to_key[position]);
+        }
+        path_cache.insert(processed_product_parts_position_to_key,
+                          starting_point, delivery_point, pickup_part_ids);
+      }
+    }
 
     // reposition the AmrUnit and print the result
     target_unit.setCurrentPosition(AMR::Position(delivery_point, 0.0));
@@ -66,6 +102,53 @@ void OrderExecutor::execute(AMR::AmrUnit& target_unit,
   }
 }
 
+void OrderExecutor::prefetch(AMR::AmrUnit& target_unit) {
+  // the task only refers to the unit, so the executor may be destroyed
+  // before the task is finished
+  const uint32_t order_id = _order_id;
+  auto task = std::make_shared<std::packaged_task<ResolvedOrder()>>(
+      [&target_unit, order_id]() {
+        return resolveOrder(target_unit, order_id);
+      });
+  _resolved_order = task->get_future().share();
+  target_unit.getThreadPool().submit(AMR::ThreadPoolSubsystem::kOrderLookup,
+                                     [task]() { (*task)(); });
+}
+
+ResolvedOrder OrderExecutor::resolveOrder(AMR::AmrUnit& target_unit,
+                                          const uint32_t order_id) {
+  ResolvedOrder resolved_order;
+  std::vector<long long int> ordered_products;
+  // get the information about the order from the compiled store or from its
+  // record in the index. If the index is not built or outdated, all files
+  // are parsed
+  const AMR::OrderStore& order_store = target_unit.getOrderStore();
+  const AMR::OrderIndex& order_index = target_unit.getOrderIndex();
+  AMR::OrderIndex::Status status = AMR::OrderIndex::Status::kOutdated;
+  if (order_store.lookup(order_id, resolved_order._delivery_point,
+                         ordered_products)) {
+    status = AMR::OrderIndex::Status::kFound;
+  } else if (order_index.isBuilt()) {
+    status = order_index.lookup(order_id, resolved_order._delivery_point,
+                                ordered_products);
+  }
+  resolved_order._found = status == AMR::OrderIndex::Status::kFound;
+  if (status == AMR::OrderIndex::Status::kOutdated) {
+    resolved_order._found = parseAllFilesToFindOrder(
+        target_unit.getWorkingDirectory() + "/orders", order_id,
+        resolved_order._delivery_point, ordered_products,
+        &target_unit.getThreadPool(), nullptr,
+        &target_unit.getOrderFileFilters());
+  }
+  if (resolved_order._found) {
+    // determine all the product parts and their quantities (different
+    // products can require the same parts)
+    processOrderedProducts(ordered_products, target_unit.get_all_products(),
+                           resolved_order._processed_product_parts);
+  }
+  return resolved_order;
+}
+
 void OrderExecutor::printDeliveryPath(
     const Coordinates2D& starting_point, const Coordinates2D& delivery_point,
     const std::vector<int>& pickup_order,
@@ -97,7 +180,7 @@ void OrderExecutor::printDeliveryPath(
 void OrderExecutor::processOrderedProducts(
     const std::vector<long long int>& ordered_products,
     const std::vector<AMR::Product>& all_products,
-    AMR::ProcessedProductParts& processed_product_parts) const {
+    AMR::ProcessedProductParts& processed_product_parts) {
   processed_product_parts.clear();
   for (size_t i = 0; i < ordered_products.size(); ++i) {
     long long int current_product_id = ordered_products[i];
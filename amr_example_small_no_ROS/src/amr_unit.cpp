@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <thread>
+#include <unordered_set>
 
 #include "basic_routines.hpp"
 
@@ -9,10 +10,18 @@ namespace AMR {
 AmrUnit::AmrUnit(std::string working_directory,
                  const std::string mqtt_client_id, const std::string host,
                  const int port, AMR::Position starting_position)
-    : _current_position(starting_position),
-      _working_directory(working_directory) {
+    : _thread_pool_size(0),
+      _current_position(starting_position),
+      _working_directory(working_directory),
+      _catalog_distance_memory_cap(0),
+      _order_index_path(working_directory + "/orders/.order_index"),
+      _order_store_path(working_directory + "/orders/orders.store"),
+      _path_cache_preload_days(0) {
   _task_queue = new TaskQueue();
   _task_queue->_shutdown = false;
+  _task_queue->_prefetch = [this](OrderExecutor& order_executor) {
+    order_executor.prefetch(*this);
+  };
   _interface = new MqttInterface(host, port, mqtt_client_id, _task_queue);
 }
 
@@ -21,10 +30,124 @@ AmrUnit::~AmrUnit() {
   delete _interface;
 }
 
-void AmrUnit::run() {
+std::vector<uint32_t> AmrUnit::findOrders(
+    const std::vector<uint32_t>& order_ids,
+    std::vector<AMR::OrderInformation>& orders) {
+  orders.assign(order_ids.size(), AMR::OrderInformation());
+  std::vector<size_t> remaining;
+  for (size_t i = 0; i < order_ids.size(); ++i) {
+    orders[i]._found =
+        _order_store.lookup(order_ids[i], orders[i]._delivery_point,
+                            orders[i]._ordered_products);
+    if (!orders[i]._found) {
+      remaining.push_back(i);
+    }
+  }
+  // the index answers all orders whose files did not change
+  if (_order_index.isBuilt() && !remaining.empty()) {
+    std::vector<uint32_t> remaining_ids;
+    for (const size_t i : remaining) {
+      remaining_ids.push_back(order_ids[i]);
+    }
+    std::vector<AMR::OrderInformation> index_orders;
+    const std::vector<OrderIndex::Status> statuses =
+        _order_index.lookup(remaining_ids, index_orders);
+    std::vector<size_t> outdated;
+    for (size_t j = 0; j < remaining.size(); ++j) {
+      if (statuses[j] == OrderIndex::Status::kOutdated) {
+        outdated.push_back(remaining[j]);
+      } else {
+        orders[remaining[j]] = std::move(index_orders[j]);
+      }
+    }
+    remaining.swap(outdated);
+  }
+  if (!remaining.empty()) {
+    std::vector<uint32_t> remaining_ids;
+    for (const size_t i : remaining) {
+      remaining_ids.push_back(order_ids[i]);
+    }
+    std::vector<AMR::OrderInformation> file_orders;
+    parseAllFilesToFindOrders(_working_directory + "/orders", remaining_ids,
+                              file_orders, &_thread_pool);
+    for (size_t j = 0; j < remaining.size(); ++j) {
+      orders[remaining[j]] = std::move(file_orders[j]);
+    }
+  }
+  // every missing id is reported once, at its first occurrence
+  std::vector<uint32_t> missing_order_ids;
+  std::unordered_set<uint32_t> reported;
+  for (size_t i = 0; i < order_ids.size(); ++i) {
+    if (!orders[i]._found && reported.insert(order_ids[i]).second) {
+      missing_order_ids.push_back(order_ids[i]);
+    }
+  }
+  return missing_order_ids;
+}
+
+void AmrUnit::initialize() {
+  _thread_pool.start(_thread_pool_size);
   // first, parse all products in the appropriate file
   parseConfigurationFiles(_working_directory + "/configuration", _all_products,
                           _all_product_parts);
+  parseSettingsFile(_working_directory + "/configuration",
+                    _path_solver_options);
+  _catalog_distances.build(_all_product_parts, _catalog_distance_memory_cap,
+                           _path_solver_options._distance_metric);
+  // without a graph of the aisles, the straight-line distances are used
+  const AMR::WarehouseGraph* warehouse_graph = nullptr;
+  if (_warehouse_graph.load(_working_directory +
+                            "/configuration/warehouse_graph.yaml")) {
+    _warehouse_graph.precompute(_all_product_parts, 0, &_thread_pool);
+    warehouse_graph = &_warehouse_graph;
+    std::cout << "Loaded warehouse graph with "
+              << _warehouse_graph.getNumberOfNodes() << " aisle nodes"
+              << std::endl;
+  } else if (_catalog_path_table.build(
+                 _all_product_parts,
+                 _path_solver_options._catalog_table_max_locations, 0,
+                 _path_solver_options._distance_metric, &_thread_pool)) {
+    // the table is based on straight-line distances
+    std::cout << "Built path table for "
+              << _catalog_path_table.getNumberOfLocations()
+              << " pickup locations" << std::endl;
+  }
+  // an order is then found without parsing all order files
+  size_t n_scanned =
+      _order_index.build(_working_directory + "/orders", _order_index_path,
+                         &_thread_pool);
+  std::cout << "Indexed " << _order_index.size() << " orders in "
+            << _order_index.getNumberOfFiles() << " files (" << n_scanned
+            << " scanned)" << std::endl;
+  // orders contained in the compiled store are found without any file access
+  if (!_order_store_path.empty() && _order_store.open(_order_store_path)) {
+    std::cout << "Opened order store with " << _order_store.size()
+              << " orders" << std::endl;
+  }
+  // searches in the files skip those that cannot contain the order
+  size_t n_filtered = _order_file_filters.build(_working_directory + "/orders");
+  std::cout << "Built order id filters of " << n_filtered << " files"
+            << std::endl;
+  // new and appended order files are indexed while the unit is running
+  if (_order_watcher.start(_working_directory + "/orders", _order_index,
+                           &_order_file_filters)) {
+    std::cout << "Watching " << _working_directory << "/orders for new orders"
+              << std::endl;
+  }
+  if (_path_cache_preload_days > 0) {
+    AMR::PathSolverOptions options = _path_solver_options;
+    options._thread_pool = &_thread_pool;
+    size_t n_preloaded = _path_cache.preload(
+        _working_directory + "/orders", _path_cache_preload_days,
+        _all_products, _all_product_parts, _current_position._coords_2d,
+        options, &_catalog_path_table, &_catalog_distances, warehouse_graph);
+    std::cout << "Preloaded " << n_preloaded << " orders into the path cache"
+              << std::endl;
+  }
+}
+
+void AmrUnit::run() {
+  initialize();
   _interface->run();
 
   _task_queue->_mutex.lock();
@@ -54,6 +177,18 @@ void AmrUnit::run() {
   }
 
   std::cout << "Received signal to shut down. Terminating." << std::endl;
+  _order_watcher.stop();
+  for (size_t i = 0; i < kNumberOfThreadPoolSubsystems; ++i) {
+    const ThreadPoolSubsystem subsystem = static_cast<ThreadPoolSubsystem>(i);
+    const ThreadPoolStatistics statistics =
+        _thread_pool.getStatistics(subsystem);
+    std::cout << "Thread pool use by " << getSubsystemName(subsystem) << ": "
+              << statistics._n_tasks << " tasks, "
+              << statistics._busy_seconds << " s busy ("
+              << 100.0 * statistics._utilization << "% utilization)"
+              << std::endl;
+  }
+  _thread_pool.stop();
 }
 
 }  // namespace AMR
\ No newline at end of file
@@ -1,10 +1,15 @@
 #include "basic_routines.hpp"
 #include "basic_structs.hpp"
+#include "order_file_scanner.hpp"
+#include "path_solvers.hpp"
+#include "small_path_solvers.hpp"
 #include <mutex>    //  std::mutex
 #include <thread>   //  std::thread
 #include <math.h>
 #include <string>
 #include <algorithm>
+#include <charconv>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <numeric>
@@ -16,56 +21,184 @@ double AMR::determinePathLength(
     const AMR::Coordinates2D &starting_point,
     const std::vector<Coordinates2D> &part_locations,
     const AMR::Coordinates2D &delivery_point,
-    const std::vector<int> &pickup_order) {
-  // compute the distance between the starting point and the first part location
-  double x_diff = part_locations[pickup_order[0]]._x - starting_point._x;
-  double y_diff = part_locations[pickup_order[0]]._y - starting_point._y;
-  double path_length = sqrt(x_diff * x_diff + y_diff * y_diff);
-  // add the distances between all the parts in the specified order
-  for (size_t i = 0; i < pickup_order.size() - 1; ++i) {
-    x_diff = part_locations[pickup_order[i + 1]]._x -
-             part_locations[pickup_order[i]]._x;
-    y_diff = part_locations[pickup_order[i + 1]]._y -
-             part_locations[pickup_order[i]]._y;
-    path_length += sqrt(x_diff * x_diff + y_diff * y_diff);
-  }
-  // add the distance between the last part and the delivery point
-  x_diff = delivery_point._x - part_locations.back()._x;
-  y_diff = delivery_point._y - part_locations.back()._y;
-  path_length += sqrt(x_diff * x_diff + y_diff * y_diff);
-  return path_length;
+    const std::vector<int> &pickup_order, const AMR::DistanceMetric metric) {
+  return dispatchMetric(metric, [&](auto policy) {
+    return determinePathLength<decltype(policy)>(
+        starting_point, part_locations, delivery_point, pickup_order);
+  });
+}
+
+void AMR::collapseColocatedLocations(
+    const std::vector<Coordinates2D> &part_locations, const double epsilon,
+    std::vector<Coordinates2D> &route_nodes,
+    std::vector<int> &node_of_location) {
+  route_nodes.clear();
+  node_of_location.resize(part_locations.size());
+  for (size_t i = 0; i < part_locations.size(); ++i) {
+    const Coordinates2D &location = part_locations[i];
+    auto node_iter = std::find_if(
+        route_nodes.begin(), route_nodes.end(),
+        [&location, epsilon](const Coordinates2D &node) {
+          return fabs(node._x - location._x) <= epsilon &&
+                 fabs(node._y - location._y) <= epsilon;
+        });
+    if (node_iter == route_nodes.end()) {
+      route_nodes.push_back(location);
+      node_iter = route_nodes.end() - 1;
+    }
+    node_of_location[i] =
+        static_cast<int>(std::distance(route_nodes.begin(), node_iter));
+  }
+}
+
+void AMR::expandRouteOrder(const std::vector<int> &route_order,
+                           const std::vector<int> &node_of_location,
+                           std::vector<int> &pickup_order) {
+  std::vector<std::vector<int>> locations_of_node(route_order.size());
+  for (size_t i = 0; i < node_of_location.size(); ++i) {
+    locations_of_node[node_of_location[i]].push_back(static_cast<int>(i));
+  }
+  pickup_order.clear();
+  for (int node : route_order) {
+    pickup_order.insert(pickup_order.end(), locations_of_node[node].begin(),
+                        locations_of_node[node].end());
+  }
 }
 
 void AMR::determineShortestPath(
     const AMR::Coordinates2D &starting_point,
     const std::vector<Coordinates2D> &part_locations,
     const AMR::Coordinates2D &delivery_point, std::vector<int> &pickup_order) {
-  // first, prepare the output variable pickup_order
-  pickup_order.resize(part_locations.size());
-  
-  // PLEASE ADD YOUR IMPLEMENTATION HERE
-  // EXPLANATION: The vector pickup_order should be filled with integers that indicate 
-  // in which order the parts in the vector part_locations should be picked up. For example, 
-  // if part_locations contains 3 locations, a possible output would be {1,0,2}. This would 
-  // mean that the shortest path is: 
-  // starting_point, part_locations[1], part_locations[0], part_locations[2], delivery_point
-
-  std::iota(pickup_order.begin(), pickup_order.end(), 0);
-
-  double shortestPathLength = std::numeric_limits<double>::max();
-  std::vector<int> bestOrder = pickup_order;
-
-  // Find the one with the shortest path
-  do {
-      double currentPathLength = determinePathLength(starting_point, part_locations, delivery_point, pickup_order);
-      if (currentPathLength < shortestPathLength) {
-          shortestPathLength = currentPathLength;
-          bestOrder = pickup_order;
-      }
-  } while (std::next_permutation(pickup_order.begin(), pickup_order.end()));
+  determineShortestPath(starting_point, part_locations, delivery_point,
+                        pickup_order, PathSolverOptions());
+}
 
-  // Set pickup_order to the best found order
-  pickup_order = bestOrder;
+AMR::PathSolverResult AMR::determineShortestPath(
+    const AMR::Coordinates2D &starting_point,
+    const std::vector<Coordinates2D> &part_locations,
+    const AMR::Coordinates2D &delivery_point, std::vector<int> &pickup_order,
+    const PathSolverOptions &options,
+    const CatalogDistanceMatrix *catalog_distances,
+    const WarehouseGraph *warehouse_graph) {
+  // parts on the same shelf are picked up together, so they only form one
+  // node of the route
+  std::vector<Coordinates2D> route_nodes;
+  std::vector<int> node_of_location;
+  collapseColocatedLocations(part_locations, options._colocation_epsilon,
+                             route_nodes, node_of_location);
+  std::vector<int> route_order;
+  PathSolverResult result(0.0, true);
+  if (warehouse_graph) {
+    result = determineShortestPath(DistanceMatrix(starting_point, route_nodes,
+                                                  delivery_point,
+                                                  *warehouse_graph),
+                                   route_order, options);
+  } else if (route_nodes.size() <=
+             std::min(options._heuristic_cutoff, kSmallSolverDispatchLimit)) {
+    result._path_length =
+        solveSmall(starting_point, route_nodes, delivery_point, route_order,
+                   options._distance_metric);
+  } else if (catalog_distances &&
+             catalog_distances->getMetric() == options._distance_metric) {
+    result = determineShortestPath(DistanceMatrix(starting_point, route_nodes,
+                                                  delivery_point,
+                                                  *catalog_distances),
+                                   route_order, options);
+  } else {
+    result = determineShortestPath(
+        DistanceMatrix(starting_point, route_nodes, delivery_point,
+                       options._distance_metric),
+        route_order, options);
+  }
+  if (route_nodes.size() == part_locations.size()) {
+    // nothing was merged, so the route nodes are the part locations
+    pickup_order = std::move(route_order);
+    return result;
+  }
+  expandRouteOrder(route_order, node_of_location, pickup_order);
+  // the route nodes are only close to the merged locations
+  if (warehouse_graph) {
+    result._path_length =
+        DistanceMatrix(starting_point, part_locations, delivery_point,
+                       *warehouse_graph)
+            .determinePathLength(pickup_order.data());
+  } else {
+    result._path_length =
+        determinePathLength(starting_point, part_locations, delivery_point,
+                            pickup_order, options._distance_metric);
+  }
+  return result;
+}
+
+AMR::PathSolverResult AMR::determineOrderPath(
+    const AMR::Coordinates2D &starting_point,
+    const std::vector<Coordinates2D> &part_locations,
+    const AMR::Coordinates2D &delivery_point, std::vector<int> &pickup_order,
+    const AMR::PathSolverOptions &options,
+    const AMR::CatalogPathTable *catalog_table,
+    const AMR::CatalogDistanceMatrix *catalog_distances,
+    const AMR::WarehouseGraph *warehouse_graph, bool &reusable) {
+  // small catalogs are answered by the precomputed table
+  double path_length = 0.0;
+  if (catalog_table &&
+      catalog_table->solve(starting_point, part_locations, delivery_point,
+                           pickup_order, path_length)) {
+    reusable = true;
+    return PathSolverResult(path_length, true);
+  }
+  PathSolverResult result = determineShortestPath(
+      starting_point, part_locations, delivery_point, pickup_order, options,
+      catalog_distances, warehouse_graph);
+  reusable = result._proven_optimal || options._planning_budget_ms == 0;
+  return result;
+}
+
+AMR::PathSolverResult AMR::determineShortestPath(
+    const AMR::DistanceMatrix &distances, std::vector<int> &pickup_order,
+    const PathSolverOptions &options) {
+  // The exact solvers are exponential in the number of part locations, so
+  // larger orders are solved heuristically.
+  const size_t exact_cutoff =
+      std::min(options._heuristic_cutoff, kHeldKarpMaxLocations);
+  if (distances.getNumberOfParts() > exact_cutoff) {
+    double path_length =
+        solveHeuristic(distances, pickup_order, options._neighbor_list_size);
+    return PathSolverResult(path_length, false);
+  }
+  auto solve_exactly = [&](std::vector<int> &order, const Deadline *deadline) {
+    switch (options._exact_solver) {
+      case ExactSolver::kBranchAndBound:
+        return solveBranchAndBound(distances, order,
+                                   LowerBound::kMinimumSpanningTree, nullptr,
+                                   deadline);
+      case ExactSolver::kExhaustive:
+        return solveExhaustive(distances, order, 0, deadline,
+                               options._thread_pool);
+      default:
+        return solveHeldKarp(distances, order, 0, deadline,
+                             options._thread_pool);
+    }
+  };
+  if (options._planning_budget_ms == 0) {
+    return PathSolverResult(solve_exactly(pickup_order, nullptr), true);
+  }
+
+  // A heuristic path is available after a few microseconds, so there is a
+  // good answer even if the exact solver is stopped early.
+  const Deadline deadline(
+      std::chrono::milliseconds(options._planning_budget_ms));
+  std::vector<int> heuristic_order;
+  const double heuristic_length = solveHeuristic(
+      distances, heuristic_order, options._neighbor_list_size);
+  const double exact_length = solve_exactly(pickup_order, &deadline);
+  if (!deadline.isReached()) {
+    return PathSolverResult(exact_length, true);
+  }
+  if (heuristic_length < exact_length) {
+    pickup_order = heuristic_order;
+    return PathSolverResult(heuristic_length, false);
+  }
+  return PathSolverResult(exact_length, false);
 }
 
 void AMR::parseConfigurationFiles(
@@ -127,65 +260,280 @@ void AMR::parseConfigurationFiles(
   }
 }
 
+bool AMR::parseSettingsFile(const std::string &dir_path,
+                            AMR::PathSolverOptions &options) {
+  std::string settings_file = dir_path + "/settings.yaml";
+  std::ifstream fin(settings_file);
+  if (!fin.is_open()) {
+    // the settings are optional
+    return true;
+  }
+  try {
+    YAML::Node settings_doc = YAML::Load(fin);
+    if (settings_doc["distance_metric"]) {
+      std::string metric_name =
+          settings_doc["distance_metric"].as<std::string>();
+      if (!parseDistanceMetric(metric_name, options._distance_metric)) {
+        std::cout << "Error: Unknown distance metric " << metric_name
+                  << " in " << settings_file << std::endl;
+        return false;
+      }
+    }
+  } catch (const YAML::Exception &e) {
+    std::cout << "Error: Could not read " << settings_file << ": " << e.what()
+              << std::endl;
+    return false;
+  }
+  return true;
+}
 
 
-void AMR::parseSingleFile(const std::string& file_path, const uint32_t order_id, AMR::Coordinates2D& delivery_point,
-                          std::vector<long long int>& ordered_products, std::mutex& mutex, bool& order_found) {
+bool AMR::parsePlanningBudget(const std::string &text,
+                              uint32_t &planning_budget_ms) {
+  planning_budget_ms = 0;
+  const char *end = text.data() + text.size();
+  const std::from_chars_result result =
+      std::from_chars(text.data(), end, planning_budget_ms);
+  if (result.ec != std::errc() || result.ptr != end || text.empty()) {
+    planning_budget_ms = 0;
+    return false;
+  }
+  return true;
+}
 
-    YAML::Node orders = YAML::LoadFile(file_path);
+bool AMR::isOrderFileName(const std::string &file_name) {
+  return file_name.size() > 12 && file_name.compare(0, 7, "orders_") == 0 &&
+         file_name.compare(file_name.size() - 5, 5, ".yaml") == 0;
+}
 
-    for (const auto& order : orders) {
-        if (order["order"].as<uint32_t>() == order_id) {
+std::vector<std::string> AMR::listOrderFiles(const std::string &dir_path) {
+  std::vector<std::string> file_names;
+  std::error_code error;
+  for (std::filesystem::directory_iterator entry_iter(dir_path, error), end;
+       !error && entry_iter != end; entry_iter.increment(error)) {
+    if (entry_iter->is_regular_file() &&
+        isOrderFileName(entry_iter->path().filename().string())) {
+      file_names.push_back(entry_iter->path().string());
+    }
+  }
+  std::sort(file_names.begin(), file_names.end());
+  return file_names;
+}
 
-            std::lock_guard<std::mutex> lock(mutex);
-            delivery_point._x = order["cx"].as<double>();
-            delivery_point._y = order["cy"].as<double>();
+bool AMR::parseSingleFile(const std::string &file_path, const uint32_t order_id,
+                          AMR::Coordinates2D &delivery_point,
+                          std::vector<long long int> &ordered_products,
+                          AMR::OrderSearchToken *token, const size_t file) {
+  // the mapped file is scanned without building a yaml document. Only files
+  // in another layout are parsed by yaml-cpp
+  AMR::MappedFile mapped_file;
+  if (!mapped_file.open(file_path)) {
+    std::cout << "Error: Could not read " << file_path << std::endl;
+    return false;
+  }
+  AMR::ScanResult result =
+      scanOrderFile(mapped_file.data(), mapped_file.size(), order_id,
+                    delivery_point, ordered_products, token, file);
+  if (result != AMR::ScanResult::kRejected) {
+    return result == AMR::ScanResult::kFound;
+  }
 
-            for (const auto& product : order["products"]) {
-                ordered_products.push_back(product.as<long long int>());
-            }
-            order_found = true;
-            break;
+  if (token != nullptr && token->isStopped(file)) {
+    return false;
+  }
+  try {
+    YAML::Node orders = YAML::LoadFile(file_path);
+    for (const auto &order : orders) {
+      if (token != nullptr && token->isStopped(file)) {
+        return false;
+      }
+      if (order["order"].as<uint32_t>() == order_id) {
+        delivery_point._x = order["cx"].as<double>();
+        delivery_point._y = order["cy"].as<double>();
+        for (const auto &product : order["products"]) {
+          ordered_products.push_back(product.as<long long int>());
+        }
+        if (token != nullptr) {
+          token->reportHit(file);
         }
+        return true;
+      }
     }
+  } catch (const YAML::Exception &e) {
+    std::cout << "Error: Could not read " << file_path << ": " << e.what()
+              << std::endl;
+  }
+  return false;
 }
 
 bool AMR::parseAllFilesToFindOrder(
     const std::string &dir_path, const uint32_t order_id,
     AMR::Coordinates2D &delivery_point,
-    std::vector<long long int> &ordered_products) {
-  // the number of files and the names of the files is hardcoded here. It
-  // could be retrieved by using std::filesystem routines
-  int n_files = 5;
-  std::vector<std::string> file_names = {
-      dir_path + "/orders_20201201.yaml", dir_path + "/orders_20201202.yaml",
-      dir_path + "/orders_20201203.yaml", dir_path + "/orders_20201204.yaml",
-      dir_path + "/orders_20201205.yaml"};
-
-  // PLEASE ADD YOUR IMPLEMENTATION HERE
-  // EXPLANATION: The user provides dir_path and order_id as input variables.
-  // It is your task to parse the different files (in parallel) to see if any of them 
-  // contains an order whose id is 'order_id'. If an order with this id is found, the 
-  // corresponding delivery point coordinates (specified by cx and cy) should be parsed 
-  // and written to the output variable delivery_point. Furthermore, the list of products 
-  // should be parsed and the product ids should be inserted in the output vector 
-  // ordered_products. 
-  // If the order_id has not been found, these output values do not have to be set.
-  // The routine should return a boolean indicating whether the order id was found or not.
-
-  std::mutex mutex;
-  bool order_found = false;
-  std::vector<std::thread> threads;
-
-  for (const auto& file_name : file_names) {
-
-      threads.emplace_back(std::thread(&AMR::parseSingleFile, file_name, order_id, std::ref(delivery_point),
-                                       std::ref(ordered_products), std::ref(mutex), std::ref(order_found)));
-
-  }
-    for (auto& t : threads) {
-        t.join();
+    std::vector<long long int> &ordered_products,
+    AMR::ThreadPool *thread_pool, const AMR::OrderStore *order_store,
+    const AMR::OrderFileFilters *order_file_filters) {
+  if (order_store != nullptr &&
+      order_store->lookup(order_id, delivery_point, ordered_products)) {
+    return true;
+  }
+  // the files are listed on every call, so new daily files are searched
+  // as soon as they are published. Files that cannot contain the order are
+  // skipped, which keeps the order of the others
+  std::vector<std::string> file_names = listOrderFiles(dir_path);
+  if (order_file_filters != nullptr) {
+    file_names = order_file_filters->selectFiles(file_names, order_id);
+  }
+
+  // every chunk is searched by its own task, which writes into its own
+  // result slot. The chunks are numbered in the order of the file names and
+  // of their content, so the first chunk that contains the order wins, and
+  // the searches of all later chunks are stopped
+  struct ChunkResult {
+    AMR::ScanResult _result = AMR::ScanResult::kNotFound;
+    AMR::Coordinates2D _delivery_point;
+    std::vector<long long int> _ordered_products;
+  };
+  std::vector<AMR::MappedFile> mapped_files(file_names.size());
+  const std::vector<AMR::OrderFileChunk> chunks = splitOrderFiles(
+      file_names, resolveThreadCount(0, thread_pool), mapped_files);
+  std::vector<ChunkResult> results(chunks.size());
+  AMR::OrderSearchToken token(chunks.size());
+  runInParallel(thread_pool, AMR::ThreadPoolSubsystem::kOrderLookup,
+                chunks.size(), [&](size_t chunk) {
+                  const AMR::MappedFile &mapped_file =
+                      mapped_files[chunks[chunk]._file];
+                  results[chunk]._result = scanOrderFile(
+                      mapped_file.data() + chunks[chunk]._begin,
+                      chunks[chunk]._end - chunks[chunk]._begin, order_id,
+                      results[chunk]._delivery_point,
+                      results[chunk]._ordered_products, &token, chunk);
+                });
+
+  // a file in another layout is parsed as a whole by yaml-cpp, unless an
+  // earlier chunk contains the order
+  size_t parsed_file = file_names.size();
+  for (size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+    if (results[chunk]._result == AMR::ScanResult::kFound) {
+      delivery_point = results[chunk]._delivery_point;
+      ordered_products.insert(ordered_products.end(),
+                              results[chunk]._ordered_products.begin(),
+                              results[chunk]._ordered_products.end());
+      return true;
+    }
+    if (results[chunk]._result == AMR::ScanResult::kRejected &&
+        chunks[chunk]._file != parsed_file) {
+      parsed_file = chunks[chunk]._file;
+      if (parseSingleFile(file_names[parsed_file], order_id, delivery_point,
+                          ordered_products)) {
+        return true;
+      }
     }
-    return order_found;
+  }
+  return false;
 }
 
+
+std::vector<uint32_t> AMR::parseAllFilesToFindOrders(
+    const std::string &dir_path, const std::vector<uint32_t> &order_ids,
+    std::vector<AMR::OrderInformation> &orders, AMR::ThreadPool *thread_pool,
+    const AMR::OrderStore *order_store) {
+  orders.assign(order_ids.size(), AMR::OrderInformation());
+  // every distinct id that is not in the store gets a slot
+  std::unordered_map<uint32_t, size_t> slots;
+  size_t n_slots = 0;
+  for (size_t i = 0; i < order_ids.size(); ++i) {
+    if (order_store != nullptr &&
+        order_store->lookup(order_ids[i], orders[i]._delivery_point,
+                            orders[i]._ordered_products)) {
+      orders[i]._found = true;
+    } else if (slots.emplace(order_ids[i], n_slots).second) {
+      ++n_slots;
+    }
+  }
+
+  // every chunk is searched for all slots by its own task, which writes
+  // into its own results. The first chunk (in the order of the file names
+  // and of their content) that contains an order wins
+  const std::vector<std::string> file_names =
+      slots.empty() ? std::vector<std::string>() : listOrderFiles(dir_path);
+  std::vector<AMR::MappedFile> mapped_files(file_names.size());
+  const std::vector<AMR::OrderFileChunk> chunks = splitOrderFiles(
+      file_names, resolveThreadCount(0, thread_pool), mapped_files);
+  std::vector<std::vector<AMR::OrderInformation>> chunk_orders(chunks.size());
+  std::vector<AMR::ScanResult> chunk_results(chunks.size());
+  runInParallel(thread_pool, AMR::ThreadPoolSubsystem::kOrderLookup,
+                chunks.size(), [&](size_t chunk) {
+                  const AMR::MappedFile &mapped_file =
+                      mapped_files[chunks[chunk]._file];
+                  chunk_orders[chunk].resize(n_slots);
+                  chunk_results[chunk] = scanOrderFile(
+                      mapped_file.data() + chunks[chunk]._begin,
+                      chunks[chunk]._end - chunks[chunk]._begin, slots,
+                      chunk_orders[chunk]);
+                });
+
+  // files in another layout are parsed as a whole by yaml-cpp. Their results
+  // replace those of their first chunk, and their other chunks are cleared
+  std::vector<bool> rejected_files(file_names.size(), false);
+  for (size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+    if (chunk_results[chunk] == AMR::ScanResult::kRejected) {
+      rejected_files[chunks[chunk]._file] = true;
+    }
+  }
+  std::vector<size_t> parsed_chunks;
+  for (size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+    if (rejected_files[chunks[chunk]._file]) {
+      chunk_orders[chunk].clear();
+      if (chunks[chunk]._begin == 0) {
+        parsed_chunks.push_back(chunk);
+      }
+    }
+  }
+  runInParallel(
+      thread_pool, AMR::ThreadPoolSubsystem::kOrderLookup,
+      parsed_chunks.size(), [&](size_t parsed_chunk) {
+        const size_t chunk = parsed_chunks[parsed_chunk];
+        const std::string &file_name = file_names[chunks[chunk]._file];
+        std::vector<AMR::OrderInformation> &results = chunk_orders[chunk];
+        results.resize(n_slots);
+        try {
+          for (const auto &order : YAML::LoadFile(file_name)) {
+            auto slot_iter = slots.find(order["order"].as<uint32_t>());
+            if (slot_iter == slots.end() || results[slot_iter->second]._found) {
+              continue;
+            }
+            AMR::OrderInformation &result = results[slot_iter->second];
+            result._delivery_point._x = order["cx"].as<double>();
+            result._delivery_point._y = order["cy"].as<double>();
+            for (const auto &product : order["products"]) {
+              result._ordered_products.push_back(product.as<long long int>());
+            }
+            result._found = true;
+          }
+        } catch (const YAML::Exception &e) {
+          std::cout << "Error: Could not read " << file_name << ": "
+                    << e.what() << std::endl;
+        }
+      });
+
+  std::vector<uint32_t> missing_order_ids;
+  std::vector<bool> reported(n_slots, false);
+  for (size_t i = 0; i < order_ids.size(); ++i) {
+    if (orders[i]._found) {
+      continue;
+    }
+    const size_t slot = slots[order_ids[i]];
+    for (const std::vector<AMR::OrderInformation> &results : chunk_orders) {
+      if (results.size() > slot && results[slot]._found) {
+        orders[i] = results[slot];
+        break;
+      }
+    }
+    // every missing id is reported once, at its first occurrence
+    if (!orders[i]._found && !reported[slot]) {
+      reported[slot] = true;
+      missing_order_ids.push_back(order_ids[i]);
+    }
+  }
+  return missing_order_ids;
+}
@@ -0,0 +1,113 @@
+#include "catalog_distance_matrix.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "basic_routines.hpp"
+
+namespace {
+/**
+ * @brief Number of entries of a lower triangle without diagonal with @p n
+ * rows.
+ */
+inline size_t triangleSize(const size_t n) { return n * (n - 1) / 2; }
+}  // namespace
+
+void AMR::CatalogDistanceMatrix::build(
+    const std::vector<AMR::ProductPart> &all_product_parts,
+    const size_t memory_cap_bytes, const AMR::DistanceMetric metric) {
+  _metric = metric;
+  std::vector<Coordinates2D> part_locations;
+  for (const AMR::ProductPart &part : all_product_parts) {
+    part_locations.push_back(part._coords);
+  }
+  std::vector<int> node_of_location;
+  collapseColocatedLocations(part_locations, 0.0, _locations,
+                             node_of_location);
+  _n_locations = _locations.size();
+  _location_index.clear();
+  _x.resize(_n_locations);
+  _y.resize(_n_locations);
+  for (size_t i = 0; i < _n_locations; ++i) {
+    _location_index.emplace(std::make_pair(_locations[i]._x, _locations[i]._y),
+                            static_cast<int>(i));
+    _x[i] = _locations[i]._x;
+    _y[i] = _locations[i]._y;
+  }
+  _packed.clear();
+  _tiles.clear();
+  _tile_tags.clear();
+
+  const size_t packed_bytes = triangleSize(_n_locations) * sizeof(double);
+  if (memory_cap_bytes == 0 || packed_bytes <= memory_cap_bytes) {
+    _layout = Layout::kPacked;
+    _packed.resize(triangleSize(_n_locations));
+    for (size_t i = 1; i < _n_locations; ++i) {
+      computeDistanceRow(_metric, _locations[i], _x.data(), _y.data(), i,
+                         &_packed[triangleSize(i)]);
+    }
+    return;
+  }
+  _layout = Layout::kTiled;
+  const size_t tile_bytes = kTileSize * kTileSize * sizeof(double);
+  _n_tile_slots = std::max<size_t>(1, memory_cap_bytes / tile_bytes);
+  _tiles.resize(_n_tile_slots * kTileSize * kTileSize);
+  _tile_tags.assign(_n_tile_slots, std::numeric_limits<size_t>::max());
+}
+
+int AMR::CatalogDistanceMatrix::findLocation(
+    const AMR::Coordinates2D &location) const {
+  auto location_iter =
+      _location_index.find(std::make_pair(location._x, location._y));
+  return location_iter == _location_index.end() ? -1 : location_iter->second;
+}
+
+double AMR::CatalogDistanceMatrix::lowerTriangleEntry(const size_t i,
+                                                      const size_t j) const {
+  if (_layout == Layout::kPacked) {
+    return _packed[triangleSize(i) + j];
+  }
+  // the tiles of the lower triangle are numbered row by row
+  const size_t tile_row = i / kTileSize;
+  const size_t tile_column = j / kTileSize;
+  const size_t tile = tile_row * (tile_row + 1) / 2 + tile_column;
+  const size_t slot = tile % _n_tile_slots;
+  double *tile_distances = &_tiles[slot * kTileSize * kTileSize];
+  if (_tile_tags[slot] != tile) {
+    const size_t row_begin = tile_row * kTileSize;
+    const size_t column_begin = tile_column * kTileSize;
+    const size_t row_end = std::min(_n_locations, row_begin + kTileSize);
+    const size_t column_end = std::min(_n_locations, column_begin + kTileSize);
+    for (size_t row = row_begin; row < row_end; ++row) {
+      computeDistanceRow(_metric, _locations[row], &_x[column_begin],
+                         &_y[column_begin], column_end - column_begin,
+                         &tile_distances[(row - row_begin) * kTileSize]);
+    }
+    _tile_tags[slot] = tile;
+  }
+  return tile_distances[(i % kTileSize) * kTileSize + j % kTileSize];
+}
+
+void AMR::CatalogDistanceMatrix::getDistances(
+    const std::vector<int> &locations, std::vector<double> &distances) const {
+  const size_t n = locations.size();
+  distances.assign(n * n, 0.0);
+  std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+  if (_layout == Layout::kTiled) {
+    lock.lock();
+  }
+  for (size_t a = 0; a < n; ++a) {
+    for (size_t b = 0; b < a; ++b) {
+      const size_t i = static_cast<size_t>(locations[a]);
+      const size_t j = static_cast<size_t>(locations[b]);
+      double value = 0.0;
+      if (i > j) {
+        value = lowerTriangleEntry(i, j);
+      } else if (i < j) {
+        value = lowerTriangleEntry(j, i);
+      }
+      distances[a * n + b] = value;
+      distances[b * n + a] = value;
+    }
+  }
+}
@@ -0,0 +1,205 @@
+#include "catalog_path_table.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+#include "basic_routines.hpp"
+
+namespace {
+/**
+ * @brief Removes bit @p j (which must not be set) from @p subset and shifts
+ * all higher bits down by one position.
+ */
+inline size_t compressSubset(const size_t subset, const size_t j) {
+  return (subset & ((size_t{1} << j) - 1)) | ((subset >> (j + 1)) << j);
+}
+
+/**
+ * @brief Inverse of @ref compressSubset: inserts a zero bit at position @p j.
+ */
+inline size_t expandSubset(const size_t compressed_subset, const size_t j) {
+  return (compressed_subset & ((size_t{1} << j) - 1)) |
+         ((compressed_subset >> j) << (j + 1));
+}
+}  // namespace
+
+bool AMR::CatalogPathTable::build(
+    const std::vector<AMR::ProductPart> &all_product_parts,
+    const size_t max_locations, unsigned int n_threads,
+    const AMR::DistanceMetric metric, AMR::ThreadPool *thread_pool) {
+  _metric = metric;
+  std::vector<Coordinates2D> part_locations;
+  for (const AMR::ProductPart &part : all_product_parts) {
+    part_locations.push_back(part._coords);
+  }
+  std::vector<int> node_of_location;
+  collapseColocatedLocations(part_locations, 0.0, _locations,
+                             node_of_location);
+  _n_locations = _locations.size();
+  _table.clear();
+  _location_index.clear();
+  if (_n_locations == 0 ||
+      _n_locations > std::min(max_locations, kCatalogTableMaxLocations)) {
+    return false;
+  }
+  for (size_t i = 0; i < _n_locations; ++i) {
+    _location_index.emplace(std::make_pair(_locations[i]._x, _locations[i]._y),
+                            static_cast<int>(i));
+  }
+  _distances.resize(_n_locations * _n_locations);
+  for (size_t i = 0; i < _n_locations; ++i) {
+    for (size_t j = 0; j < _n_locations; ++j) {
+      _distances[i * _n_locations + j] =
+          static_cast<float>(
+              computeDistance(_metric, _locations[i], _locations[j]));
+    }
+  }
+  _half = size_t{1} << (_n_locations - 1);
+  _table.assign(_n_locations * _half * _n_locations,
+                std::numeric_limits<float>::max());
+
+  // the entries of different first locations are independent
+  n_threads = resolveThreadCount(n_threads, thread_pool);
+  std::atomic<size_t> next_first(0);
+  runInParallel(thread_pool, ThreadPoolSubsystem::kCatalog,
+                std::min<size_t>(n_threads, _n_locations), [&](size_t) {
+                  for (size_t first = next_first++; first < _n_locations;
+                       first = next_first++) {
+                    fillFirstLocation(first);
+                  }
+                });
+  return true;
+}
+
+void AMR::CatalogPathTable::fillFirstLocation(const size_t first) {
+  const size_t m = _n_locations;
+  // the compressed subsets are visited in ascending order, so a subset is
+  // always filled after all of its proper subsets
+  for (size_t compressed = 1; compressed < _half; ++compressed) {
+    const size_t subset = expandSubset(compressed, first);
+    for (size_t last = 0; last < m; ++last) {
+      if (!(subset & (size_t{1} << last))) {
+        continue;
+      }
+      const size_t rest = subset ^ (size_t{1} << last);
+      float best = _distances[first * m + last];
+      if (rest != 0) {
+        best = std::numeric_limits<float>::max();
+        const size_t compressed_rest = compressSubset(rest, first);
+        for (size_t k = 0; k < m; ++k) {
+          if (!(rest & (size_t{1} << k))) {
+            continue;
+          }
+          float length = _table[index(first, compressed_rest, k)] +
+                         _distances[k * m + last];
+          best = length < best ? length : best;
+        }
+      }
+      _table[index(first, compressed, last)] = best;
+    }
+  }
+}
+
+bool AMR::CatalogPathTable::solve(
+    const AMR::Coordinates2D &starting_point,
+    const std::vector<Coordinates2D> &part_locations,
+    const AMR::Coordinates2D &delivery_point, std::vector<int> &pickup_order,
+    double &path_length) const {
+  if (!isAvailable()) {
+    return false;
+  }
+  const size_t m = _n_locations;
+  // map the distinct locations of the order to the locations of the catalog
+  std::vector<Coordinates2D> route_nodes;
+  std::vector<int> node_of_location;
+  collapseColocatedLocations(part_locations, 0.0, route_nodes,
+                             node_of_location);
+  std::vector<int> node_of_catalog_location(m, -1);
+  size_t order_subset = 0;
+  for (size_t node = 0; node < route_nodes.size(); ++node) {
+    auto location_iter = _location_index.find(
+        std::make_pair(route_nodes[node]._x, route_nodes[node]._y));
+    if (location_iter == _location_index.end()) {
+      return false;
+    }
+    node_of_catalog_location[location_iter->second] = static_cast<int>(node);
+    order_subset |= size_t{1} << location_iter->second;
+  }
+  if (order_subset == 0) {
+    pickup_order.clear();
+    path_length = computeDistance(_metric, starting_point, delivery_point);
+    return true;
+  }
+
+  // choose the first and the last location
+  double shortest_path_length = std::numeric_limits<double>::max();
+  size_t best_first = 0, best_last = 0;
+  for (size_t first = 0; first < m; ++first) {
+    if (!(order_subset & (size_t{1} << first))) {
+      continue;
+    }
+    const double distance_to_first =
+        computeDistance(_metric, starting_point, _locations[first]);
+    const size_t rest = order_subset ^ (size_t{1} << first);
+    if (rest == 0) {
+      double length =
+          distance_to_first +
+          computeDistance(_metric, _locations[first], delivery_point);
+      if (length < shortest_path_length) {
+        shortest_path_length = length;
+        best_first = best_last = first;
+      }
+      continue;
+    }
+    const size_t compressed_rest = compressSubset(rest, first);
+    for (size_t last = 0; last < m; ++last) {
+      if (!(rest & (size_t{1} << last))) {
+        continue;
+      }
+      double length =
+          distance_to_first + _table[index(first, compressed_rest, last)] +
+          computeDistance(_metric, _locations[last], delivery_point);
+      if (length < shortest_path_length) {
+        shortest_path_length = length;
+        best_first = first;
+        best_last = last;
+      }
+    }
+  }
+
+  // reconstruct the path backwards by repeating the minimization of the
+  // table fill
+  std::vector<int> route_order;
+  size_t subset = order_subset ^ (size_t{1} << best_first);
+  size_t current = best_last;
+  while (subset != 0) {
+    route_order.push_back(node_of_catalog_location[current]);
+    subset ^= size_t{1} << current;
+    if (subset == 0) {
+      break;
+    }
+    const size_t compressed_subset = compressSubset(subset, best_first);
+    float best = std::numeric_limits<float>::max();
+    size_t predecessor = 0;
+    for (size_t k = 0; k < m; ++k) {
+      if (!(subset & (size_t{1} << k))) {
+        continue;
+      }
+      float length = _table[index(best_first, compressed_subset, k)] +
+                     _distances[k * m + current];
+      if (length < best) {
+        best = length;
+        predecessor = k;
+      }
+    }
+    current = predecessor;
+  }
+  route_order.push_back(node_of_catalog_location[best_first]);
+  std::reverse(route_order.begin(), route_order.end());
+
+  expandRouteOrder(route_order, node_of_location, pickup_order);
+  path_length = determinePathLength(starting_point, part_locations,
+                                    delivery_point, pickup_order, _metric);
+  return true;
+}
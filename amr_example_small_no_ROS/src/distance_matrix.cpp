@@ -0,0 +1,151 @@
+#include "distance_matrix.hpp"
+
+#include <algorithm>
+
+#include "catalog_distance_matrix.hpp"
+#include "path_evaluator.hpp"
+#include "warehouse_graph.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define AMR_X86_KERNELS
+#endif
+
+AMR::SimdLevel AMR::detectSimdLevel() {
+#ifdef AMR_X86_KERNELS
+  static const SimdLevel simd_level = __builtin_cpu_supports("avx2")
+                                          ? SimdLevel::kAvx2
+                                          : SimdLevel::kSse2;
+  return simd_level;
+#else
+  return SimdLevel::kScalar;
+#endif
+}
+
+AMR::DistanceMatrix::DistanceMatrix(
+    const AMR::Coordinates2D &starting_point,
+    const std::vector<Coordinates2D> &part_locations,
+    const AMR::Coordinates2D &delivery_point, const AMR::DistanceMetric metric)
+    : _n_parts(part_locations.size()),
+      _n_nodes(part_locations.size() + 2),
+      _distances(_n_nodes * _n_nodes) {
+  std::vector<const AMR::Coordinates2D *> nodes(_n_nodes);
+  nodes[0] = &starting_point;
+  for (size_t i = 0; i < _n_parts; ++i) {
+    nodes[i + 1] = &part_locations[i];
+  }
+  nodes[_n_nodes - 1] = &delivery_point;
+  computeDistances(nodes, 0, _n_nodes, metric);
+}
+
+AMR::DistanceMatrix::DistanceMatrix(
+    const AMR::Coordinates2D &starting_point,
+    const std::vector<Coordinates2D> &part_locations,
+    const AMR::Coordinates2D &delivery_point,
+    const AMR::CatalogDistanceMatrix &catalog_distances)
+    : _n_parts(part_locations.size()),
+      _n_nodes(part_locations.size() + 2),
+      _distances(_n_nodes * _n_nodes) {
+  std::vector<const AMR::Coordinates2D *> nodes(_n_nodes);
+  std::vector<int> locations(_n_parts);
+  bool all_in_catalog = true;
+  nodes[0] = &starting_point;
+  for (size_t i = 0; i < _n_parts; ++i) {
+    nodes[i + 1] = &part_locations[i];
+    locations[i] = catalog_distances.findLocation(part_locations[i]);
+    all_in_catalog = all_in_catalog && locations[i] >= 0;
+  }
+  nodes[_n_nodes - 1] = &delivery_point;
+  const DistanceMetric metric = catalog_distances.getMetric();
+  if (!all_in_catalog) {
+    computeDistances(nodes, 0, _n_nodes, metric);
+    return;
+  }
+  std::vector<double> part_distances;
+  catalog_distances.getDistances(locations, part_distances);
+  for (size_t i = 0; i < _n_parts; ++i) {
+    std::copy(part_distances.begin() + i * _n_parts,
+              part_distances.begin() + (i + 1) * _n_parts,
+              _distances.begin() + (i + 1) * _n_nodes + 1);
+  }
+  // the distances from the starting point to all nodes, and from the part
+  // locations to the delivery point
+  computeDistances(nodes, 0, 1, metric);
+  std::vector<double> x(_n_parts), y(_n_parts);
+  for (size_t i = 0; i < _n_parts; ++i) {
+    x[i] = part_locations[i]._x;
+    y[i] = part_locations[i]._y;
+  }
+  double *delivery_row = &_distances[(_n_nodes - 1) * _n_nodes];
+  computeDistanceRow(metric, delivery_point, x.data(), y.data(), _n_parts,
+                     delivery_row + 1);
+  for (size_t i = 1; i <= _n_parts; ++i) {
+    _distances[i * _n_nodes + _n_nodes - 1] = delivery_row[i];
+  }
+}
+
+AMR::DistanceMatrix::DistanceMatrix(
+    const AMR::Coordinates2D &starting_point,
+    const std::vector<Coordinates2D> &part_locations,
+    const AMR::Coordinates2D &delivery_point,
+    const AMR::WarehouseGraph &warehouse_graph)
+    : _n_parts(part_locations.size()),
+      _n_nodes(part_locations.size() + 2),
+      _distances(_n_nodes * _n_nodes) {
+  std::vector<const AMR::Coordinates2D *> nodes(_n_nodes);
+  nodes[0] = &starting_point;
+  for (size_t i = 0; i < _n_parts; ++i) {
+    nodes[i + 1] = &part_locations[i];
+  }
+  nodes[_n_nodes - 1] = &delivery_point;
+  // the travel distances are symmetric, too
+  for (size_t i = 0; i < _n_nodes; ++i) {
+    for (size_t j = i + 1; j < _n_nodes; ++j) {
+      double distance = warehouse_graph.distance(*nodes[i], *nodes[j]);
+      _distances[i * _n_nodes + j] = distance;
+      _distances[j * _n_nodes + i] = distance;
+    }
+  }
+}
+
+void AMR::DistanceMatrix::computeDistances(
+    const std::vector<const AMR::Coordinates2D *> &nodes, const size_t begin,
+    const size_t end, const AMR::DistanceMetric metric) {
+  // the coordinates are split into two arrays, so that each row is computed
+  // by a vectorized kernel
+  std::vector<double> x(_n_nodes), y(_n_nodes);
+  for (size_t i = 0; i < _n_nodes; ++i) {
+    x[i] = nodes[i]->_x;
+    y[i] = nodes[i]->_y;
+  }
+  // the matrix is symmetric, so only the upper triangle is computed
+  for (size_t i = begin; i < end; ++i) {
+    double *row = &_distances[i * _n_nodes];
+    computeDistanceRow(metric, *nodes[i], x.data() + i + 1, y.data() + i + 1,
+                       _n_nodes - i - 1, row + i + 1);
+    for (size_t j = i + 1; j < _n_nodes; ++j) {
+      _distances[j * _n_nodes + i] = row[j];
+    }
+  }
+}
+
+double AMR::DistanceMatrix::determinePathLength(
+    const int *pickup_order) const {
+  double path_length = 0.0;
+  evaluatePathLengthBatch(_distances.data(), _n_nodes, pickup_order, 1,
+                          &path_length, SimdLevel::kScalar);
+  return path_length;
+}
+
+void AMR::DistanceMatrix::evaluatePathLengths(const int32_t *pickup_orders,
+                                              const size_t n_orders,
+                                              double *path_lengths) const {
+  evaluatePathLengths(pickup_orders, n_orders, path_lengths,
+                      detectSimdLevel());
+}
+
+void AMR::DistanceMatrix::evaluatePathLengths(
+    const int32_t *pickup_orders, const size_t n_orders, double *path_lengths,
+    const SimdLevel simd_level) const {
+  evaluatePathLengthBatch(_distances.data(), _n_nodes, pickup_orders,
+                          n_orders, path_lengths, simd_level);
+}
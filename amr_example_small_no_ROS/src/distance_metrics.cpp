@@ -0,0 +1,178 @@
+#include "distance_metrics.hpp"
+
+#include "distance_matrix.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AMR_X86_KERNELS
+#endif
+
+namespace {
+/**
+ * @brief Computes the distances one after the other.
+ */
+template <typename Metric>
+void computeDistanceRowScalar(const AMR::Coordinates2D &from, const double *x,
+                              const double *y, const size_t n,
+                              double *distances) {
+  for (size_t j = 0; j < n; ++j) {
+    distances[j] = Metric::distance(x[j] - from._x, y[j] - from._y);
+  }
+}
+
+#ifdef AMR_X86_KERNELS
+/**
+ * @brief Vectorized implementation of a metric. The operations are the same
+ * as in the scalar implementation, so the results are bitwise identical.
+ */
+template <typename Metric>
+struct SimdMetric;
+
+template <>
+struct SimdMetric<AMR::EuclideanMetric> {
+  static __m128d sse2(const __m128d x_diff, const __m128d y_diff) {
+    return _mm_sqrt_pd(
+        _mm_add_pd(_mm_mul_pd(x_diff, x_diff), _mm_mul_pd(y_diff, y_diff)));
+  }
+  __attribute__((target("avx2"))) static __m256d avx2(const __m256d x_diff,
+                                                       const __m256d y_diff) {
+    return _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(x_diff, x_diff),
+                                        _mm256_mul_pd(y_diff, y_diff)));
+  }
+};
+
+template <>
+struct SimdMetric<AMR::SquaredEuclideanMetric> {
+  static __m128d sse2(const __m128d x_diff, const __m128d y_diff) {
+    return _mm_add_pd(_mm_mul_pd(x_diff, x_diff), _mm_mul_pd(y_diff, y_diff));
+  }
+  __attribute__((target("avx2"))) static __m256d avx2(const __m256d x_diff,
+                                                       const __m256d y_diff) {
+    return _mm256_add_pd(_mm256_mul_pd(x_diff, x_diff),
+                         _mm256_mul_pd(y_diff, y_diff));
+  }
+};
+
+// the absolute value is taken by clearing the sign bit
+template <>
+struct SimdMetric<AMR::ManhattanMetric> {
+  static __m128d sse2(const __m128d x_diff, const __m128d y_diff) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    return _mm_add_pd(_mm_andnot_pd(sign, x_diff),
+                      _mm_andnot_pd(sign, y_diff));
+  }
+  __attribute__((target("avx2"))) static __m256d avx2(const __m256d x_diff,
+                                                       const __m256d y_diff) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    return _mm256_add_pd(_mm256_andnot_pd(sign, x_diff),
+                         _mm256_andnot_pd(sign, y_diff));
+  }
+};
+
+template <>
+struct SimdMetric<AMR::ChebyshevMetric> {
+  static __m128d sse2(const __m128d x_diff, const __m128d y_diff) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    return _mm_max_pd(_mm_andnot_pd(sign, x_diff),
+                      _mm_andnot_pd(sign, y_diff));
+  }
+  __attribute__((target("avx2"))) static __m256d avx2(const __m256d x_diff,
+                                                       const __m256d y_diff) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    return _mm256_max_pd(_mm256_andnot_pd(sign, x_diff),
+                         _mm256_andnot_pd(sign, y_diff));
+  }
+};
+
+/**
+ * @brief Computes two distances at once with SSE2.
+ */
+template <typename Metric>
+void computeDistanceRowSse2(const AMR::Coordinates2D &from, const double *x,
+                            const double *y, const size_t n,
+                            double *distances) {
+  const __m128d from_x = _mm_set1_pd(from._x);
+  const __m128d from_y = _mm_set1_pd(from._y);
+  size_t j = 0;
+  for (; j + 2 <= n; j += 2) {
+    const __m128d x_diff = _mm_sub_pd(_mm_loadu_pd(x + j), from_x);
+    const __m128d y_diff = _mm_sub_pd(_mm_loadu_pd(y + j), from_y);
+    _mm_storeu_pd(distances + j, SimdMetric<Metric>::sse2(x_diff, y_diff));
+  }
+  computeDistanceRowScalar<Metric>(from, x + j, y + j, n - j, distances + j);
+}
+
+/**
+ * @brief Computes four distances at once with AVX2.
+ */
+template <typename Metric>
+__attribute__((target("avx2"))) void computeDistanceRowAvx2(
+    const AMR::Coordinates2D &from, const double *x, const double *y,
+    const size_t n, double *distances) {
+  const __m256d from_x = _mm256_set1_pd(from._x);
+  const __m256d from_y = _mm256_set1_pd(from._y);
+  size_t j = 0;
+  for (; j + 4 <= n; j += 4) {
+    const __m256d x_diff = _mm256_sub_pd(_mm256_loadu_pd(x + j), from_x);
+    const __m256d y_diff = _mm256_sub_pd(_mm256_loadu_pd(y + j), from_y);
+    _mm256_storeu_pd(distances + j, SimdMetric<Metric>::avx2(x_diff, y_diff));
+  }
+  computeDistanceRowScalar<Metric>(from, x + j, y + j, n - j, distances + j);
+}
+#endif
+
+/**
+ * @brief Computes a row of distances with the best supported instruction set.
+ */
+template <typename Metric>
+void computeDistanceRowFor(const AMR::Coordinates2D &from, const double *x,
+                           const double *y, const size_t n,
+                           double *distances) {
+  switch (AMR::detectSimdLevel()) {
+#ifdef AMR_X86_KERNELS
+    case AMR::SimdLevel::kAvx2:
+      computeDistanceRowAvx2<Metric>(from, x, y, n, distances);
+      break;
+    case AMR::SimdLevel::kSse2:
+      computeDistanceRowSse2<Metric>(from, x, y, n, distances);
+      break;
+#endif
+    default:
+      computeDistanceRowScalar<Metric>(from, x, y, n, distances);
+      break;
+  }
+}
+}  // namespace
+
+double AMR::computeDistance(const AMR::DistanceMetric metric,
+                            const AMR::Coordinates2D &from,
+                            const AMR::Coordinates2D &to) {
+  return dispatchMetric(metric, [&](auto policy) {
+    return computeDistance<decltype(policy)>(from, to);
+  });
+}
+
+void AMR::computeDistanceRow(const AMR::DistanceMetric metric,
+                             const AMR::Coordinates2D &from, const double *x,
+                             const double *y, const size_t n,
+                             double *distances) {
+  dispatchMetric(metric, [&](auto policy) {
+    computeDistanceRowFor<decltype(policy)>(from, x, y, n, distances);
+  });
+}
+
+bool AMR::parseDistanceMetric(const std::string &name,
+                              AMR::DistanceMetric &metric) {
+  if (name == "euclidean") {
+    metric = DistanceMetric::kEuclidean;
+  } else if (name == "squared_euclidean") {
+    metric = DistanceMetric::kSquaredEuclidean;
+  } else if (name == "manhattan") {
+    metric = DistanceMetric::kManhattan;
+  } else if (name == "chebyshev") {
+    metric = DistanceMetric::kChebyshev;
+  } else {
+    return false;
+  }
+  return true;
+}
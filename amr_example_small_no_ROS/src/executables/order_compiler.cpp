@@ -0,0 +1,41 @@
+/** @file order_compiler.cpp
+ * @brief Compiles the order files of a directory into the binary store read
+ * by @ref AMR::OrderStore.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "amr.hpp"
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 3) {
+    std::cout << "Call: '" << argv[0]
+              << " orders_dir [store_path]', where orders_dir contains the "
+                 "orders_<date>.yaml files. The store is written to "
+                 "orders_dir/orders.store by default."
+              << std::endl;
+    return 1;
+  }
+  const std::string dir_path = argv[1];
+  const std::string store_path =
+      argc == 3 ? std::string(argv[2]) : dir_path + "/orders.store";
+
+  auto start = std::chrono::steady_clock::now();
+  if (!AMR::OrderStore::compile(dir_path, store_path)) {
+    return 1;
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  AMR::OrderStore order_store;
+  if (!order_store.open(store_path)) {
+    std::cout << "Error: Could not read " << store_path << std::endl;
+    return 1;
+  }
+  std::cout << "Compiled " << order_store.size() << " orders from "
+            << AMR::listOrderFiles(dir_path).size() << " files into "
+            << store_path << " in " << seconds << " s" << std::endl;
+  return 0;
+}
@@ -0,0 +1,173 @@
+/** @file precision_benchmark.cpp
+ * @brief Compares the precision policies of @ref AMR::PathEvaluator.
+ *
+ * For random orders, all pickup orders are evaluated in each precision and
+ * the shortest one is chosen. The time per evaluated pickup order and the
+ * deviation of the length (measured in double) of the chosen path from the
+ * shortest path are reported.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "amr.hpp"
+
+namespace {
+/**
+ * @brief Result of one policy for one order.
+ */
+struct Measurement {
+  double _seconds;           //!< Time spent on evaluating the pickup orders.
+  size_t _n_evaluated;       //!< Number of evaluated pickup orders.
+  std::vector<int> _order;   //!< Chosen pickup order.
+};
+
+/**
+ * @brief Evaluates the given pickup orders of an order in batches and returns
+ * the first shortest one.
+ */
+template <typename Precision>
+Measurement findShortestPath(const AMR::DistanceMatrix &distances,
+                             const std::vector<int32_t> &pickup_orders) {
+  constexpr size_t kBatchSize = 4096;
+  typedef typename AMR::PathEvaluator<Precision>::Value Value;
+  const size_t n = distances.getNumberOfParts();
+  const size_t n_orders = pickup_orders.size() / n;
+  std::vector<Value> path_lengths(kBatchSize);
+  auto start = std::chrono::steady_clock::now();
+  const AMR::PathEvaluator<Precision> evaluator(distances);
+  size_t best = 0;
+  Value shortest_path_length = 0;
+  for (size_t first = 0; first < n_orders; first += kBatchSize) {
+    const size_t n_batch = std::min(kBatchSize, n_orders - first);
+    evaluator.evaluatePathLengths(&pickup_orders[first * n], n_batch,
+                                  path_lengths.data());
+    for (size_t i = 0; i < n_batch; ++i) {
+      if (first + i == 0 || path_lengths[i] < shortest_path_length) {
+        shortest_path_length = path_lengths[i];
+        best = first + i;
+      }
+    }
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  return Measurement{seconds, n_orders,
+                     std::vector<int>(pickup_orders.begin() + best * n,
+                                      pickup_orders.begin() + (best + 1) * n)};
+}
+
+/**
+ * @brief Accumulated results of one policy.
+ */
+struct Summary {
+  std::string _name;           //!< Name of the policy.
+  double _seconds = 0.0;       //!< Total evaluation time.
+  size_t _n_evaluated = 0;     //!< Total number of evaluated pickup orders.
+  double _max_deviation = 0.0;  //!< Largest relative length deviation.
+  double _sum_deviation = 0.0;  //!< Sum of the relative length deviations.
+  size_t _n_different = 0;  //!< Number of orders with a different path.
+};
+
+/**
+ * @brief Solves an order with a policy and adds the result to its summary.
+ */
+template <typename Precision>
+void measure(const AMR::DistanceMatrix &distances,
+             const std::vector<int32_t> &pickup_orders,
+             const Measurement &reference, Summary &summary) {
+  const Measurement measurement =
+      findShortestPath<Precision>(distances, pickup_orders);
+  const double reference_length =
+      distances.determinePathLength(reference._order.data());
+  const double length =
+      distances.determinePathLength(measurement._order.data());
+  const double deviation = (length - reference_length) / reference_length;
+  summary._seconds += measurement._seconds;
+  summary._n_evaluated += measurement._n_evaluated;
+  summary._max_deviation = std::max(summary._max_deviation, deviation);
+  summary._sum_deviation += deviation;
+  summary._n_different += measurement._order != reference._order ? 1 : 0;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  size_t n_orders = 20;
+  size_t n_parts = 9;
+  if (argc >= 2) {
+    n_orders = std::stoul(argv[1]);
+  }
+  if (argc >= 3) {
+    n_parts = std::stoul(argv[2]);
+  }
+  if (argc > 3 || n_orders == 0 || n_parts < 2 || n_parts > 10) {
+    std::cout << "Call: '" << argv[0]
+              << " [n_orders] [n_parts]', where 2 <= n_parts <= 10."
+              << std::endl;
+    return 1;
+  }
+
+  // all pickup orders are generated once, so that only their evaluation is
+  // timed
+  std::vector<int32_t> permutation(n_parts), pickup_orders;
+  std::iota(permutation.begin(), permutation.end(), 0);
+  do {
+    pickup_orders.insert(pickup_orders.end(), permutation.begin(),
+                         permutation.end());
+  } while (std::next_permutation(permutation.begin(), permutation.end()));
+
+  // the coordinates of the test data are in [0, 1000)
+  std::mt19937 generator(2024);
+  std::uniform_real_distribution<double> distribution(0.0, 1000.0);
+  std::vector<Summary> summaries(3);
+  summaries[0]._name = "double";
+  summaries[1]._name = "float";
+  summaries[2]._name = "int32";
+  for (size_t order = 0; order < n_orders; ++order) {
+    std::vector<AMR::Coordinates2D> part_locations;
+    for (size_t i = 0; i < n_parts; ++i) {
+      double x = distribution(generator);
+      double y = distribution(generator);
+      part_locations.emplace_back(x, y);
+    }
+    const AMR::DistanceMatrix distances(AMR::Coordinates2D(0.0, 0.0),
+                                        part_locations,
+                                        AMR::Coordinates2D(500.0, 1000.0));
+    const Measurement reference =
+        findShortestPath<AMR::DoublePrecision>(distances, pickup_orders);
+    measure<AMR::DoublePrecision>(distances, pickup_orders, reference,
+                                  summaries[0]);
+    measure<AMR::FloatPrecision>(distances, pickup_orders, reference,
+                                 summaries[1]);
+    measure<AMR::FixedPointPrecision>(distances, pickup_orders, reference,
+                                      summaries[2]);
+  }
+
+  std::cout << n_orders << " orders with " << n_parts
+            << " part locations, all pickup orders evaluated" << std::endl;
+  std::cout << std::left << std::setw(8) << "policy" << std::right
+            << std::setw(14) << "ns/order" << std::setw(10) << "speedup"
+            << std::setw(16) << "max deviation" << std::setw(17)
+            << "mean deviation" << std::setw(12) << "different"
+            << std::endl;
+  const double reference_time =
+      summaries[0]._seconds / static_cast<double>(summaries[0]._n_evaluated);
+  for (const Summary &summary : summaries) {
+    const double time =
+        summary._seconds / static_cast<double>(summary._n_evaluated);
+    std::cout << std::left << std::setw(8) << summary._name << std::right
+              << std::fixed << std::setprecision(2) << std::setw(14)
+              << time * 1e9 << std::setw(10) << reference_time / time
+              << std::scientific << std::setw(16) << summary._max_deviation
+              << std::setw(17)
+              << summary._sum_deviation / static_cast<double>(n_orders)
+              << std::setw(12) << summary._n_different << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,117 @@
+#include "order_directory_watcher.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <iostream>
+#include <set>
+
+#include "basic_routines.hpp"
+
+bool AMR::OrderDirectoryWatcher::start(
+    const std::string &dir_path, AMR::OrderIndex &order_index,
+    AMR::OrderFileFilters *order_file_filters) {
+  stop();
+#ifdef __linux__
+  _inotify_descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (_inotify_descriptor < 0) {
+    return false;
+  }
+  // files are either written in place or moved into the directory
+  if (inotify_add_watch(_inotify_descriptor, dir_path.c_str(),
+                        IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE |
+                            IN_MOVED_FROM) < 0 ||
+      pipe(_stop_descriptors) != 0) {
+    std::cout << "Error: Could not watch " << dir_path << std::endl;
+    stop();
+    return false;
+  }
+  _n_updates = 0;
+  _thread = std::thread(&OrderDirectoryWatcher::watchLoop, this, dir_path,
+                        &order_index, order_file_filters);
+  return true;
+#else
+  (void)dir_path;
+  (void)order_index;
+  (void)order_file_filters;
+  return false;
+#endif
+}
+
+void AMR::OrderDirectoryWatcher::stop() {
+#ifdef __linux__
+  if (_thread.joinable()) {
+    const char stop_signal = 0;
+    if (write(_stop_descriptors[1], &stop_signal, 1) == 1) {
+      _thread.join();
+    } else {
+      _thread.detach();
+    }
+  }
+  for (int &descriptor : _stop_descriptors) {
+    if (descriptor >= 0) {
+      close(descriptor);
+      descriptor = -1;
+    }
+  }
+  if (_inotify_descriptor >= 0) {
+    close(_inotify_descriptor);
+    _inotify_descriptor = -1;
+  }
+#endif
+}
+
+void AMR::OrderDirectoryWatcher::watchLoop(
+    const std::string dir_path, AMR::OrderIndex *order_index,
+    AMR::OrderFileFilters *order_file_filters) {
+#ifdef __linux__
+  alignas(struct inotify_event) char buffer[16384];
+  while (true) {
+    pollfd descriptors[2] = {{_inotify_descriptor, POLLIN, 0},
+                             {_stop_descriptors[0], POLLIN, 0}};
+    if (poll(descriptors, 2, -1) < 0 || (descriptors[1].revents & POLLIN)) {
+      return;
+    }
+    // all pending events are read first, so a file that was written in
+    // several pieces is only indexed once
+    std::set<std::string> file_names;
+    bool overflow = false;
+    ssize_t length = 0;
+    while ((length = read(_inotify_descriptor, buffer, sizeof(buffer))) > 0) {
+      for (const char *position = buffer; position < buffer + length;) {
+        const inotify_event *event =
+            reinterpret_cast<const inotify_event *>(position);
+        if (event->mask & IN_Q_OVERFLOW) {
+          overflow = true;
+        } else if (event->len > 0 && isOrderFileName(event->name)) {
+          file_names.insert(event->name);
+        }
+        position += sizeof(inotify_event) + event->len;
+      }
+    }
+    if (overflow) {
+      order_index->refresh();
+      if (order_file_filters != nullptr) {
+        order_file_filters->build(dir_path);
+      }
+      ++_n_updates;
+      continue;
+    }
+    for (const std::string &file_name : file_names) {
+      const bool filters_updated =
+          order_file_filters != nullptr &&
+          order_file_filters->updateFile(file_name);
+      if (order_index->updateFile(file_name) || filters_updated) {
+        ++_n_updates;
+      }
+    }
+  }
+#else
+  (void)dir_path;
+  (void)order_index;
+  (void)order_file_filters;
+#endif
+}
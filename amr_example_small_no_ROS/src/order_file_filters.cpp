@@ -0,0 +1,154 @@
+#include "order_file_filters.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+
+#include "basic_routines.hpp"
+#include "order_file_scanner.hpp"
+#include "yaml-cpp/yaml.h"
+
+namespace {
+/**
+ * @brief Mixes the bits of an order id (splitmix64 finalizer), so that
+ * consecutive ids set unrelated bits.
+ */
+uint64_t hashOrderId(const uint32_t order_id) {
+  uint64_t hash = order_id + 0x9e3779b97f4a7c15ull;
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+  return hash ^ (hash >> 31);
+}
+}  // namespace
+
+AMR::OrderIdFilter::OrderIdFilter(const std::vector<uint32_t> &order_ids)
+    : OrderIdFilter() {
+  if (order_ids.empty()) {
+    return;
+  }
+  const auto range = std::minmax_element(order_ids.begin(), order_ids.end());
+  _min_id = *range.first;
+  _max_id = *range.second;
+  _bits.resize((order_ids.size() * kBitsPerId + 63) / 64);
+  const uint64_t n_bits = _bits.size() * 64;
+  // the bits of an id are derived from two halves of its hash (double
+  // hashing)
+  for (const uint32_t order_id : order_ids) {
+    const uint64_t hash = hashOrderId(order_id);
+    const uint64_t step = (hash >> 32) | 1;
+    for (uint64_t i = 0, bit = hash & 0xffffffffull; i < kNumberOfHashes;
+         ++i, bit += step) {
+      _bits[(bit % n_bits) / 64] |= uint64_t(1) << (bit % n_bits % 64);
+    }
+  }
+}
+
+bool AMR::OrderIdFilter::mayContain(const uint32_t order_id) const {
+  if (order_id < _min_id || order_id > _max_id) {
+    return false;
+  }
+  const uint64_t n_bits = _bits.size() * 64;
+  const uint64_t hash = hashOrderId(order_id);
+  const uint64_t step = (hash >> 32) | 1;
+  for (uint64_t i = 0, bit = hash & 0xffffffffull; i < kNumberOfHashes;
+       ++i, bit += step) {
+    if (!(_bits[(bit % n_bits) / 64] & (uint64_t(1) << (bit % n_bits % 64)))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool AMR::OrderFileFilters::filterFile(const std::string &file_path,
+                                       FilteredFile &file) {
+  MappedFile mapped_file;
+  if (!getFileStatus(file_path, file._size, file._mtime) ||
+      !mapped_file.open(file_path)) {
+    return false;
+  }
+  // the filter belongs to the mapped content, even if the file grows in the
+  // meantime
+  file._size = mapped_file.size();
+  std::vector<uint32_t> order_ids;
+  if (!scanOrderIds(mapped_file.data(), mapped_file.size(), order_ids)) {
+    // files in another layout are parsed by yaml-cpp
+    order_ids.clear();
+    try {
+      for (const auto &order : YAML::LoadFile(file_path)) {
+        order_ids.push_back(order["order"].as<uint32_t>());
+      }
+    } catch (const YAML::Exception &e) {
+      std::cout << "Error: Could not read " << file_path << ": " << e.what()
+                << std::endl;
+      return false;
+    }
+  }
+  file._filter = OrderIdFilter(order_ids);
+  return true;
+}
+
+size_t AMR::OrderFileFilters::build(const std::string &dir_path) {
+  std::map<std::string, FilteredFile> files;
+  for (const std::string &file_path : listOrderFiles(dir_path)) {
+    FilteredFile file;
+    if (filterFile(file_path, file)) {
+      files.emplace(std::filesystem::path(file_path).filename().string(),
+                    std::move(file));
+    }
+  }
+  std::unique_lock<std::shared_mutex> lock(_mutex);
+  _dir_path = dir_path;
+  _files.swap(files);
+  return _files.size();
+}
+
+bool AMR::OrderFileFilters::updateFile(const std::string &file_name) {
+  std::string file_path;
+  {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    if (_dir_path.empty()) {
+      return false;
+    }
+    file_path = _dir_path + "/" + file_name;
+  }
+  FilteredFile file;
+  const bool exists = filterFile(file_path, file);
+  std::unique_lock<std::shared_mutex> lock(_mutex);
+  auto file_iter = _files.find(file_name);
+  if (!exists) {
+    if (file_iter == _files.end()) {
+      return false;
+    }
+    _files.erase(file_iter);
+    return true;
+  }
+  if (file_iter != _files.end() && file_iter->second._size == file._size &&
+      file_iter->second._mtime == file._mtime) {
+    return false;
+  }
+  _files[file_name] = std::move(file);
+  return true;
+}
+
+std::vector<std::string> AMR::OrderFileFilters::selectFiles(
+    const std::vector<std::string> &file_paths,
+    const uint32_t order_id) const {
+  std::vector<std::string> selected_paths;
+  std::shared_lock<std::shared_mutex> lock(_mutex);
+  for (const std::string &file_path : file_paths) {
+    auto file_iter =
+        _files.find(std::filesystem::path(file_path).filename().string());
+    // only the metadata of the file is read to detect changes
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    if (file_iter == _files.end() ||
+        !getFileStatus(file_path, size, mtime) ||
+        size != file_iter->second._size ||
+        mtime != file_iter->second._mtime ||
+        file_iter->second._filter.mayContain(order_id)) {
+      selected_paths.push_back(file_path);
+    }
+  }
+  return selected_paths;
+}
@@ -0,0 +1,344 @@
+#include "order_file_scanner.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+/**
+ * @brief Returns the end of the line starting at @p line, i.e. the position
+ * of its '\n' or @p end.
+ */
+const char *findLineEnd(const char *line, const char *end) {
+  const void *line_end = memchr(line, '\n', end - line);
+  return line_end == nullptr ? end : static_cast<const char *>(line_end);
+}
+
+/**
+ * @brief Returns the start of the line following the line at @p line.
+ */
+const char *nextLine(const char *line, const char *end) {
+  const char *line_end = findLineEnd(line, end);
+  return line_end == end ? end : line_end + 1;
+}
+
+/**
+ * @brief Checks whether the text at @p position starts with @p prefix.
+ */
+bool startsWith(const char *position, const char *end, const char *prefix) {
+  const size_t length = strlen(prefix);
+  return static_cast<size_t>(end - position) >= length &&
+         memcmp(position, prefix, length) == 0;
+}
+
+/**
+ * @brief Checks whether only blanks are left on a line.
+ */
+bool isLineEnd(const char *position, const char *line_end) {
+  while (position < line_end && (*position == ' ' || *position == '\r')) {
+    ++position;
+  }
+  return position == line_end;
+}
+
+/**
+ * @brief Parses the number that follows @p position on the line, preceded
+ * by blanks and followed by nothing but blanks.
+ */
+template <typename Value>
+bool parseValue(const char *position, const char *line_end, Value &value) {
+  while (position < line_end && *position == ' ') {
+    ++position;
+  }
+  const std::from_chars_result result =
+      std::from_chars(position, line_end, value);
+  return result.ec == std::errc() && result.ptr != position &&
+         isLineEnd(result.ptr, line_end);
+}
+}  // namespace
+
+bool AMR::MappedFile::open(const std::string &file_path,
+                           const bool sequential) {
+  close();
+  const int descriptor = ::open(file_path.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    return false;
+  }
+  struct stat file_status;
+  if (fstat(descriptor, &file_status) == 0) {
+    _size = static_cast<size_t>(file_status.st_size);
+    if (_size == 0) {
+      _is_open = true;
+    } else {
+      void *mapping =
+          mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+      if (mapping != MAP_FAILED) {
+        madvise(mapping, _size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+        _data = static_cast<const char *>(mapping);
+        _is_open = true;
+      } else {
+        _size = 0;
+      }
+    }
+  }
+  // the mapping stays valid after the file is closed
+  ::close(descriptor);
+  return _is_open;
+}
+
+void AMR::MappedFile::close() {
+  if (_data != nullptr) {
+    munmap(const_cast<char *>(_data), _size);
+  }
+  _data = nullptr;
+  _size = 0;
+  _is_open = false;
+}
+
+bool AMR::getFileStatus(const std::string &file_path, uint64_t &size,
+                        int64_t &mtime) {
+  std::error_code error;
+  size = std::filesystem::file_size(file_path, error);
+  if (error) {
+    return false;
+  }
+  mtime = static_cast<int64_t>(
+      std::filesystem::last_write_time(file_path, error)
+          .time_since_epoch()
+          .count());
+  return !error;
+}
+
+bool AMR::isPreamble(const char *begin, const char *end) {
+  // yaml-cpp ignores these lines as well
+  for (const char *line = begin; line < end; line = nextLine(line, end)) {
+    const char *line_end = findLineEnd(line, end);
+    if (!isLineEnd(line, line_end) && *line != '#' &&
+        !(startsWith(line, line_end, "---") && isLineEnd(line + 3, line_end))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const char *AMR::findNextRecord(const char *from, const char *end) {
+  // the start of a record is a '-' directly after a line break. Only the
+  // '-' characters are visited, most of which are the bullets of products
+  for (const char *position = from; position < end;) {
+    const void *dash = memchr(position, '-', end - position);
+    if (dash == nullptr) {
+      break;
+    }
+    const char *record = static_cast<const char *>(dash);
+    if ((record == from || record[-1] == '\n') &&
+        (record + 1 == end || record[1] == ' ' || record[1] == '\n')) {
+      return record;
+    }
+    position = record + 1;
+  }
+  return end;
+}
+
+std::vector<size_t> AMR::splitOrderFile(const char *data, const size_t size,
+                                        const size_t max_chunks,
+                                        const size_t min_chunk_size) {
+  const size_t n_chunks = std::max<size_t>(
+      1, std::min(max_chunks, size / std::max<size_t>(1, min_chunk_size)));
+  std::vector<size_t> chunk_offsets{0};
+  const char *end = data + size;
+  for (size_t chunk = 1; chunk < n_chunks; ++chunk) {
+    // the chunk starts at the first record after its even share of the file
+    const char *line = findLineEnd(data + chunk * size / n_chunks, end);
+    const size_t offset =
+        findNextRecord(line == end ? end : line + 1, end) - data;
+    if (offset < size && offset > chunk_offsets.back()) {
+      chunk_offsets.push_back(offset);
+    }
+  }
+  return chunk_offsets;
+}
+
+std::vector<AMR::OrderFileChunk> AMR::splitOrderFiles(
+    const std::vector<std::string> &file_paths, const size_t max_chunks,
+    std::vector<AMR::MappedFile> &mapped_files) {
+  std::vector<OrderFileChunk> chunks;
+  for (size_t file = 0; file < file_paths.size(); ++file) {
+    MappedFile &mapped_file = mapped_files[file];
+    if (!mapped_file.open(file_paths[file])) {
+      std::cout << "Error: Could not read " << file_paths[file] << std::endl;
+      continue;
+    }
+    const std::vector<size_t> chunk_offsets =
+        splitOrderFile(mapped_file.data(), mapped_file.size(), max_chunks);
+    for (size_t i = 0; i < chunk_offsets.size(); ++i) {
+      chunks.push_back({file, chunk_offsets[i],
+                        i + 1 < chunk_offsets.size() ? chunk_offsets[i + 1]
+                                                     : mapped_file.size()});
+    }
+  }
+  return chunks;
+}
+
+bool AMR::parseRecordOrderId(const char *record, const char *end,
+                             uint32_t &order_id) {
+  const char *line_end = findLineEnd(record, end);
+  return startsWith(record, line_end, "- order:") &&
+         parseValue(record + 8, line_end, order_id);
+}
+
+AMR::ScanResult AMR::parseOrderRecord(
+    const char *record, const char *end, uint32_t &order_id,
+    AMR::Coordinates2D &delivery_point,
+    std::vector<long long int> &ordered_products) {
+  uint32_t id = 0;
+  if (!parseRecordOrderId(record, end, id)) {
+    return ScanResult::kRejected;
+  }
+  double x = 0.0, y = 0.0;
+  bool has_x = false, has_y = false, has_products = false;
+  bool in_products = false;
+  std::vector<long long int> products;
+  // the keys of the record are indented by two blanks, the products by at
+  // least two blanks
+  for (const char *line = nextLine(record, end); line < end && *line != '-';
+       line = nextLine(line, end)) {
+    const char *line_end = findLineEnd(line, end);
+    if (isLineEnd(line, line_end)) {
+      continue;
+    }
+    if (!startsWith(line, line_end, "  ")) {
+      return ScanResult::kRejected;
+    }
+    const char *key = line + 2;
+    const char *item = key;
+    while (item < line_end && *item == ' ') {
+      ++item;
+    }
+    long long int product = 0;
+    if (in_products && startsWith(item, line_end, "- ") &&
+        parseValue(item + 2, line_end, product)) {
+      products.push_back(product);
+      continue;
+    }
+    in_products = false;
+    if (item != key) {
+      return ScanResult::kRejected;
+    } else if (!has_x && startsWith(key, line_end, "cx:") &&
+               parseValue(key + 3, line_end, x)) {
+      has_x = true;
+    } else if (!has_y && startsWith(key, line_end, "cy:") &&
+               parseValue(key + 3, line_end, y)) {
+      has_y = true;
+    } else if (!has_products && startsWith(key, line_end, "products:")) {
+      has_products = true;
+      const char *value = key + 9;
+      while (value < line_end && *value == ' ') {
+        ++value;
+      }
+      if (startsWith(value, line_end, "[]")) {
+        value += 2;
+      } else {
+        in_products = true;
+      }
+      if (!isLineEnd(value, line_end)) {
+        return ScanResult::kRejected;
+      }
+    } else {
+      return ScanResult::kRejected;
+    }
+  }
+  if (!has_x || !has_y || !has_products) {
+    return ScanResult::kRejected;
+  }
+  order_id = id;
+  delivery_point._x = x;
+  delivery_point._y = y;
+  ordered_products.insert(ordered_products.end(), products.begin(),
+                          products.end());
+  return ScanResult::kFound;
+}
+
+AMR::ScanResult AMR::scanOrderFile(
+    const char *data, const size_t size, const uint32_t order_id,
+    AMR::Coordinates2D &delivery_point,
+    std::vector<long long int> &ordered_products, AMR::OrderSearchToken *token,
+    const size_t file) {
+  const char *end = data + size;
+  const char *record = findNextRecord(data, end);
+  if (!isPreamble(data, record)) {
+    return ScanResult::kRejected;
+  }
+  while (record < end) {
+    if (token != nullptr && token->isStopped(file)) {
+      return ScanResult::kStopped;
+    }
+    uint32_t id = 0;
+    if (!parseRecordOrderId(record, end, id)) {
+      return ScanResult::kRejected;
+    }
+    if (id == order_id) {
+      ScanResult result = parseOrderRecord(record, end, id, delivery_point,
+                                           ordered_products);
+      if (result == ScanResult::kFound && token != nullptr) {
+        token->reportHit(file);
+      }
+      return result;
+    }
+    record = findNextRecord(nextLine(record, end), end);
+  }
+  return ScanResult::kNotFound;
+}
+
+bool AMR::scanOrderIds(const char *data, const size_t size,
+                       std::vector<uint32_t> &order_ids) {
+  const char *end = data + size;
+  const char *record = findNextRecord(data, end);
+  if (!isPreamble(data, record)) {
+    return false;
+  }
+  for (; record < end; record = findNextRecord(nextLine(record, end), end)) {
+    uint32_t id = 0;
+    if (!parseRecordOrderId(record, end, id)) {
+      return false;
+    }
+    order_ids.push_back(id);
+  }
+  return true;
+}
+
+AMR::ScanResult AMR::scanOrderFile(
+    const char *data, const size_t size,
+    const std::unordered_map<uint32_t, size_t> &slots,
+    std::vector<AMR::OrderInformation> &orders) {
+  const char *end = data + size;
+  const char *record = findNextRecord(data, end);
+  if (!isPreamble(data, record)) {
+    return ScanResult::kRejected;
+  }
+  ScanResult result = ScanResult::kNotFound;
+  for (; record < end; record = findNextRecord(nextLine(record, end), end)) {
+    uint32_t id = 0;
+    if (!parseRecordOrderId(record, end, id)) {
+      return ScanResult::kRejected;
+    }
+    auto slot_iter = slots.find(id);
+    if (slot_iter == slots.end() || orders[slot_iter->second]._found) {
+      continue;
+    }
+    OrderInformation &order = orders[slot_iter->second];
+    if (parseOrderRecord(record, end, id, order._delivery_point,
+                         order._ordered_products) != ScanResult::kFound) {
+      return ScanResult::kRejected;
+    }
+    order._found = true;
+    result = ScanResult::kFound;
+  }
+  return result;
+}
@@ -0,0 +1,554 @@
+#include "order_index.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "basic_routines.hpp"
+#include "order_file_scanner.hpp"
+#include "yaml-cpp/yaml.h"
+
+namespace {
+//! Identifies files written by @ref AMR::OrderIndex and their format version.
+const char kIndexMagic[8] = {'A', 'M', 'R', 'O', 'I', 'D', 'X', '1'};
+
+template <typename Value>
+void writeValue(std::ofstream &stream, const Value &value) {
+  stream.write(reinterpret_cast<const char *>(&value), sizeof(Value));
+}
+
+template <typename Value>
+bool readValue(std::ifstream &stream, Value &value) {
+  return static_cast<bool>(
+      stream.read(reinterpret_cast<char *>(&value), sizeof(Value)));
+}
+
+/**
+ * @brief Reads the id of the order in a record, with yaml-cpp if the record
+ * is not in the layout known by @ref AMR::parseRecordOrderId.
+ */
+bool parseOrderId(const char *record, const char *end, uint32_t &order_id) {
+  if (AMR::parseRecordOrderId(record, end, order_id)) {
+    return true;
+  }
+  try {
+    order_id =
+        YAML::Load(std::string(record, end))[0]["order"].as<uint32_t>();
+    return true;
+  } catch (const YAML::Exception &) {
+    return false;
+  }
+}
+
+/**
+ * @brief Parses the text of an indexed record, with yaml-cpp if it is not in
+ * the layout known by @ref AMR::parseOrderRecord. The output variables are
+ * only changed if the record is the one of the order.
+ */
+AMR::OrderIndex::Status parseIndexedRecord(
+    const char *begin, const char *end, const uint32_t order_id,
+    AMR::Coordinates2D &delivery_point,
+    std::vector<long long int> &ordered_products) {
+  uint32_t record_id = 0;
+  AMR::Coordinates2D record_delivery_point;
+  std::vector<long long int> record_products;
+  if (AMR::parseOrderRecord(begin, end, record_id, record_delivery_point,
+                            record_products) == AMR::ScanResult::kFound) {
+    if (record_id != order_id) {
+      return AMR::OrderIndex::Status::kOutdated;
+    }
+    delivery_point = record_delivery_point;
+    ordered_products.insert(ordered_products.end(), record_products.begin(),
+                            record_products.end());
+    return AMR::OrderIndex::Status::kFound;
+  }
+  try {
+    const YAML::Node order = YAML::Load(std::string(begin, end))[0];
+    if (order["order"].as<uint32_t>() != order_id) {
+      return AMR::OrderIndex::Status::kOutdated;
+    }
+    const double x = order["cx"].as<double>();
+    const double y = order["cy"].as<double>();
+    std::vector<long long int> products;
+    for (const auto &product : order["products"]) {
+      products.push_back(product.as<long long int>());
+    }
+    delivery_point._x = x;
+    delivery_point._y = y;
+    ordered_products.insert(ordered_products.end(), products.begin(),
+                            products.end());
+  } catch (const YAML::Exception &) {
+    return AMR::OrderIndex::Status::kOutdated;
+  }
+  return AMR::OrderIndex::Status::kFound;
+}
+}  // namespace
+
+void AMR::OrderIndex::scanRecords(const char *begin, const char *end,
+                                   const uint64_t offset, Records &records) {
+  for (const char *record = findNextRecord(begin + offset, end);
+       record < end;) {
+    const char *next_record =
+        findNextRecord(std::find(record, end, '\n'), end);
+    uint32_t order_id = 0;
+    if (parseOrderId(record, next_record, order_id)) {
+      records.emplace_back(
+          order_id, OrderRecord(0, record - begin, next_record - record));
+    }
+    record = next_record;
+  }
+}
+
+std::vector<bool> AMR::OrderIndex::scanFiles(
+    const std::vector<std::string> &file_paths,
+    const std::vector<IndexedFile *> &files, AMR::ThreadPool *thread_pool) {
+  std::vector<MappedFile> mapped_files(file_paths.size());
+  const std::vector<OrderFileChunk> chunks = splitOrderFiles(
+      file_paths, resolveThreadCount(0, thread_pool), mapped_files);
+  // every chunk is scanned by its own task into its own records, which are
+  // concatenated in order, so the index does not depend on the chunks
+  std::vector<Records> chunk_records(chunks.size());
+  runInParallel(thread_pool, AMR::ThreadPoolSubsystem::kOrderLookup,
+                chunks.size(), [&](size_t chunk) {
+                  const MappedFile &mapped_file =
+                      mapped_files[chunks[chunk]._file];
+                  scanRecords(mapped_file.data(),
+                              mapped_file.data() + chunks[chunk]._end,
+                              chunks[chunk]._begin, chunk_records[chunk]);
+                });
+  std::vector<bool> read(file_paths.size(), false);
+  for (size_t file = 0; file < file_paths.size(); ++file) {
+    if (mapped_files[file].isOpen()) {
+      // the size of the mapping matches the scanned content, even if the
+      // file grows in the meantime
+      read[file] = true;
+      files[file]->_size = mapped_files[file].size();
+      files[file]->_records.clear();
+    }
+  }
+  for (size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+    Records &records = files[chunks[chunk]._file]->_records;
+    records.insert(records.end(), chunk_records[chunk].begin(),
+                   chunk_records[chunk].end());
+  }
+  return read;
+}
+
+void AMR::OrderIndex::addRecords(
+    const std::vector<IndexedFile> &files, const uint32_t file,
+    const size_t first, std::unordered_map<uint32_t, OrderRecord> &records) {
+  // within a file the first record of an id wins, otherwise the file whose
+  // name sorts first
+  for (size_t i = first; i < files[file]._records.size(); ++i) {
+    const uint32_t order_id = files[file]._records[i].first;
+    OrderRecord record = files[file]._records[i].second;
+    record._file = file;
+    auto inserted = records.emplace(order_id, record);
+    OrderRecord &existing = inserted.first->second;
+    if (!inserted.second &&
+        (existing._file == file
+             ? record._offset <= existing._offset
+             : files[file]._name < files[existing._file]._name)) {
+      existing = record;
+    }
+  }
+}
+
+void AMR::OrderIndex::buildRecords(
+    const std::vector<IndexedFile> &files,
+    std::unordered_map<uint32_t, OrderRecord> &records) {
+  records.clear();
+  for (uint32_t file = 0; file < files.size(); ++file) {
+    addRecords(files, file, 0, records);
+  }
+}
+
+std::vector<AMR::OrderIndex::IndexedFile> AMR::OrderIndex::load(
+    const std::string &index_path) {
+  std::vector<IndexedFile> files;
+  std::ifstream stream(index_path, std::ios::binary | std::ios::ate);
+  if (!stream) {
+    return files;
+  }
+  // the counts read from the file are bounded by the bytes left in it, so a
+  // corrupt index cannot make the vectors allocate more than its size
+  const std::streamoff index_size = stream.tellg();
+  auto remaining = [&stream, index_size]() {
+    return static_cast<uint64_t>(index_size - stream.tellg());
+  };
+  constexpr uint64_t kMinimumFileSize = 4 * sizeof(uint64_t);
+  constexpr uint64_t kRecordSize =
+      sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint64_t);
+  char magic[sizeof(kIndexMagic)];
+  uint64_t n_files = 0;
+  if (!stream.seekg(0) || !stream.read(magic, sizeof(magic)) ||
+      !std::equal(magic, magic + sizeof(magic), kIndexMagic) ||
+      !readValue(stream, n_files) || n_files > remaining() / kMinimumFileSize) {
+    return files;
+  }
+  files.resize(n_files);
+  for (IndexedFile &file : files) {
+    uint64_t name_length = 0, n_records = 0;
+    if (!readValue(stream, name_length) || name_length > 4096 ||
+        name_length > remaining()) {
+      return std::vector<IndexedFile>();
+    }
+    file._name.resize(name_length);
+    if (!stream.read(&file._name[0], name_length) ||
+        !readValue(stream, file._size) || !readValue(stream, file._mtime) ||
+        !readValue(stream, n_records) || n_records > file._size ||
+        n_records > remaining() / kRecordSize) {
+      return std::vector<IndexedFile>();
+    }
+    file._records.resize(n_records);
+    for (auto &record : file._records) {
+      if (!readValue(stream, record.first) ||
+          !readValue(stream, record.second._offset) ||
+          !readValue(stream, record.second._length)) {
+        return std::vector<IndexedFile>();
+      }
+    }
+  }
+  return files;
+}
+
+void AMR::OrderIndex::save(const std::string &index_path) const {
+  // the index is replaced atomically, so a concurrent reader never sees a
+  // partially written file
+  const std::string temporary_path = index_path + ".tmp";
+  {
+    std::ofstream stream(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+      std::cout << "Error: Could not write " << index_path << std::endl;
+      return;
+    }
+    stream.write(kIndexMagic, sizeof(kIndexMagic));
+    writeValue(stream, static_cast<uint64_t>(_files.size()));
+    for (const IndexedFile &file : _files) {
+      writeValue(stream, static_cast<uint64_t>(file._name.size()));
+      stream.write(file._name.data(), file._name.size());
+      writeValue(stream, file._size);
+      writeValue(stream, file._mtime);
+      writeValue(stream, static_cast<uint64_t>(file._records.size()));
+      for (const auto &record : file._records) {
+        writeValue(stream, record.first);
+        writeValue(stream, record.second._offset);
+        writeValue(stream, record.second._length);
+      }
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary_path, index_path, error);
+  if (error) {
+    std::cout << "Error: Could not write " << index_path << std::endl;
+    std::filesystem::remove(temporary_path, error);
+  }
+}
+
+size_t AMR::OrderIndex::build(const std::string &dir_path,
+                              const std::string &index_path,
+                              AMR::ThreadPool *thread_pool) {
+  std::vector<IndexedFile> persisted_files;
+  if (!index_path.empty()) {
+    persisted_files = load(index_path);
+  }
+  // the index is built without holding the lock, since the pool may execute
+  // lookups of this index while the files are scanned. The lock is only
+  // taken to replace the files and records
+  std::vector<IndexedFile> files;
+  // the files that are not in the persisted index are scanned together
+  std::vector<std::string> scanned_paths;
+  std::vector<size_t> scanned_files;
+  for (const std::string &file_path : listOrderFiles(dir_path)) {
+    IndexedFile file;
+    file._name = std::filesystem::path(file_path).filename().string();
+    if (!getFileStatus(file_path, file._size, file._mtime)) {
+      continue;
+    }
+    auto persisted_iter = std::find_if(
+        persisted_files.begin(), persisted_files.end(),
+        [&file](const IndexedFile &persisted) {
+          return persisted._name == file._name &&
+                 persisted._size == file._size &&
+                 persisted._mtime == file._mtime;
+        });
+    if (persisted_iter != persisted_files.end()) {
+      file._records = std::move(persisted_iter->_records);
+    } else {
+      scanned_paths.push_back(file_path);
+      scanned_files.push_back(files.size());
+    }
+    files.push_back(std::move(file));
+  }
+  std::vector<IndexedFile *> scanned;
+  for (const size_t file : scanned_files) {
+    scanned.push_back(&files[file]);
+  }
+  const std::vector<bool> read = scanFiles(scanned_paths, scanned, thread_pool);
+  const size_t n_scanned = std::count(read.begin(), read.end(), true);
+  // files that could not be read are not indexed
+  for (size_t i = scanned_files.size(); i-- > 0;) {
+    if (!read[i]) {
+      files.erase(files.begin() + scanned_files[i]);
+    }
+  }
+  std::unordered_map<uint32_t, OrderRecord> records;
+  buildRecords(files, records);
+
+  std::unique_lock<std::shared_mutex> lock(_mutex);
+  _dir_path = dir_path;
+  _index_path = index_path;
+  _thread_pool = thread_pool;
+  _files.swap(files);
+  _records.swap(records);
+  _built = true;
+  if (!index_path.empty() &&
+      (n_scanned > 0 || persisted_files.size() != _files.size())) {
+    save(index_path);
+  }
+  return n_scanned;
+}
+
+size_t AMR::OrderIndex::refresh() {
+  std::string dir_path, index_path;
+  AMR::ThreadPool *thread_pool = nullptr;
+  {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    dir_path = _dir_path;
+    index_path = _index_path;
+    thread_pool = _thread_pool;
+  }
+  return build(dir_path, index_path, thread_pool);
+}
+
+bool AMR::OrderIndex::updateFile(const std::string &file_name) {
+  auto find_file = [&file_name](std::vector<IndexedFile> &files) {
+    return std::find_if(files.begin(), files.end(),
+                        [&file_name](const IndexedFile &indexed_file) {
+                          return indexed_file._name == file_name;
+                        });
+  };
+  // the file is mapped and scanned without holding the lock, since the pool
+  // may execute lookups of this index while the file is scanned. The lock is
+  // only taken to splice the records, and the update is repeated if the file
+  // was indexed again in the meantime
+  while (true) {
+    std::string dir_path;
+    AMR::ThreadPool *thread_pool = nullptr;
+    bool indexed = false;
+    uint64_t indexed_size = 0;
+    int64_t indexed_mtime = 0;
+    std::pair<uint32_t, OrderRecord> last_record(0, OrderRecord());
+    bool has_last_record = false;
+    {
+      std::shared_lock<std::shared_mutex> lock(_mutex);
+      if (!_built) {
+        return false;
+      }
+      dir_path = _dir_path;
+      thread_pool = _thread_pool;
+      auto file_iter = find_file(_files);
+      if (file_iter != _files.end()) {
+        indexed = true;
+        indexed_size = file_iter->_size;
+        indexed_mtime = file_iter->_mtime;
+        has_last_record = !file_iter->_records.empty();
+        if (has_last_record) {
+          last_record = file_iter->_records.back();
+        }
+      }
+    }
+
+    const std::string file_path = dir_path + "/" + file_name;
+    IndexedFile file;
+    file._name = file_name;
+    file._size = 0;
+    file._mtime = 0;
+    bool removed = !getFileStatus(file_path, file._size, file._mtime);
+    bool appended = false;
+    if (!removed) {
+      MappedFile mapped_file;
+      removed = !mapped_file.open(file_path);
+      if (!removed && indexed && mapped_file.size() == indexed_size &&
+          file._mtime == indexed_mtime) {
+        return false;
+      }
+      if (!removed && indexed && has_last_record &&
+          mapped_file.size() >= indexed_size) {
+        // the file was only appended to if its last record still starts at
+        // the same offset with the same id
+        const char *begin = mapped_file.data();
+        const char *end = begin + mapped_file.size();
+        uint32_t last_id = 0;
+        appended = parseRecordOrderId(begin + last_record.second._offset, end,
+                                      last_id) &&
+                   last_id == last_record.first;
+        if (appended) {
+          file._size = mapped_file.size();
+          scanRecords(begin, end, last_record.second._offset, file._records);
+        }
+      }
+    }
+    if (!removed && !appended) {
+      // new and rewritten files are scanned in chunks on the pool
+      removed = !scanFiles({file_path}, {&file}, thread_pool)[0];
+    }
+    if (removed && !indexed) {
+      return false;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    auto file_iter = find_file(_files);
+    if (_dir_path != dir_path || (file_iter != _files.end()) != indexed ||
+        (indexed && (file_iter->_size != indexed_size ||
+                     file_iter->_mtime != indexed_mtime))) {
+      continue;
+    }
+    if (removed) {
+      _files.erase(file_iter);
+      buildRecords(_files, _records);
+    } else if (!indexed) {
+      _files.push_back(std::move(file));
+      addRecords(_files, static_cast<uint32_t>(_files.size() - 1), 0,
+                 _records);
+    } else if (appended) {
+      // the last record is scanned again, since it might have been
+      // incomplete
+      file_iter->_size = file._size;
+      file_iter->_mtime = file._mtime;
+      file_iter->_records.pop_back();
+      const size_t first = file_iter->_records.size();
+      file_iter->_records.insert(file_iter->_records.end(),
+                                 file._records.begin(), file._records.end());
+      addRecords(_files, static_cast<uint32_t>(file_iter - _files.begin()),
+                 first, _records);
+    } else {
+      file_iter->_size = file._size;
+      file_iter->_mtime = file._mtime;
+      file_iter->_records.swap(file._records);
+      buildRecords(_files, _records);
+    }
+    if (!_index_path.empty()) {
+      save(_index_path);
+    }
+    return true;
+  }
+}
+
+bool AMR::OrderIndex::find(const uint32_t order_id,
+                           AMR::OrderRecord &record) const {
+  std::shared_lock<std::shared_mutex> lock(_mutex);
+  auto record_iter = _records.find(order_id);
+  if (record_iter == _records.end()) {
+    return false;
+  }
+  record = record_iter->second;
+  return true;
+}
+
+AMR::OrderIndex::Status AMR::OrderIndex::lookup(
+    const uint32_t order_id, AMR::Coordinates2D &delivery_point,
+    std::vector<long long int> &ordered_products) const {
+  // the file is read without holding the lock
+  OrderRecord record;
+  std::string file_path;
+  uint64_t indexed_size = 0;
+  int64_t indexed_mtime = 0;
+  {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    auto record_iter = _records.find(order_id);
+    if (record_iter == _records.end()) {
+      return Status::kNotFound;
+    }
+    record = record_iter->second;
+    const IndexedFile &file = _files[record._file];
+    file_path = _dir_path + "/" + file._name;
+    indexed_size = file._size;
+    indexed_mtime = file._mtime;
+  }
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  if (!getFileStatus(file_path, size, mtime) || size != indexed_size ||
+      mtime != indexed_mtime) {
+    return Status::kOutdated;
+  }
+  std::ifstream stream(file_path, std::ios::binary);
+  std::string text(record._length, '\0');
+  if (!stream.seekg(static_cast<std::streamoff>(record._offset)) ||
+      !stream.read(&text[0], static_cast<std::streamsize>(record._length))) {
+    return Status::kOutdated;
+  }
+  return parseIndexedRecord(text.data(), text.data() + text.size(), order_id,
+                            delivery_point, ordered_products);
+}
+
+std::vector<AMR::OrderIndex::Status> AMR::OrderIndex::lookup(
+    const std::vector<uint32_t> &order_ids,
+    std::vector<AMR::OrderInformation> &orders) const {
+  std::vector<Status> statuses(order_ids.size(), Status::kNotFound);
+  orders.assign(order_ids.size(), AMR::OrderInformation());
+  // the records are probed under the lock and then read file by file, in
+  // the order of their offsets, each file being mapped once
+  struct Probe {
+    OrderRecord _record;
+    size_t _i;
+  };
+  struct ProbedFile {
+    std::string _path;
+    uint64_t _size;
+    int64_t _mtime;
+  };
+  std::vector<Probe> probes;
+  std::vector<ProbedFile> files;
+  {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    for (size_t i = 0; i < order_ids.size(); ++i) {
+      auto record_iter = _records.find(order_ids[i]);
+      if (record_iter != _records.end()) {
+        probes.push_back(Probe{record_iter->second, i});
+      }
+    }
+    for (const IndexedFile &file : _files) {
+      files.push_back(
+          ProbedFile{_dir_path + "/" + file._name, file._size, file._mtime});
+    }
+  }
+  std::sort(probes.begin(), probes.end(),
+            [](const Probe &a, const Probe &b) {
+              return a._record._file != b._record._file
+                         ? a._record._file < b._record._file
+                         : a._record._offset < b._record._offset;
+            });
+  for (auto probe_iter = probes.begin(); probe_iter != probes.end();) {
+    const ProbedFile &file = files[probe_iter->_record._file];
+    auto file_end = std::find_if(probe_iter, probes.end(),
+                                 [probe_iter](const Probe &probe) {
+                                   return probe._record._file !=
+                                          probe_iter->_record._file;
+                                 });
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    MappedFile mapped_file;
+    const bool unchanged = getFileStatus(file._path, size, mtime) &&
+                           size == file._size && mtime == file._mtime &&
+                           mapped_file.open(file._path, false) &&
+                           mapped_file.size() == size;
+    for (; probe_iter != file_end; ++probe_iter) {
+      const OrderRecord &record = probe_iter->_record;
+      const size_t i = probe_iter->_i;
+      if (!unchanged || record._offset + record._length > size) {
+        statuses[i] = Status::kOutdated;
+        continue;
+      }
+      const char *begin = mapped_file.data() + record._offset;
+      statuses[i] =
+          parseIndexedRecord(begin, begin + record._length, order_ids[i],
+                             orders[i]._delivery_point,
+                             orders[i]._ordered_products);
+      orders[i]._found = statuses[i] == Status::kFound;
+    }
+  }
+  return statuses;
+}
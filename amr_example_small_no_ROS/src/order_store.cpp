@@ -0,0 +1,318 @@
+#include "order_store.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "basic_routines.hpp"
+#include "yaml-cpp/yaml.h"
+
+namespace {
+//! Identifies files written by @ref AMR::OrderStore and their format version.
+const char kStoreMagic[8] = {'A', 'M', 'R', 'O', 'R', 'D', 'S', '2'};
+
+//! Size of the header: magic, number of orders, products and source files.
+constexpr size_t kHeaderSize = sizeof(kStoreMagic) + 3 * sizeof(uint64_t);
+
+static_assert(sizeof(long long int) == sizeof(int64_t),
+              "products are stored as 64 bit integers");
+
+/**
+ * @brief An order read from an order file.
+ */
+struct CompiledOrder {
+  uint32_t _id;                             //!< Id of the order.
+  uint32_t _file;                           //!< Index of the source file.
+  AMR::Coordinates2D _delivery_point;       //!< Delivery point.
+  std::vector<long long int> _products;     //!< Products of the order.
+};
+
+/**
+ * @brief Rounds a size up to the next multiple of 8 bytes.
+ */
+size_t alignColumn(const size_t size) { return (size + 7) / 8 * 8; }
+
+/**
+ * @brief Reads a value at a position of the mapped store and advances the
+ * position. Returns false if the value exceeds the store.
+ */
+template <typename Value>
+bool readValue(const AMR::MappedFile &file, size_t &position, Value &value) {
+  if (file.size() - position < sizeof(Value)) {
+    return false;
+  }
+  std::copy_n(file.data() + position, sizeof(Value),
+              reinterpret_cast<char *>(&value));
+  position += sizeof(Value);
+  return true;
+}
+
+/**
+ * @brief Appends all orders of a file, in the order of the file. Files in a
+ * layout the scanner does not know are parsed by yaml-cpp.
+ */
+bool readOrderFile(const std::string &file_path, const uint32_t file,
+                   std::vector<CompiledOrder> &orders) {
+  AMR::MappedFile mapped_file;
+  if (!mapped_file.open(file_path)) {
+    std::cout << "Error: Could not read " << file_path << std::endl;
+    return false;
+  }
+  const char *end = mapped_file.data() + mapped_file.size();
+  const char *record = AMR::findNextRecord(mapped_file.data(), end);
+  const size_t n_orders = orders.size();
+  bool rejected = !AMR::isPreamble(mapped_file.data(), record);
+  while (!rejected && record < end) {
+    const char *next_record = AMR::findNextRecord(
+        std::find(record, end, '\n'), end);
+    CompiledOrder order;
+    order._file = file;
+    rejected = AMR::parseOrderRecord(record, next_record, order._id,
+                                     order._delivery_point, order._products) !=
+               AMR::ScanResult::kFound;
+    orders.push_back(std::move(order));
+    record = next_record;
+  }
+  if (!rejected) {
+    return true;
+  }
+  orders.resize(n_orders);
+  try {
+    for (const auto &node : YAML::LoadFile(file_path)) {
+      CompiledOrder order;
+      order._id = node["order"].as<uint32_t>();
+      order._file = file;
+      order._delivery_point._x = node["cx"].as<double>();
+      order._delivery_point._y = node["cy"].as<double>();
+      for (const auto &product : node["products"]) {
+        order._products.push_back(product.as<long long int>());
+      }
+      orders.push_back(std::move(order));
+    }
+  } catch (const YAML::Exception &e) {
+    std::cout << "Error: Could not read " << file_path << ": " << e.what()
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+template <typename Value>
+void writeValue(std::ofstream &stream, const Value &value) {
+  stream.write(reinterpret_cast<const char *>(&value), sizeof(Value));
+}
+
+template <typename Value>
+void writeColumn(std::ofstream &stream, const std::vector<Value> &column) {
+  stream.write(reinterpret_cast<const char *>(column.data()),
+               column.size() * sizeof(Value));
+  const char padding[8] = {0};
+  stream.write(padding, alignColumn(column.size() * sizeof(Value)) -
+                            column.size() * sizeof(Value));
+}
+}  // namespace
+
+bool AMR::OrderStore::compile(const std::string &dir_path,
+                              const std::string &store_path) {
+  // the status of every file is taken before it is read, so a change while
+  // it is read marks its orders as outdated
+  std::vector<SourceFile> sources;
+  std::vector<CompiledOrder> orders;
+  for (const std::string &file_path : listOrderFiles(dir_path)) {
+    SourceFile source;
+    std::error_code error;
+    source._path = std::filesystem::absolute(file_path, error).string();
+    if (error || !getFileStatus(file_path, source._size, source._mtime)) {
+      std::cout << "Error: Could not read " << file_path << std::endl;
+      return false;
+    }
+    if (!readOrderFile(file_path, static_cast<uint32_t>(sources.size()),
+                       orders)) {
+      return false;
+    }
+    sources.push_back(std::move(source));
+  }
+  // the files are read in the order of their names, so the stable sort keeps
+  // the first record of every id in front
+  std::stable_sort(orders.begin(), orders.end(),
+                   [](const CompiledOrder &a, const CompiledOrder &b) {
+                     return a._id < b._id;
+                   });
+  orders.erase(std::unique(orders.begin(), orders.end(),
+                           [](const CompiledOrder &a, const CompiledOrder &b) {
+                             return a._id == b._id;
+                           }),
+               orders.end());
+
+  std::vector<uint32_t> ids, files;
+  std::vector<float> x, y;
+  std::vector<uint64_t> offsets{0};
+  std::vector<int64_t> products;
+  for (const CompiledOrder &order : orders) {
+    ids.push_back(order._id);
+    files.push_back(order._file);
+    x.push_back(static_cast<float>(order._delivery_point._x));
+    y.push_back(static_cast<float>(order._delivery_point._y));
+    products.insert(products.end(), order._products.begin(),
+                    order._products.end());
+    offsets.push_back(products.size());
+  }
+
+  // the store is replaced atomically, so an open mapping of the old store
+  // stays valid
+  const std::string temporary_path = store_path + ".tmp";
+  {
+    std::ofstream stream(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+      std::cout << "Error: Could not write " << store_path << std::endl;
+      return false;
+    }
+    stream.write(kStoreMagic, sizeof(kStoreMagic));
+    writeValue(stream, static_cast<uint64_t>(ids.size()));
+    writeValue(stream, static_cast<uint64_t>(products.size()));
+    writeValue(stream, static_cast<uint64_t>(sources.size()));
+    for (const SourceFile &source : sources) {
+      writeValue(stream, static_cast<uint64_t>(source._path.size()));
+      writeColumn(stream, std::vector<char>(source._path.begin(),
+                                            source._path.end()));
+      writeValue(stream, source._size);
+      writeValue(stream, source._mtime);
+    }
+    writeColumn(stream, ids);
+    writeColumn(stream, files);
+    writeColumn(stream, x);
+    writeColumn(stream, y);
+    writeColumn(stream, offsets);
+    writeColumn(stream, products);
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary_path, store_path, error);
+  if (error) {
+    std::cout << "Error: Could not write " << store_path << std::endl;
+    std::filesystem::remove(temporary_path, error);
+    return false;
+  }
+  return true;
+}
+
+bool AMR::OrderStore::open(const std::string &store_path) {
+  close();
+  // the ids are searched by bisection, so the pages are accessed at random
+  if (!_file.open(store_path, false) || _file.size() < kHeaderSize ||
+      !std::equal(kStoreMagic, kStoreMagic + sizeof(kStoreMagic),
+                  _file.data())) {
+    _file.close();
+    return false;
+  }
+  size_t position = sizeof(kStoreMagic);
+  uint64_t n_orders = 0, n_products = 0, n_sources = 0;
+  readValue(_file, position, n_orders);
+  readValue(_file, position, n_products);
+  readValue(_file, position, n_sources);
+  // the counts are checked before computing the column sizes to avoid an
+  // overflow
+  const uint64_t max_count = _file.size() / sizeof(uint32_t);
+  if (n_orders > max_count || n_products > max_count ||
+      n_sources > max_count) {
+    _file.close();
+    return false;
+  }
+  for (uint64_t source = 0; source < n_sources; ++source) {
+    SourceFile source_file;
+    uint64_t path_length = 0;
+    if (!readValue(_file, position, path_length) ||
+        path_length > _file.size() - position) {
+      close();
+      return false;
+    }
+    source_file._path.assign(_file.data() + position, path_length);
+    position += alignColumn(path_length);
+    if (position > _file.size() ||
+        !readValue(_file, position, source_file._size) ||
+        !readValue(_file, position, source_file._mtime)) {
+      close();
+      return false;
+    }
+    _sources.push_back(std::move(source_file));
+  }
+  const size_t ids_offset = position;
+  const size_t files_offset =
+      ids_offset + alignColumn(n_orders * sizeof(uint32_t));
+  const size_t x_offset =
+      files_offset + alignColumn(n_orders * sizeof(uint32_t));
+  const size_t y_offset = x_offset + alignColumn(n_orders * sizeof(float));
+  const size_t offsets_offset =
+      y_offset + alignColumn(n_orders * sizeof(float));
+  const size_t products_offset =
+      offsets_offset + (n_orders + 1) * sizeof(uint64_t);
+  if (products_offset + n_products * sizeof(int64_t) != _file.size()) {
+    close();
+    return false;
+  }
+  // the mapping is page aligned and every column starts at a multiple of 8
+  _n_orders = n_orders;
+  _ids = reinterpret_cast<const uint32_t *>(_file.data() + ids_offset);
+  _files = reinterpret_cast<const uint32_t *>(_file.data() + files_offset);
+  _x = reinterpret_cast<const float *>(_file.data() + x_offset);
+  _y = reinterpret_cast<const float *>(_file.data() + y_offset);
+  _offsets = reinterpret_cast<const uint64_t *>(_file.data() + offsets_offset);
+  _products = reinterpret_cast<const int64_t *>(_file.data() + products_offset);
+  if (_offsets[n_orders] != n_products) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void AMR::OrderStore::close() {
+  _file.close();
+  _n_orders = 0;
+  _ids = nullptr;
+  _sources.clear();
+}
+
+bool AMR::OrderStore::find(const uint32_t order_id,
+                           AMR::StoredOrder &order) const {
+  if (_ids == nullptr) {
+    return false;
+  }
+  const uint32_t *id = std::lower_bound(_ids, _ids + _n_orders, order_id);
+  if (id == _ids + _n_orders || *id != order_id) {
+    return false;
+  }
+  const size_t i = id - _ids;
+  // a corrupted offset column must not point outside of the products
+  const uint64_t first = std::min(_offsets[i], _offsets[_n_orders]);
+  const uint64_t last = std::min(_offsets[i + 1], _offsets[_n_orders]);
+  order._x = _x[i];
+  order._y = _y[i];
+  order._products = _products + first;
+  order._n_products = last > first ? last - first : 0;
+  order._file = _files[i];
+  return true;
+}
+
+bool AMR::OrderStore::lookup(
+    const uint32_t order_id, AMR::Coordinates2D &delivery_point,
+    std::vector<long long int> &ordered_products) const {
+  StoredOrder order;
+  if (!find(order_id, order) || !isCurrent(order._file)) {
+    return false;
+  }
+  delivery_point._x = order._x;
+  delivery_point._y = order._y;
+  ordered_products.insert(ordered_products.end(), order._products,
+                          order._products + order._n_products);
+  return true;
+}
+
+bool AMR::OrderStore::isCurrent(const uint32_t file) const {
+  if (file >= _sources.size()) {
+    return false;
+  }
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  return getFileStatus(_sources[file]._path, size, mtime) &&
+         size == _sources[file]._size && mtime == _sources[file]._mtime;
+}
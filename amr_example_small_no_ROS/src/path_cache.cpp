@@ -0,0 +1,173 @@
+#include "path_cache.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <set>
+
+#include "basic_routines.hpp"
+#include "yaml-cpp/yaml.h"
+
+AMR::PathCache::PathCache(const size_t capacity, const double grid_resolution)
+    : _capacity(capacity),
+      _grid_resolution(grid_resolution > 0.0 ? grid_resolution : 1.0),
+      _hits(0),
+      _misses(0) {}
+
+size_t AMR::PathCache::KeyHash::operator()(const Key &key) const {
+  // combine the hashes as boost::hash_combine does
+  size_t seed = key._part_ids.size();
+  auto combine = [&seed](const long long int value) {
+    seed ^= std::hash<long long int>()(value) + 0x9e3779b9 + (seed << 6) +
+            (seed >> 2);
+  };
+  for (long long int part_id : key._part_ids) {
+    combine(part_id);
+  }
+  combine(key._start_x);
+  combine(key._start_y);
+  combine(key._delivery_x);
+  combine(key._delivery_y);
+  return seed;
+}
+
+AMR::PathCache::Key AMR::PathCache::makeKey(
+    const std::vector<long long int> &part_ids,
+    const AMR::Coordinates2D &starting_point,
+    const AMR::Coordinates2D &delivery_point) const {
+  Key key;
+  key._part_ids = part_ids;
+  key._start_x = llround(starting_point._x / _grid_resolution);
+  key._start_y = llround(starting_point._y / _grid_resolution);
+  key._delivery_x = llround(delivery_point._x / _grid_resolution);
+  key._delivery_y = llround(delivery_point._y / _grid_resolution);
+  return key;
+}
+
+bool AMR::PathCache::find(const std::vector<long long int> &part_ids,
+                          const AMR::Coordinates2D &starting_point,
+                          const AMR::Coordinates2D &delivery_point,
+                          std::vector<long long int> &pickup_order) {
+  const Key key = makeKey(part_ids, starting_point, delivery_point);
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto index_iter = _index.find(key);
+  if (index_iter == _index.end()) {
+    ++_misses;
+    return false;
+  }
+  ++_hits;
+  // mark the entry as most recently used
+  _entries.splice(_entries.begin(), _entries, index_iter->second);
+  pickup_order = index_iter->second->second;
+  return true;
+}
+
+void AMR::PathCache::insert(const std::vector<long long int> &part_ids,
+                            const AMR::Coordinates2D &starting_point,
+                            const AMR::Coordinates2D &delivery_point,
+                            const std::vector<long long int> &pickup_order) {
+  if (_capacity == 0) {
+    return;
+  }
+  Key key = makeKey(part_ids, starting_point, delivery_point);
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto index_iter = _index.find(key);
+  if (index_iter != _index.end()) {
+    index_iter->second->second = pickup_order;
+    _entries.splice(_entries.begin(), _entries, index_iter->second);
+    return;
+  }
+  if (_entries.size() >= _capacity) {
+    // remove the least recently used entry
+    _index.erase(_entries.back().first);
+    _entries.pop_back();
+  }
+  _entries.emplace_front(key, pickup_order);
+  _index.emplace(std::move(key), _entries.begin());
+}
+
+size_t AMR::PathCache::preload(
+    const std::string &dir_path, const size_t n_days,
+    const std::vector<AMR::Product> &all_products,
+    const std::vector<AMR::ProductPart> &all_product_parts,
+    const AMR::Coordinates2D &starting_point,
+    const AMR::PathSolverOptions &options,
+    const AMR::CatalogPathTable *catalog_table,
+    const AMR::CatalogDistanceMatrix *catalog_distances,
+    const AMR::WarehouseGraph *warehouse_graph) {
+  // there is one order file per day and the file names are sorted by date
+  std::vector<std::string> file_names = listOrderFiles(dir_path);
+  if (file_names.size() > n_days) {
+    file_names.erase(file_names.begin(), file_names.end() - n_days);
+  }
+  size_t n_inserted = 0;
+  AMR::Coordinates2D current_point = starting_point;
+  for (const std::string &file_name : file_names) {
+    try {
+      YAML::Node orders = YAML::LoadFile(file_name);
+      for (const auto &order : orders) {
+        AMR::Coordinates2D delivery_point(order["cx"].as<double>(),
+                                          order["cy"].as<double>());
+        std::set<long long int> part_set;
+        for (const auto &product : order["products"]) {
+          long long int product_id = product.as<long long int>();
+          if (product_id < 0 ||
+              product_id >= static_cast<long long int>(all_products.size())) {
+            continue;
+          }
+          for (const auto &part : all_products[product_id]._parts) {
+            part_set.insert(part.first);
+          }
+        }
+        std::vector<long long int> part_ids(part_set.begin(), part_set.end());
+        std::vector<AMR::Coordinates2D> part_locations;
+        for (long long int part_id : part_ids) {
+          part_locations.push_back(all_product_parts[part_id]._coords);
+        }
+        // the orders are solved as when they are executed, and only paths
+        // that would be cached then are inserted
+        std::vector<int> pickup_order;
+        bool reusable = false;
+        determineOrderPath(current_point, part_locations, delivery_point,
+                           pickup_order, options, catalog_table,
+                           catalog_distances, warehouse_graph, reusable);
+        if (reusable) {
+          std::vector<long long int> pickup_part_ids;
+          for (int position : pickup_order) {
+            pickup_part_ids.push_back(part_ids[position]);
+          }
+          insert(part_ids, current_point, delivery_point, pickup_part_ids);
+          ++n_inserted;
+        }
+        current_point = delivery_point;
+      }
+    } catch (const YAML::Exception &e) {
+      std::cout << "Warning: Could not preload orders of " << file_name << ": "
+                << e.what() << std::endl;
+    }
+  }
+  return n_inserted;
+}
+
+void AMR::PathCache::clear() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _entries.clear();
+  _index.clear();
+}
+
+size_t AMR::PathCache::size() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _entries.size();
+}
+
+uint64_t AMR::PathCache::getHits() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _hits;
+}
+
+uint64_t AMR::PathCache::getMisses() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _misses;
+}
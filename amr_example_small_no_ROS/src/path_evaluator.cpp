@@ -0,0 +1,251 @@
+#include "path_evaluator.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AMR_X86_KERNELS
+#endif
+
+namespace {
+/**
+ * @brief Evaluates pickup orders one after the other.
+ *
+ * All kernels add the legs of a path in the same sequence, so they produce
+ * bitwise identical results.
+ */
+template <typename Value>
+void evaluatePathLengthsScalar(const Value *distances, const size_t n_nodes,
+                               const int32_t *pickup_orders,
+                               const size_t n_orders, Value *path_lengths) {
+  const size_t n_parts = n_nodes - 2;
+  for (size_t order = 0; order < n_orders; ++order) {
+    const int32_t *pickup_order = pickup_orders + order * n_parts;
+    Value path_length = 0;
+    size_t previous = 0;
+    for (size_t i = 0; i < n_parts; ++i) {
+      const size_t current = static_cast<size_t>(pickup_order[i]) + 1;
+      path_length += distances[previous * n_nodes + current];
+      previous = current;
+    }
+    path_length += distances[previous * n_nodes + n_nodes - 1];
+    path_lengths[order] = path_length;
+  }
+}
+
+#ifdef AMR_X86_KERNELS
+/**
+ * @brief Evaluates two pickup orders at once with SSE2.
+ *
+ * SSE2 has no gather instruction, so the distances are loaded separately and
+ * only the additions are vectorized.
+ */
+void evaluatePathLengthsSse2(const double *distances, const size_t n_nodes,
+                             const int32_t *pickup_orders,
+                             const size_t n_orders, double *path_lengths) {
+  const size_t n_parts = n_nodes - 2;
+  size_t order = 0;
+  for (; order + 2 <= n_orders; order += 2) {
+    const int32_t *order_0 = pickup_orders + order * n_parts;
+    const int32_t *order_1 = order_0 + n_parts;
+    __m128d path_length = _mm_setzero_pd();
+    size_t previous_0 = 0, previous_1 = 0;
+    for (size_t i = 0; i <= n_parts; ++i) {
+      const size_t current_0 =
+          i < n_parts ? static_cast<size_t>(order_0[i]) + 1 : n_nodes - 1;
+      const size_t current_1 =
+          i < n_parts ? static_cast<size_t>(order_1[i]) + 1 : n_nodes - 1;
+      path_length = _mm_add_pd(
+          path_length, _mm_set_pd(distances[previous_1 * n_nodes + current_1],
+                                  distances[previous_0 * n_nodes + current_0]));
+      previous_0 = current_0;
+      previous_1 = current_1;
+    }
+    _mm_storeu_pd(path_lengths + order, path_length);
+  }
+  evaluatePathLengthsScalar(distances, n_nodes, pickup_orders + order * n_parts,
+                            n_orders - order, path_lengths + order);
+}
+
+/**
+ * @brief Gathers four distances. The masked gather with an explicit zero
+ * source is used, since the unmasked intrinsic leaves its source register
+ * uninitialized, which GCC reports when optimizing.
+ */
+__attribute__((target("avx2"))) inline __m256d gatherDistancesAvx2(
+    const double *distances, const __m128i index) {
+  return _mm256_mask_i32gather_pd(
+      _mm256_setzero_pd(), distances, index,
+      _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+}
+
+/**
+ * @brief Evaluates four pickup orders of doubles at once with AVX2.
+ *
+ * The part indices of the four orders and the distances are both loaded with
+ * gather instructions.
+ */
+__attribute__((target("avx2"))) void evaluatePathLengthsAvx2(
+    const double *distances, const size_t n_nodes,
+    const int32_t *pickup_orders, const size_t n_orders,
+    double *path_lengths) {
+  const size_t n_parts = n_nodes - 2;
+  const int stride = static_cast<int>(n_parts);
+  const __m128i order_offsets =
+      _mm_setr_epi32(0, stride, 2 * stride, 3 * stride);
+  const __m128i row_length = _mm_set1_epi32(static_cast<int>(n_nodes));
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i delivery_node = _mm_set1_epi32(static_cast<int>(n_nodes - 1));
+  size_t order = 0;
+  for (; order + 4 <= n_orders; order += 4) {
+    const int32_t *orders = pickup_orders + order * n_parts;
+    __m256d path_length = _mm256_setzero_pd();
+    __m128i previous = _mm_setzero_si128();
+    for (size_t i = 0; i < n_parts; ++i) {
+      const __m128i current = _mm_add_epi32(
+          _mm_i32gather_epi32(orders + i, order_offsets, 4), one);
+      const __m128i index =
+          _mm_add_epi32(_mm_mullo_epi32(previous, row_length), current);
+      path_length =
+          _mm256_add_pd(path_length, gatherDistancesAvx2(distances, index));
+      previous = current;
+    }
+    const __m128i index =
+        _mm_add_epi32(_mm_mullo_epi32(previous, row_length), delivery_node);
+    path_length =
+        _mm256_add_pd(path_length, gatherDistancesAvx2(distances, index));
+    _mm256_storeu_pd(path_lengths + order, path_length);
+  }
+  evaluatePathLengthsScalar(distances, n_nodes, pickup_orders + order * n_parts,
+                            n_orders - order, path_lengths + order);
+}
+
+/**
+ * @brief Gathers and adds 32-bit distances, eight lanes at a time.
+ */
+template <typename Value>
+struct Avx2Lanes;
+
+template <>
+struct Avx2Lanes<float> {
+  typedef __m256 Vector;
+  __attribute__((target("avx2"))) static Vector zero() {
+    return _mm256_setzero_ps();
+  }
+  __attribute__((target("avx2"))) static Vector gatherAdd(
+      const Vector sum, const float *distances, const __m256i index) {
+    return _mm256_add_ps(sum, _mm256_i32gather_ps(distances, index, 4));
+  }
+  __attribute__((target("avx2"))) static void store(float *path_lengths,
+                                                    const Vector sum) {
+    _mm256_storeu_ps(path_lengths, sum);
+  }
+};
+
+template <>
+struct Avx2Lanes<int32_t> {
+  typedef __m256i Vector;
+  __attribute__((target("avx2"))) static Vector zero() {
+    return _mm256_setzero_si256();
+  }
+  __attribute__((target("avx2"))) static Vector gatherAdd(
+      const Vector sum, const int32_t *distances, const __m256i index) {
+    return _mm256_add_epi32(
+        sum, _mm256_i32gather_epi32(
+                 reinterpret_cast<const int *>(distances), index, 4));
+  }
+  __attribute__((target("avx2"))) static void store(int32_t *path_lengths,
+                                                    const Vector sum) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(path_lengths), sum);
+  }
+};
+
+/**
+ * @brief Evaluates eight pickup orders of 32-bit distances at once with
+ * AVX2, in the same way as the kernel for doubles.
+ */
+template <typename Value>
+__attribute__((target("avx2"))) void evaluatePathLengthsAvx2(
+    const Value *distances, const size_t n_nodes,
+    const int32_t *pickup_orders, const size_t n_orders,
+    Value *path_lengths) {
+  typedef Avx2Lanes<Value> Lanes;
+  const size_t n_parts = n_nodes - 2;
+  const int stride = static_cast<int>(n_parts);
+  const __m256i order_offsets =
+      _mm256_setr_epi32(0, stride, 2 * stride, 3 * stride, 4 * stride,
+                        5 * stride, 6 * stride, 7 * stride);
+  const __m256i row_length = _mm256_set1_epi32(static_cast<int>(n_nodes));
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i delivery_node =
+      _mm256_set1_epi32(static_cast<int>(n_nodes - 1));
+  size_t order = 0;
+  for (; order + 8 <= n_orders; order += 8) {
+    const int32_t *orders = pickup_orders + order * n_parts;
+    typename Lanes::Vector path_length = Lanes::zero();
+    __m256i previous = _mm256_setzero_si256();
+    for (size_t i = 0; i < n_parts; ++i) {
+      const __m256i current = _mm256_add_epi32(
+          _mm256_i32gather_epi32(orders + i, order_offsets, 4), one);
+      const __m256i index =
+          _mm256_add_epi32(_mm256_mullo_epi32(previous, row_length), current);
+      path_length = Lanes::gatherAdd(path_length, distances, index);
+      previous = current;
+    }
+    const __m256i index = _mm256_add_epi32(
+        _mm256_mullo_epi32(previous, row_length), delivery_node);
+    path_length = Lanes::gatherAdd(path_length, distances, index);
+    Lanes::store(path_lengths + order, path_length);
+  }
+  evaluatePathLengthsScalar(distances, n_nodes, pickup_orders + order * n_parts,
+                            n_orders - order, path_lengths + order);
+}
+#endif
+}  // namespace
+
+template <>
+void AMR::evaluatePathLengthBatch<double>(
+    const double *distances, const size_t n_nodes,
+    const int32_t *pickup_orders, const size_t n_orders, double *path_lengths,
+    const SimdLevel simd_level) {
+  switch (simd_level) {
+#ifdef AMR_X86_KERNELS
+    case SimdLevel::kAvx2:
+      evaluatePathLengthsAvx2(distances, n_nodes, pickup_orders, n_orders,
+                              path_lengths);
+      break;
+    case SimdLevel::kSse2:
+      evaluatePathLengthsSse2(distances, n_nodes, pickup_orders, n_orders,
+                              path_lengths);
+      break;
+#endif
+    default:
+      evaluatePathLengthsScalar(distances, n_nodes, pickup_orders, n_orders,
+                                path_lengths);
+      break;
+  }
+}
+
+template <typename Value>
+void AMR::evaluatePathLengthBatch(const Value *distances, const size_t n_nodes,
+                                  const int32_t *pickup_orders,
+                                  const size_t n_orders, Value *path_lengths,
+                                  const SimdLevel simd_level) {
+#ifdef AMR_X86_KERNELS
+  if (simd_level == SimdLevel::kAvx2) {
+    evaluatePathLengthsAvx2<Value>(distances, n_nodes, pickup_orders, n_orders,
+                                   path_lengths);
+    return;
+  }
+#endif
+  evaluatePathLengthsScalar(distances, n_nodes, pickup_orders, n_orders,
+                            path_lengths);
+}
+
+template void AMR::evaluatePathLengthBatch<float>(const float *, const size_t,
+                                                  const int32_t *,
+                                                  const size_t, float *,
+                                                  const SimdLevel);
+template void AMR::evaluatePathLengthBatch<int32_t>(const int32_t *,
+                                                    const size_t,
+                                                    const int32_t *,
+                                                    const size_t, int32_t *,
+                                                    const SimdLevel);
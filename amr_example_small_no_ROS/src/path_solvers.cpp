@@ -0,0 +1,935 @@
+#include "path_solvers.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+
+namespace {
+/**
+ * @brief Removes bit @p j (which must not be set) from @p subset and shifts
+ * all higher bits down by one position.
+ */
+inline size_t compressSubset(const size_t subset, const size_t j) {
+  return (subset & ((size_t{1} << j) - 1)) | ((subset >> (j + 1)) << j);
+}
+/**
+ * @brief Determines the nearest neighbor path. Ties are resolved in favor of
+ * the lower index.
+ *
+ * @param[in] distances Distance matrix of the order.
+ * @param[out] pickup_order Order in which the parts are picked up.
+ * @return Length of the path.
+ */
+double nearestNeighborPath(const AMR::DistanceMatrix &distances,
+                           std::vector<int> &pickup_order) {
+  const size_t n = distances.getNumberOfParts();
+  pickup_order.resize(n);
+  std::vector<char> visited(n + 1, 0);
+  size_t current = 0;
+  double path_length = 0.0;
+  for (size_t position = 0; position < n; ++position) {
+    size_t next = 0;
+    double next_distance = std::numeric_limits<double>::max();
+    const double *distances_from_current = distances.getRow(current);
+    for (size_t node = 1; node <= n; ++node) {
+      if (!visited[node] && distances_from_current[node] < next_distance) {
+        next_distance = distances_from_current[node];
+        next = node;
+      }
+    }
+    visited[next] = 1;
+    pickup_order[position] = static_cast<int>(next - 1);
+    path_length += next_distance;
+    current = next;
+  }
+  return path_length + distances(current, n + 1);
+}
+
+/**
+ * @brief Depth-first branch-and-bound search over partial pickup orders.
+ *
+ * Nodes are numbered as in @ref AMR::DistanceMatrix.
+ */
+class BranchAndBoundSearch {
+ public:
+  /**
+   * @brief Construct a new search.
+   *
+   * @param[in] distances Distance matrix of the order.
+   * @param[in] lower_bound Lower bound used to prune partial pickup orders.
+   * @param[in,out] statistics Counters that are updated during the search.
+   * @param[in] deadline If not null, the search stops when it expires.
+   */
+  BranchAndBoundSearch(const AMR::DistanceMatrix &distances,
+                       const AMR::LowerBound lower_bound,
+                       AMR::PathSolverStatistics &statistics,
+                       const AMR::Deadline *deadline)
+      : _distances(distances),
+        _n(distances.getNumberOfParts()),
+        _lower_bound(lower_bound),
+        _statistics(statistics),
+        _deadline(deadline),
+        _stopped(false),
+        _visited(_n + 2, 0),
+        _path(_n),
+        _candidates(_n, std::vector<size_t>(_n)),
+        _tree_distances(_n + 2){};
+
+  /**
+   * @brief Runs the search.
+   *
+   * @param[in,out] pickup_order  On input the best known pickup order, on
+   * output the shortest one.
+   * @param[in] best_length Length of the path given by @p pickup_order.
+   * @return Length of the shortest path.
+   */
+  double run(std::vector<int> &pickup_order, const double best_length) {
+    _best_length = best_length;
+    _best_path.resize(_n);
+    for (size_t i = 0; i < _n; ++i) {
+      _best_path[i] = static_cast<size_t>(pickup_order[i]) + 1;
+    }
+    search(0, 0, 0.0);
+    for (size_t i = 0; i < _n; ++i) {
+      pickup_order[i] = static_cast<int>(_best_path[i] - 1);
+    }
+    return _best_length;
+  }
+
+ private:
+  double distance(const size_t from, const size_t to) const {
+    return _distances(from, to);
+  }
+
+  void search(const size_t depth, const size_t current,
+              const double prefix_length) {
+    ++_statistics._nodes_explored;
+    // reading the clock is comparatively expensive, so it is done only for
+    // every 1024th node
+    if (_deadline && (_statistics._nodes_explored & 1023) == 0 &&
+        _deadline->expired()) {
+      _stopped = true;
+    }
+    if (_stopped) {
+      return;
+    }
+    if (depth == _n) {
+      const double length = prefix_length + distance(current, _n + 1);
+      if (length < _best_length) {
+        _best_length = length;
+        _best_path = _path;
+      }
+      return;
+    }
+    if (prefix_length + lowerBound(current) >= _best_length) {
+      ++_statistics._nodes_pruned;
+      return;
+    }
+    // explore the closest unvisited locations first, so that good paths are
+    // found early and tighten the pruning
+    std::vector<size_t> &candidates = _candidates[depth];
+    size_t n_candidates = 0;
+    for (size_t node = 1; node <= _n; ++node) {
+      if (!_visited[node]) {
+        candidates[n_candidates++] = node;
+      }
+    }
+    std::stable_sort(candidates.begin(), candidates.begin() + n_candidates,
+                     [this, current](const size_t a, const size_t b) {
+                       return distance(current, a) < distance(current, b);
+                     });
+    for (size_t i = 0; i < n_candidates && !_stopped; ++i) {
+      const size_t next = candidates[i];
+      _visited[next] = 1;
+      _path[depth] = next;
+      search(depth + 1, next, prefix_length + distance(current, next));
+      _visited[next] = 0;
+    }
+  }
+
+  /**
+   * @brief Lower bound for the path from @p current through all unvisited
+   * locations (there is at least one) to the delivery point.
+   */
+  double lowerBound(const size_t current) {
+    const size_t delivery = _n + 1;
+    if (_lower_bound == AMR::LowerBound::kNearestNeighbor) {
+      // every unvisited location is entered from the current or another
+      // unvisited location, the delivery point from an unvisited location
+      double bound = 0.0;
+      double delivery_edge = std::numeric_limits<double>::max();
+      for (size_t v = 1; v <= _n; ++v) {
+        if (_visited[v]) {
+          continue;
+        }
+        double incoming_edge = distance(current, v);
+        for (size_t w = 1; w <= _n; ++w) {
+          if (!_visited[w] && w != v) {
+            incoming_edge = std::min(incoming_edge, distance(w, v));
+          }
+        }
+        bound += incoming_edge;
+        delivery_edge = std::min(delivery_edge, distance(v, delivery));
+      }
+      return bound + delivery_edge;
+    }
+    // Prim's algorithm on the current location, the unvisited locations and
+    // the delivery point. The remaining path is a spanning tree of these.
+    double bound = 0.0;
+    for (size_t v = 1; v <= delivery; ++v) {
+      _tree_distances[v] = _visited[v] ? -1.0 : distance(current, v);
+    }
+    while (true) {
+      size_t closest = 0;
+      double closest_distance = std::numeric_limits<double>::max();
+      for (size_t v = 1; v <= delivery; ++v) {
+        if (_tree_distances[v] >= 0.0 &&
+            _tree_distances[v] < closest_distance) {
+          closest_distance = _tree_distances[v];
+          closest = v;
+        }
+      }
+      if (closest == 0) {
+        break;
+      }
+      bound += closest_distance;
+      _tree_distances[closest] = -1.0;
+      for (size_t v = 1; v <= delivery; ++v) {
+        if (_tree_distances[v] >= 0.0) {
+          _tree_distances[v] =
+              std::min(_tree_distances[v], distance(closest, v));
+        }
+      }
+    }
+    return bound;
+  }
+
+  const AMR::DistanceMatrix &_distances;  //!< Distances between the nodes.
+  const size_t _n;                        //!< Number of part locations.
+  const AMR::LowerBound _lower_bound;     //!< Bound used for pruning.
+  AMR::PathSolverStatistics &_statistics;  //!< Search counters.
+  const AMR::Deadline *_deadline;  //!< Deadline of the search, may be null.
+  bool _stopped;  //!< Set when the deadline expired during the search.
+  std::vector<char> _visited;  //!< Marks the nodes of the current prefix.
+  std::vector<size_t> _path;   //!< Nodes of the current prefix.
+  std::vector<std::vector<size_t>>
+      _candidates;  //!< Unvisited nodes for each depth.
+  std::vector<double>
+      _tree_distances;  //!< Distances to the spanning tree in Prim's
+                        //!< algorithm, negative for nodes in the tree.
+  std::vector<size_t> _best_path;  //!< Nodes of the shortest known path.
+  double _best_length;             //!< Length of the shortest known path.
+};
+/**
+ * @brief Local search that improves a path by 2-opt and Or-opt moves.
+ *
+ * Nodes are numbered as in @ref AMR::DistanceMatrix. The path is stored as a
+ * sequence of nodes that starts with the starting point and ends with the
+ * delivery point; both are never moved.
+ */
+class LocalSearch {
+ public:
+  /**
+   * @brief Construct a new local search.
+   *
+   * @param[in] distances Distance matrix of the order.
+   * @param[in] neighbor_list_size Number of closest part locations that are
+   * considered for each node.
+   */
+  LocalSearch(const AMR::DistanceMatrix &distances,
+              const size_t neighbor_list_size)
+      : _distances(distances),
+        _n(distances.getNumberOfParts()),
+        _m(distances.getNumberOfNodes()),
+        _n_neighbors(std::min(neighbor_list_size, _n)),
+        _neighbors(_m * _n_neighbors),
+        _path(_m),
+        _position(_m) {
+    const size_t n = _n;
+    // the closest part locations of every node
+    std::vector<size_t> candidates(n);
+    for (size_t node = 0; node < _m; ++node) {
+      std::iota(candidates.begin(), candidates.end(), 1);
+      if (node > 0 && node <= n) {
+        // a node is not its own neighbor
+        std::swap(candidates[node - 1], candidates.back());
+      }
+      const size_t n_candidates = (node > 0 && node <= n) ? n - 1 : n;
+      const size_t n_neighbors = std::min(_n_neighbors, n_candidates);
+      auto closer = [this, node](const size_t a, const size_t b) {
+        return distance(node, a) < distance(node, b) ||
+               (distance(node, a) == distance(node, b) && a < b);
+      };
+      std::partial_sort(candidates.begin(), candidates.begin() + n_neighbors,
+                        candidates.begin() + n_candidates, closer);
+      for (size_t k = 0; k < _n_neighbors; ++k) {
+        // missing neighbors (only for n <= neighbor_list_size) are marked by
+        // the starting point, which is never a neighbor otherwise
+        _neighbors[node * _n_neighbors + k] =
+            k < n_neighbors ? candidates[k] : 0;
+      }
+    }
+  }
+
+  /**
+   * @brief Improves a pickup order until no improving move is left.
+   *
+   * @param[in,out] pickup_order Order in which the parts are picked up.
+   * @return Length of the improved path.
+   */
+  double run(std::vector<int> &pickup_order) {
+    _path[0] = 0;
+    for (size_t i = 0; i < _n; ++i) {
+      _path[i + 1] = static_cast<size_t>(pickup_order[i]) + 1;
+    }
+    _path[_m - 1] = _n + 1;
+    updatePositions(0, _m);
+    // each applied move shortens the path, the limit is only a safeguard
+    // against cycling due to rounding
+    constexpr size_t max_rounds = 1000;
+    for (size_t round = 0; round < max_rounds; ++round) {
+      const bool improved_two_opt = twoOptPass();
+      const bool improved_or_opt = orOptPass();
+      if (!improved_two_opt && !improved_or_opt) {
+        break;
+      }
+    }
+    double path_length = 0.0;
+    for (size_t i = 0; i + 1 < _m; ++i) {
+      path_length += distance(_path[i], _path[i + 1]);
+    }
+    for (size_t i = 0; i < _n; ++i) {
+      pickup_order[i] = static_cast<int>(_path[i + 1] - 1);
+    }
+    return path_length;
+  }
+
+ private:
+  double distance(const size_t from, const size_t to) const {
+    return _distances(from, to);
+  }
+
+  void updatePositions(const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      _position[_path[i]] = i;
+    }
+  }
+
+  /**
+   * @brief Applies all improving 2-opt moves found in one sweep over the path.
+   *
+   * A 2-opt move removes two edges and reconnects the path by reversing the
+   * subpath between them. For every node a, the moves that connect a to one
+   * of its neighbors c are tried, removing either the edges leaving a and c
+   * or the edges entering a and c.
+   */
+  bool twoOptPass() {
+    bool improved = false;
+    for (size_t i = 0; i < _m; ++i) {
+      const size_t a = _path[i];
+      for (const bool successor : {true, false}) {
+        if ((successor && i + 1 == _m) || (!successor && i == 0)) {
+          continue;
+        }
+        const size_t b = successor ? _path[i + 1] : _path[i - 1];
+        const double length_ab = distance(a, b);
+        for (size_t k = 0; k < _n_neighbors; ++k) {
+          const size_t c = _neighbors[a * _n_neighbors + k];
+          // neighbors are sorted, so no later neighbor can shorten (a, b)
+          if (c == 0 || distance(a, c) >= length_ab) {
+            break;
+          }
+          const size_t j = _position[c];
+          if (!successor && j == 0) {
+            continue;
+          }
+          // d is the node connected to c by the second removed edge
+          const size_t d = successor ? _path[j + 1] : _path[j - 1];
+          const double delta =
+              distance(a, c) + distance(b, d) - length_ab - distance(c, d);
+          if (delta < -kMinImprovement && d != a && c != b) {
+            // reverse the nodes between the two removed edges
+            size_t begin = 0, end = 0;
+            if (successor) {
+              begin = std::min(i, j) + 1;
+              end = std::max(i, j) + 1;
+            } else {
+              begin = std::min(i, j);
+              end = std::max(i, j);
+            }
+            std::reverse(_path.begin() + begin, _path.begin() + end);
+            updatePositions(begin, end);
+            improved = true;
+            break;
+          }
+        }
+      }
+    }
+    return improved;
+  }
+
+  /**
+   * @brief Applies all improving Or-opt moves found in one sweep over the path.
+   *
+   * An Or-opt move removes a segment of up to three consecutive locations
+   * and reinserts it, possibly reversed, between two other adjacent nodes
+   * next to a neighbor of one of its end nodes.
+   */
+  bool orOptPass() {
+    bool improved = false;
+    for (size_t length = 1; length <= 3; ++length) {
+      for (size_t i = 1; i + length < _m; ++i) {
+        const size_t first = _path[i];
+        const size_t last = _path[i + length - 1];
+        const size_t previous = _path[i - 1];
+        const size_t next = _path[i + length];
+        const double removal_gain = distance(previous, first) +
+                                    distance(last, next) -
+                                    distance(previous, next);
+        if (removal_gain <= kMinImprovement) {
+          continue;
+        }
+        // best insertion edge (path[k], path[k + 1]) next to a neighbor
+        double best_delta = -kMinImprovement;
+        size_t best_edge = 0;
+        bool best_reversed = false;
+        for (const size_t end_node : {first, last}) {
+          for (size_t neighbor = 0; neighbor < _n_neighbors; ++neighbor) {
+            const size_t c = _neighbors[end_node * _n_neighbors + neighbor];
+            if (c == 0) {
+              break;
+            }
+            const size_t j = _position[c];
+            for (const size_t k : {j - 1, j}) {
+              // the edge must exist and must not touch the segment
+              if (j == 0 || k + 1 >= _m || (k + 1 >= i && k < i + length)) {
+                continue;
+              }
+              const size_t u = _path[k];
+              const size_t v = _path[k + 1];
+              const double forward =
+                  distance(u, first) + distance(last, v) - distance(u, v);
+              const double backward =
+                  distance(u, last) + distance(first, v) - distance(u, v);
+              const double delta = std::min(forward, backward) - removal_gain;
+              if (delta < best_delta) {
+                best_delta = delta;
+                best_edge = k;
+                best_reversed = backward < forward;
+              }
+            }
+          }
+        }
+        if (best_delta < -kMinImprovement) {
+          moveSegment(i, length, best_edge, best_reversed);
+          improved = true;
+        }
+      }
+    }
+    return improved;
+  }
+
+  /**
+   * @brief Moves the segment at [begin, begin + length) between the nodes at
+   * the positions edge and edge + 1.
+   */
+  void moveSegment(const size_t begin, const size_t length, const size_t edge,
+                   const bool reversed) {
+    if (edge < begin) {
+      // rotate the segment to the front of path[edge + 1, begin + length)
+      std::rotate(_path.begin() + edge + 1, _path.begin() + begin,
+                  _path.begin() + begin + length);
+      if (reversed) {
+        std::reverse(_path.begin() + edge + 1,
+                     _path.begin() + edge + 1 + length);
+      }
+      updatePositions(edge + 1, begin + length);
+    } else {
+      // rotate the segment to the back of path[begin, edge + 1)
+      std::rotate(_path.begin() + begin, _path.begin() + begin + length,
+                  _path.begin() + edge + 1);
+      if (reversed) {
+        std::reverse(_path.begin() + edge + 1 - length,
+                     _path.begin() + edge + 1);
+      }
+      updatePositions(begin, edge + 1);
+    }
+  }
+
+  static constexpr double kMinImprovement =
+      1e-10;  //!< Smaller improvements are ignored to avoid cycling.
+
+  const AMR::DistanceMatrix &_distances;  //!< Distances between the nodes.
+  const size_t _n;                        //!< Number of part locations.
+  const size_t _m;                        //!< Number of nodes.
+  const size_t _n_neighbors;  //!< Length of each neighbor list.
+  std::vector<size_t>
+      _neighbors;  //!< Closest part locations of every node, sorted by
+                   //!< distance.
+  std::vector<size_t> _path;      //!< Nodes of the current path.
+  std::vector<size_t> _position;  //!< Position of each node in @ref _path.
+};
+/**
+ * @brief Result of a task of the exhaustive search.
+ */
+struct ExhaustiveTaskResult {
+  ExhaustiveTaskResult() : _length(std::numeric_limits<double>::max()){};
+  double _length;  //!< Length of the shortest path found by the task.
+  std::vector<int> _pickup_order;  //!< Pickup order of this path.
+};
+
+/**
+ * @brief Lowers @p bound to @p length if it is smaller.
+ */
+void updateBound(std::atomic<double> &bound, const double length) {
+  double current = bound.load();
+  while (length < current && !bound.compare_exchange_weak(current, length)) {
+  }
+}
+
+/**
+ * @brief Visits all permutations with a given prefix in lexicographic order
+ * and keeps the first shortest one.
+ *
+ * The path length of each prefix of the current permutation is cached, so
+ * only the legs of the changed suffix are added after each step. As soon as
+ * a prefix is longer than @p bound, all permutations starting with it are
+ * skipped.
+ *
+ * @param[in] distances Distance matrix of the order.
+ * @param[in] prefix Parts at the first positions of all permutations.
+ * @param[in,out] bound Length of the shortest path found by any task.
+ * @param[out] result Shortest path found among the permutations that were
+ * not skipped.
+ * @param[in] deadline If not null, the search stops when it expires.
+ */
+void searchPermutations(const AMR::DistanceMatrix &distances,
+                        const std::vector<int> &prefix,
+                        std::atomic<double> &bound,
+                        ExhaustiveTaskResult &result,
+                        const AMR::Deadline *deadline) {
+  const size_t n = distances.getNumberOfParts();
+  const size_t delivery = distances.getDeliveryNode();
+  const size_t fixed = prefix.size();
+  // the permutation starts with the prefix followed by the remaining parts
+  // in ascending order
+  std::vector<int> permutation(prefix);
+  std::vector<char> used(n, 0);
+  for (int part : prefix) {
+    used[part] = 1;
+  }
+  for (size_t part = 0; part < n; ++part) {
+    if (!used[part]) {
+      permutation.push_back(static_cast<int>(part));
+    }
+  }
+
+  // prefix_lengths[i] is the length of the path from the starting point to
+  // the part at position i
+  std::vector<double> prefix_lengths(n);
+  size_t begin = 0;
+  for (uint64_t step = 1;; ++step) {
+    if (deadline && (step & 4095) == 0 && deadline->expired()) {
+      return;
+    }
+    // update the changed suffix, stop at the first prefix exceeding the bound
+    const double current_bound = bound.load(std::memory_order_relaxed);
+    double length = begin > 0 ? prefix_lengths[begin - 1] : 0.0;
+    size_t previous = begin > 0 ? permutation[begin - 1] + 1 : 0;
+    size_t pruned = n;
+    for (size_t i = begin; i < n; ++i) {
+      const size_t node = static_cast<size_t>(permutation[i]) + 1;
+      length += distances(previous, node);
+      prefix_lengths[i] = length;
+      previous = node;
+      if (length > current_bound) {
+        pruned = i;
+        break;
+      }
+    }
+    if (pruned == n) {
+      length += distances(previous, delivery);
+      if (length < result._length) {
+        result._length = length;
+        result._pickup_order = permutation;
+        updateBound(bound, length);
+      }
+    } else if (pruned < fixed) {
+      // the prefix of the task is already too long
+      return;
+    } else {
+      // skip the remaining permutations that share the first pruned + 1
+      // positions by arranging the rest in descending order
+      std::sort(permutation.begin() + pruned + 1, permutation.end(),
+                std::greater<int>());
+    }
+    // advance to the next permutation in lexicographic order; only the
+    // positions from the pivot on change
+    size_t pivot = n - 1;
+    while (pivot > fixed && permutation[pivot - 1] >= permutation[pivot]) {
+      --pivot;
+    }
+    if (pivot <= fixed) {
+      return;
+    }
+    --pivot;
+    size_t successor = n - 1;
+    while (permutation[successor] <= permutation[pivot]) {
+      --successor;
+    }
+    std::swap(permutation[pivot], permutation[successor]);
+    std::reverse(permutation.begin() + pivot + 1, permutation.end());
+    begin = pivot;
+  }
+}
+}  // namespace
+
+double AMR::solveBruteForce(const AMR::Coordinates2D &starting_point,
+                            const std::vector<Coordinates2D> &part_locations,
+                            const AMR::Coordinates2D &delivery_point,
+                            std::vector<int> &pickup_order) {
+  return solveBruteForce(
+      DistanceMatrix(starting_point, part_locations, delivery_point),
+      pickup_order);
+}
+
+double AMR::solveBruteForce(const DistanceMatrix &distances,
+                            std::vector<int> &pickup_order) {
+  const size_t n = distances.getNumberOfParts();
+  pickup_order.resize(n);
+  std::iota(pickup_order.begin(), pickup_order.end(), 0);
+
+  // the permutations are generated in batches whose path lengths are
+  // evaluated at once by the vectorized kernel
+  constexpr size_t batch_size = 256;
+  std::vector<int32_t> batch(batch_size * n);
+  std::vector<double> path_lengths(batch_size);
+  double shortest_path_length = std::numeric_limits<double>::max();
+  std::vector<int> best_order = pickup_order;
+  bool permutations_left = true;
+  while (permutations_left) {
+    size_t batch_count = 0;
+    while (permutations_left && batch_count < batch_size) {
+      std::copy(pickup_order.begin(), pickup_order.end(),
+                batch.begin() + batch_count * n);
+      ++batch_count;
+      permutations_left =
+          std::next_permutation(pickup_order.begin(), pickup_order.end());
+    }
+    distances.evaluatePathLengths(batch.data(), batch_count,
+                                  path_lengths.data());
+    // the first of several shortest paths in lexicographic order is kept
+    for (size_t i = 0; i < batch_count; ++i) {
+      if (path_lengths[i] < shortest_path_length) {
+        shortest_path_length = path_lengths[i];
+        std::copy(batch.begin() + i * n, batch.begin() + (i + 1) * n,
+                  best_order.begin());
+      }
+    }
+  }
+
+  pickup_order = best_order;
+  return shortest_path_length;
+}
+
+double AMR::solveExhaustive(const DistanceMatrix &distances,
+                            std::vector<int> &pickup_order,
+                            unsigned int n_threads, const Deadline *deadline,
+                            ThreadPool *thread_pool) {
+  const size_t n = distances.getNumberOfParts();
+  pickup_order.resize(n);
+  std::iota(pickup_order.begin(), pickup_order.end(), 0);
+  if (n == 0) {
+    return distances(0, distances.getDeliveryNode());
+  }
+  n_threads = resolveThreadCount(n_threads, thread_pool);
+
+  // every task fixes the first prefix_length parts; there should be several
+  // tasks per thread to balance the load
+  const size_t min_tasks = n_threads == 1 ? 1 : 8 * size_t{n_threads};
+  size_t prefix_length = 0;
+  size_t n_tasks = 1;
+  while (n_tasks < min_tasks && prefix_length + 1 < n) {
+    n_tasks *= n - prefix_length;
+    ++prefix_length;
+  }
+  std::vector<std::vector<int>> tasks;
+  std::vector<int> prefix;
+  std::vector<char> used(n, 0);
+  std::function<void()> collect_prefixes = [&]() {
+    if (prefix.size() == prefix_length) {
+      tasks.push_back(prefix);
+      return;
+    }
+    for (size_t part = 0; part < n; ++part) {
+      if (!used[part]) {
+        used[part] = 1;
+        prefix.push_back(static_cast<int>(part));
+        collect_prefixes();
+        prefix.pop_back();
+        used[part] = 0;
+      }
+    }
+  };
+  collect_prefixes();
+
+  // The nearest neighbor path provides the initial bound. Only prefixes that
+  // are strictly longer than the bound are skipped, so every shortest path is
+  // still found by its task.
+  const double greedy_length = nearestNeighborPath(distances, pickup_order);
+  std::atomic<double> bound(greedy_length);
+  std::vector<ExhaustiveTaskResult> results(tasks.size());
+  std::atomic<size_t> next_task(0);
+  auto work = [&](size_t) {
+    for (size_t task = next_task++; task < tasks.size(); task = next_task++) {
+      if (deadline && deadline->expired()) {
+        break;
+      }
+      searchPermutations(distances, tasks[task], bound, results[task],
+                         deadline);
+    }
+  };
+  runInParallel(thread_pool, ThreadPoolSubsystem::kSolver,
+                std::min<size_t>(n_threads, tasks.size()), work);
+
+  // the tasks are in lexicographic order, so keeping the first of several
+  // shortest results gives the same pickup order as a sequential search
+  double shortest_path_length = std::numeric_limits<double>::max();
+  const std::vector<int> greedy_order = pickup_order;
+  for (const ExhaustiveTaskResult &result : results) {
+    if (result._length < shortest_path_length) {
+      shortest_path_length = result._length;
+      pickup_order = result._pickup_order;
+    }
+  }
+  // a search stopped by the deadline may only have found paths longer than
+  // the nearest neighbor path, which is kept in that case
+  if (shortest_path_length > greedy_length) {
+    pickup_order = greedy_order;
+    shortest_path_length = greedy_length;
+  }
+  return shortest_path_length;
+}
+
+double AMR::solveHeldKarp(const AMR::Coordinates2D &starting_point,
+                          const std::vector<Coordinates2D> &part_locations,
+                          const AMR::Coordinates2D &delivery_point,
+                          std::vector<int> &pickup_order,
+                          unsigned int n_threads) {
+  return solveHeldKarp(
+      DistanceMatrix(starting_point, part_locations, delivery_point),
+      pickup_order, n_threads);
+}
+
+double AMR::solveHeldKarp(const DistanceMatrix &distances,
+                          std::vector<int> &pickup_order,
+                          unsigned int n_threads, const Deadline *deadline,
+                          ThreadPool *thread_pool) {
+  const size_t n = distances.getNumberOfParts();
+  pickup_order.resize(n);
+  std::iota(pickup_order.begin(), pickup_order.end(), 0);
+  if (n == 0) {
+    return distances(0, 1);
+  }
+  if (n > kHeldKarpMaxLocations) {
+    std::cerr << "Error in solveHeldKarp: " << n
+              << " part locations exceed the supported maximum of "
+              << kHeldKarpMaxLocations << std::endl;
+    return distances.determinePathLength(pickup_order.data());
+  }
+
+  // table[j * half + compressSubset(S, j)] is the length of the shortest path
+  // from the starting point through all parts in S ending at part j.
+  const size_t half = size_t{1} << (n - 1);
+  const size_t n_subsets = size_t{1} << n;
+  std::vector<double> table(n * half);
+  for (size_t j = 0; j < n; ++j) {
+    table[j * half] = distances(0, j + 1);
+  }
+
+  // all subsets sorted by their size, layer_begin[s] is the position of the
+  // first subset of size s
+  std::vector<uint32_t> subsets(n_subsets);
+  std::vector<size_t> layer_begin(n + 2, 0);
+  for (size_t subset = 0; subset < n_subsets; ++subset) {
+    ++layer_begin[__builtin_popcountll(subset) + 1];
+  }
+  std::partial_sum(layer_begin.begin(), layer_begin.end(),
+                   layer_begin.begin());
+  {
+    std::vector<size_t> position(layer_begin.begin(), layer_begin.end() - 1);
+    for (size_t subset = 0; subset < n_subsets; ++subset) {
+      subsets[position[__builtin_popcountll(subset)]++] =
+          static_cast<uint32_t>(subset);
+    }
+  }
+
+  // fills the entries of the subsets at the positions [begin, end)
+  auto fill_range = [&](const size_t begin, const size_t end) {
+    std::vector<double> best(n);
+    for (size_t i = begin; i < end; ++i) {
+      if (deadline && ((i - begin) & 1023) == 0 && deadline->expired()) {
+        return;
+      }
+      const size_t subset = subsets[i];
+      // relax the paths ending at all parts j by a path through subset ending
+      // at member k. The loop over j is contiguous and is also executed for
+      // j in subset (whose results are discarded), so it vectorizes.
+      std::fill(best.begin(), best.end(), std::numeric_limits<double>::max());
+      for (size_t k = 0; k < n; ++k) {
+        if (!(subset & (size_t{1} << k))) {
+          continue;
+        }
+        const double length_to_k =
+            table[k * half + compressSubset(subset ^ (size_t{1} << k), k)];
+        const double *distances_from_k = distances.getRow(k + 1) + 1;
+        for (size_t j = 0; j < n; ++j) {
+          double length = length_to_k + distances_from_k[j];
+          best[j] = length < best[j] ? length : best[j];
+        }
+      }
+      for (size_t j = 0; j < n; ++j) {
+        if (!(subset & (size_t{1} << j))) {
+          table[j * half + compressSubset(subset, j)] = best[j];
+        }
+      }
+    }
+  };
+
+  n_threads = resolveThreadCount(n_threads, thread_pool);
+  // each layer only depends on the previous one, so the subsets of a layer
+  // can be processed in parallel. Small layers are filled by a single thread
+  // since handing them to other threads would take longer than the work
+  // itself.
+  constexpr size_t min_subsets_per_thread = 2048;
+  for (size_t layer = 1; layer < n; ++layer) {
+    if (deadline && deadline->isReached()) {
+      break;
+    }
+    const size_t begin = layer_begin[layer];
+    const size_t end = layer_begin[layer + 1];
+    const size_t n_used_threads = std::max<size_t>(
+        1, std::min<size_t>(n_threads, (end - begin) / min_subsets_per_thread));
+    if (n_used_threads == 1) {
+      fill_range(begin, end);
+      continue;
+    }
+    const size_t chunk = (end - begin + n_used_threads - 1) / n_used_threads;
+    runInParallel(thread_pool, ThreadPoolSubsystem::kSolver, n_used_threads,
+                  [&](size_t t) {
+                    const size_t chunk_begin = std::min(end, begin + t * chunk);
+                    const size_t chunk_end = std::min(end, chunk_begin + chunk);
+                    fill_range(chunk_begin, chunk_end);
+                  });
+  }
+  if (deadline && deadline->isReached()) {
+    return nearestNeighborPath(distances, pickup_order);
+  }
+
+  // close the path at the delivery point
+  const size_t all_parts = n_subsets - 1;
+  double shortest_path_length = std::numeric_limits<double>::max();
+  size_t last = 0;
+  for (size_t j = 0; j < n; ++j) {
+    double length =
+        table[j * half + compressSubset(all_parts ^ (size_t{1} << j), j)] +
+        distances(j + 1, n + 1);
+    if (length < shortest_path_length) {
+      shortest_path_length = length;
+      last = j;
+    }
+  }
+
+  // reconstruct the pickup order backwards by repeating the minimization of
+  // the table fill (this is cheaper than storing the predecessors)
+  size_t subset = all_parts ^ (size_t{1} << last);
+  size_t current = last;
+  pickup_order[n - 1] = static_cast<int>(last);
+  for (size_t position = n - 1; position-- > 0;) {
+    double best = std::numeric_limits<double>::max();
+    size_t predecessor = 0;
+    for (size_t k = 0; k < n; ++k) {
+      if (!(subset & (size_t{1} << k))) {
+        continue;
+      }
+      double length =
+          table[k * half + compressSubset(subset ^ (size_t{1} << k), k)] +
+          distances(k + 1, current + 1);
+      if (length < best) {
+        best = length;
+        predecessor = k;
+      }
+    }
+    pickup_order[position] = static_cast<int>(predecessor);
+    subset ^= size_t{1} << predecessor;
+    current = predecessor;
+  }
+  return shortest_path_length;
+}
+
+double AMR::solveNearestNeighbor(
+    const AMR::Coordinates2D &starting_point,
+    const std::vector<Coordinates2D> &part_locations,
+    const AMR::Coordinates2D &delivery_point, std::vector<int> &pickup_order) {
+  return nearestNeighborPath(
+      DistanceMatrix(starting_point, part_locations, delivery_point),
+      pickup_order);
+}
+
+double AMR::solveNearestNeighbor(const DistanceMatrix &distances,
+                                 std::vector<int> &pickup_order) {
+  return nearestNeighborPath(distances, pickup_order);
+}
+
+double AMR::solveBranchAndBound(
+    const AMR::Coordinates2D &starting_point,
+    const std::vector<Coordinates2D> &part_locations,
+    const AMR::Coordinates2D &delivery_point, std::vector<int> &pickup_order,
+    const LowerBound lower_bound, PathSolverStatistics *statistics) {
+  return solveBranchAndBound(
+      DistanceMatrix(starting_point, part_locations, delivery_point),
+      pickup_order, lower_bound, statistics);
+}
+
+double AMR::solveBranchAndBound(const DistanceMatrix &distances,
+                                std::vector<int> &pickup_order,
+                                const LowerBound lower_bound,
+                                PathSolverStatistics *statistics,
+                                const Deadline *deadline) {
+  const double greedy_length = nearestNeighborPath(distances, pickup_order);
+  PathSolverStatistics search_statistics;
+  BranchAndBoundSearch search(distances, lower_bound, search_statistics,
+                              deadline);
+  const double shortest_path_length = search.run(pickup_order, greedy_length);
+  if (statistics) {
+    *statistics = search_statistics;
+  }
+  return shortest_path_length;
+}
+
+double AMR::solveHeuristic(const AMR::Coordinates2D &starting_point,
+                           const std::vector<Coordinates2D> &part_locations,
+                           const AMR::Coordinates2D &delivery_point,
+                           std::vector<int> &pickup_order,
+                           const size_t neighbor_list_size) {
+  return solveHeuristic(
+      DistanceMatrix(starting_point, part_locations, delivery_point),
+      pickup_order, neighbor_list_size);
+}
+
+double AMR::solveHeuristic(const DistanceMatrix &distances,
+                           std::vector<int> &pickup_order,
+                           const size_t neighbor_list_size) {
+  const double greedy_length = nearestNeighborPath(distances, pickup_order);
+  if (distances.getNumberOfParts() < 3 || neighbor_list_size == 0) {
+    return greedy_length;
+  }
+  LocalSearch local_search(distances, neighbor_list_size);
+  return local_search.run(pickup_order);
+}
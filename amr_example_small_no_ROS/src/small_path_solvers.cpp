@@ -0,0 +1,85 @@
+#include "small_path_solvers.hpp"
+
+#include <iostream>
+#include <numeric>
+
+#include "distance_matrix.hpp"
+
+namespace {
+/**
+ * @brief Calls the specialization of @ref AMR::solveSmall for N part
+ * locations and copies its pickup order.
+ */
+template <size_t N, typename Metric>
+double solveSmallInto(const AMR::Coordinates2D &starting_point,
+                      const std::vector<AMR::Coordinates2D> &part_locations,
+                      const AMR::Coordinates2D &delivery_point,
+                      std::vector<int> &pickup_order) {
+  std::array<int, N> order;
+  const double path_length = AMR::solveSmall<N, Metric>(
+      starting_point, part_locations.data(), delivery_point, order);
+  pickup_order.assign(order.begin(), order.end());
+  return path_length;
+}
+
+/**
+ * @brief Dispatches to the specialization of @ref AMR::solveSmall for the
+ * number of part locations.
+ */
+template <typename Metric>
+double solveSmallWithMetric(
+    const AMR::Coordinates2D &starting_point,
+    const std::vector<AMR::Coordinates2D> &part_locations,
+    const AMR::Coordinates2D &delivery_point, std::vector<int> &pickup_order) {
+  switch (part_locations.size()) {
+    case 0:
+      pickup_order.clear();
+      return AMR::computeDistance<Metric>(starting_point, delivery_point);
+    case 1:
+      return solveSmallInto<1, Metric>(starting_point, part_locations,
+                                       delivery_point, pickup_order);
+    case 2:
+      return solveSmallInto<2, Metric>(starting_point, part_locations,
+                                       delivery_point, pickup_order);
+    case 3:
+      return solveSmallInto<3, Metric>(starting_point, part_locations,
+                                       delivery_point, pickup_order);
+    case 4:
+      return solveSmallInto<4, Metric>(starting_point, part_locations,
+                                       delivery_point, pickup_order);
+    case 5:
+      return solveSmallInto<5, Metric>(starting_point, part_locations,
+                                       delivery_point, pickup_order);
+    case 6:
+      return solveSmallInto<6, Metric>(starting_point, part_locations,
+                                       delivery_point, pickup_order);
+    case 7:
+      return solveSmallInto<7, Metric>(starting_point, part_locations,
+                                       delivery_point, pickup_order);
+    case 8:
+      return solveSmallInto<8, Metric>(starting_point, part_locations,
+                                       delivery_point, pickup_order);
+    default: {
+      std::cerr << "Error in solveSmall: " << part_locations.size()
+                << " part locations exceed the supported maximum of "
+                << AMR::kSmallSolverMaxLocations << std::endl;
+      pickup_order.resize(part_locations.size());
+      std::iota(pickup_order.begin(), pickup_order.end(), 0);
+      return AMR::DistanceMatrix(starting_point, part_locations,
+                                 delivery_point, Metric::kMetric)
+          .determinePathLength(pickup_order.data());
+    }
+  }
+}
+}  // namespace
+
+double AMR::solveSmall(const AMR::Coordinates2D &starting_point,
+                       const std::vector<Coordinates2D> &part_locations,
+                       const AMR::Coordinates2D &delivery_point,
+                       std::vector<int> &pickup_order,
+                       const AMR::DistanceMetric metric) {
+  return dispatchMetric(metric, [&](auto policy) {
+    return solveSmallWithMetric<decltype(policy)>(
+        starting_point, part_locations, delivery_point, pickup_order);
+  });
+}
@@ -0,0 +1,281 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace {
+//! Pool of which the current thread is a worker, or nullptr.
+thread_local const AMR::ThreadPool *t_thread_pool = nullptr;
+//! Index of the current thread among the workers of @ref t_thread_pool.
+thread_local size_t t_worker = 0;
+//! Run-time of the tasks executed by the current task of the thread.
+thread_local uint64_t t_nested_nanoseconds = 0;
+}  // namespace
+
+const char *AMR::getSubsystemName(const AMR::ThreadPoolSubsystem subsystem) {
+  switch (subsystem) {
+    case ThreadPoolSubsystem::kOrderLookup:
+      return "order lookup";
+    case ThreadPoolSubsystem::kCatalog:
+      return "catalog";
+    case ThreadPoolSubsystem::kSolver:
+      return "solver";
+  }
+  return "unknown";
+}
+
+AMR::ThreadPool::ThreadPool()
+    : _n_pending(0),
+      _next_queue(0),
+      _stop(false),
+      _start_time(std::chrono::steady_clock::now()) {
+  for (size_t i = 0; i < kNumberOfThreadPoolSubsystems; ++i) {
+    _n_tasks[i] = 0;
+    _busy_nanoseconds[i] = 0;
+  }
+}
+
+void AMR::ThreadPool::start(size_t n_threads) {
+  stop();
+  if (n_threads == 0) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  _stop = false;
+  _start_time = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kNumberOfThreadPoolSubsystems; ++i) {
+    _n_tasks[i] = 0;
+    _busy_nanoseconds[i] = 0;
+  }
+  for (size_t worker = 0; worker < n_threads; ++worker) {
+    _queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+  }
+  for (size_t worker = 0; worker < n_threads; ++worker) {
+    _threads.emplace_back(&ThreadPool::workerLoop, this, worker);
+  }
+}
+
+void AMR::ThreadPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_wake_mutex);
+    _stop = true;
+  }
+  _wake.notify_all();
+  for (std::thread &thread : _threads) {
+    thread.join();
+  }
+  // the queues are removed while holding the mutex, so a concurrent push
+  // either finished before or sees the stopped pool
+  std::lock_guard<std::mutex> lock(_wake_mutex);
+  _threads.clear();
+  _queues.clear();
+}
+
+void AMR::ThreadPool::submit(const AMR::ThreadPoolSubsystem subsystem,
+                             std::function<void()> task) {
+  Task pending{std::move(task), subsystem, nullptr};
+  if (!push(pending)) {
+    // without workers, e.g. while the pool is stopped, the task is executed
+    // right away
+    execute(subsystem, pending._function);
+  }
+}
+
+bool AMR::ThreadPool::push(Task &task) {
+  // the mutex is held until the task is queued, so stop() cannot remove the
+  // queues in between
+  {
+    std::lock_guard<std::mutex> lock(_wake_mutex);
+    if (_stop || _queues.empty()) {
+      return false;
+    }
+    const size_t queue = t_thread_pool == this
+                             ? t_worker
+                             : _next_queue++ % _queues.size();
+    // the counter is incremented first, so it never drops below 0 when the
+    // task is taken right away
+    ++_n_pending;
+    std::lock_guard<std::mutex> queue_lock(_queues[queue]->_mutex);
+    _queues[queue]->_tasks.push_back(std::move(task));
+  }
+  _wake.notify_one();
+  return true;
+}
+
+void AMR::ThreadPool::run(const AMR::ThreadPoolSubsystem subsystem,
+                          const size_t n_workers,
+                          const std::function<void(size_t)> &work) {
+  if (n_workers == 0) {
+    return;
+  }
+  // the counter is decremented while holding the mutex, so the group is not
+  // destroyed before the last worker released it
+  struct Group {
+    std::mutex _mutex;
+    std::condition_variable _done;
+    size_t _remaining;
+  } group;
+  group._remaining = n_workers - 1;
+  for (size_t worker = 1; worker < n_workers; ++worker) {
+    std::function<void()> function = [&group, &work, worker]() {
+      work(worker);
+      std::lock_guard<std::mutex> lock(group._mutex);
+      if (--group._remaining == 0) {
+        group._done.notify_all();
+      }
+    };
+    Task task{std::move(function), subsystem, &group};
+    if (!push(task)) {
+      execute(subsystem, task._function);
+    }
+  }
+  execute(subsystem, [&work]() { work(0); });
+
+  // pending tasks of this group are executed while waiting. Other tasks,
+  // e.g. file lookups submitted in the background, are left to the workers
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(group._mutex);
+      if (group._remaining == 0) {
+        break;
+      }
+    }
+    Task task;
+    if (takeGroupTask(&group, task)) {
+      execute(task._subsystem, task._function);
+    } else {
+      std::unique_lock<std::mutex> lock(group._mutex);
+      group._done.wait_for(lock, std::chrono::milliseconds(1),
+                           [&group]() { return group._remaining == 0; });
+    }
+  }
+}
+
+AMR::ThreadPoolStatistics AMR::ThreadPool::getStatistics(
+    const AMR::ThreadPoolSubsystem subsystem) const {
+  const size_t index = static_cast<size_t>(subsystem);
+  ThreadPoolStatistics statistics;
+  statistics._n_tasks = _n_tasks[index];
+  statistics._busy_seconds = _busy_nanoseconds[index] * 1e-9;
+  const double elapsed_seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                    _start_time)
+          .count();
+  if (!_threads.empty() && elapsed_seconds > 0.0) {
+    statistics._utilization =
+        statistics._busy_seconds / (elapsed_seconds * _threads.size());
+  }
+  return statistics;
+}
+
+bool AMR::ThreadPool::takeTask(const size_t worker, Task &task) {
+  // the most recent task of the own queue is still in the cache
+  if (worker < _queues.size()) {
+    WorkerQueue &queue = *_queues[worker];
+    std::lock_guard<std::mutex> lock(queue._mutex);
+    if (!queue._tasks.empty()) {
+      task = std::move(queue._tasks.back());
+      queue._tasks.pop_back();
+      --_n_pending;
+      return true;
+    }
+  }
+  for (size_t offset = 1; offset <= _queues.size(); ++offset) {
+    WorkerQueue &queue = *_queues[(worker + offset) % _queues.size()];
+    std::lock_guard<std::mutex> lock(queue._mutex);
+    if (!queue._tasks.empty()) {
+      task = std::move(queue._tasks.front());
+      queue._tasks.pop_front();
+      --_n_pending;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool AMR::ThreadPool::takeGroupTask(const void *group, Task &task) {
+  for (const std::unique_ptr<WorkerQueue> &queue : _queues) {
+    std::lock_guard<std::mutex> lock(queue->_mutex);
+    auto task_iter = std::find_if(
+        queue->_tasks.begin(), queue->_tasks.end(),
+        [group](const Task &pending) { return pending._group == group; });
+    if (task_iter != queue->_tasks.end()) {
+      task = std::move(*task_iter);
+      queue->_tasks.erase(task_iter);
+      --_n_pending;
+      return true;
+    }
+  }
+  return false;
+}
+
+void AMR::ThreadPool::execute(const AMR::ThreadPoolSubsystem subsystem,
+                              const std::function<void()> &function) {
+  // the task is counted first, so it is counted when its group is finished
+  const size_t index = static_cast<size_t>(subsystem);
+  ++_n_tasks[index];
+  if (t_thread_pool != this) {
+    // only the workers are busy, e.g. the caller of run() is not
+    function();
+    return;
+  }
+  // the time of nested tasks is only counted for their own subsystem, so
+  // the busy time of a worker never exceeds its elapsed time
+  const uint64_t outer_nested_nanoseconds = t_nested_nanoseconds;
+  t_nested_nanoseconds = 0;
+  const auto start = std::chrono::steady_clock::now();
+  function();
+  const uint64_t nanoseconds =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count();
+  _busy_nanoseconds[index] += nanoseconds - t_nested_nanoseconds;
+  t_nested_nanoseconds = outer_nested_nanoseconds + nanoseconds;
+}
+
+void AMR::ThreadPool::workerLoop(const size_t worker) {
+  t_thread_pool = this;
+  t_worker = worker;
+  while (true) {
+    Task task;
+    if (takeTask(worker, task)) {
+      execute(task._subsystem, task._function);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(_wake_mutex);
+    if (_stop && _n_pending == 0) {
+      break;
+    }
+    _wake.wait(lock, [this]() { return _stop || _n_pending > 0; });
+  }
+  t_thread_pool = nullptr;
+}
+
+void AMR::runInParallel(AMR::ThreadPool *thread_pool,
+                        const AMR::ThreadPoolSubsystem subsystem,
+                        const size_t n_workers,
+                        const std::function<void(size_t)> &work) {
+  if (thread_pool != nullptr && thread_pool->getSize() > 0) {
+    thread_pool->run(subsystem, n_workers, work);
+    return;
+  }
+  std::vector<std::thread> threads;
+  for (size_t worker = 1; worker < n_workers; ++worker) {
+    threads.emplace_back(work, worker);
+  }
+  if (n_workers > 0) {
+    work(0);
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+unsigned int AMR::resolveThreadCount(const unsigned int n_threads,
+                                     const AMR::ThreadPool *thread_pool) {
+  if (n_threads > 0) {
+    return n_threads;
+  }
+  if (thread_pool != nullptr && thread_pool->getSize() > 0) {
+    return static_cast<unsigned int>(thread_pool->getSize());
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
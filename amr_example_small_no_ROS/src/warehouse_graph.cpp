@@ -0,0 +1,229 @@
+#include "warehouse_graph.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <queue>
+
+#include "basic_routines.hpp"
+#include "yaml-cpp/yaml.h"
+
+namespace {
+/**
+ * @brief Euclidean distance between two points.
+ */
+double euclideanDistance(const AMR::Coordinates2D &a,
+                         const AMR::Coordinates2D &b) {
+  double x_diff = b._x - a._x;
+  double y_diff = b._y - a._y;
+  return sqrt(x_diff * x_diff + y_diff * y_diff);
+}
+}  // namespace
+
+bool AMR::WarehouseGraph::load(const std::string &file_path) {
+  _nodes.clear();
+  _adjacency_begin.clear();
+  _adjacency.clear();
+  _location_index.clear();
+  std::ifstream fin(file_path);
+  if (!fin.is_open()) {
+    return false;
+  }
+  try {
+    YAML::Node graph_doc = YAML::Load(fin);
+    // node ids in the file are arbitrary, internally the nodes are numbered
+    // in the order in which they appear
+    std::map<long long int, int> node_index;
+    for (const auto &node : graph_doc["nodes"]) {
+      long long int id = node["id"].as<long long int>();
+      if (!node_index.emplace(id, static_cast<int>(_nodes.size())).second) {
+        std::cout << "Error: Node " << id << " defined twice in " << file_path
+                  << std::endl;
+        _nodes.clear();
+        return false;
+      }
+      _nodes.emplace_back(node["cx"].as<double>(), node["cy"].as<double>());
+    }
+    // every undirected edge is stored in both directions
+    std::vector<std::vector<std::pair<int, double>>> neighbors(_nodes.size());
+    for (const auto &edge : graph_doc["edges"]) {
+      auto from_iter = node_index.find(edge["from"].as<long long int>());
+      auto to_iter = node_index.find(edge["to"].as<long long int>());
+      if (from_iter == node_index.end() || to_iter == node_index.end()) {
+        std::cout << "Error: Edge with unknown node in " << file_path
+                  << std::endl;
+        _nodes.clear();
+        return false;
+      }
+      const int from = from_iter->second;
+      const int to = to_iter->second;
+      double length = edge["length"]
+                          ? edge["length"].as<double>()
+                          : euclideanDistance(_nodes[from], _nodes[to]);
+      neighbors[from].emplace_back(to, length);
+      neighbors[to].emplace_back(from, length);
+    }
+    _adjacency_begin.push_back(0);
+    for (const auto &node_neighbors : neighbors) {
+      _adjacency.insert(_adjacency.end(), node_neighbors.begin(),
+                        node_neighbors.end());
+      _adjacency_begin.push_back(_adjacency.size());
+    }
+  } catch (const YAML::Exception &e) {
+    std::cout << "Error: Could not read warehouse graph " << file_path << ": "
+              << e.what() << std::endl;
+    _nodes.clear();
+    _adjacency_begin.clear();
+    _adjacency.clear();
+    return false;
+  }
+  return !_nodes.empty();
+}
+
+void AMR::WarehouseGraph::precompute(
+    const std::vector<AMR::ProductPart> &all_product_parts,
+    unsigned int n_threads, AMR::ThreadPool *thread_pool) {
+  std::vector<Coordinates2D> part_locations, locations;
+  for (const AMR::ProductPart &part : all_product_parts) {
+    part_locations.push_back(part._coords);
+  }
+  std::vector<int> node_of_location;
+  collapseColocatedLocations(part_locations, 0.0, locations, node_of_location);
+  _location_index.clear();
+  _location_nodes.resize(locations.size());
+  _location_offsets.resize(locations.size());
+  for (size_t i = 0; i < locations.size(); ++i) {
+    _location_index.emplace(std::make_pair(locations[i]._x, locations[i]._y),
+                            static_cast<int>(i));
+    _location_nodes[i] = closestNode(locations[i]);
+    _location_offsets[i] =
+        euclideanDistance(locations[i], _nodes[_location_nodes[i]]);
+  }
+  const size_t n_nodes = _nodes.size();
+  _distances.resize(locations.size() * n_nodes);
+  _next_hops.resize(locations.size() * n_nodes);
+
+  // the searches of different locations are independent
+  n_threads = resolveThreadCount(n_threads, thread_pool);
+  std::atomic<size_t> next_location(0);
+  auto work = [&](size_t) {
+    for (size_t location = next_location++; location < locations.size();
+         location = next_location++) {
+      // the graph is undirected, so the predecessor of a node on the path
+      // from the location is the next node on the way to the location
+      shortestPaths(_location_nodes[location], &_distances[location * n_nodes],
+                    &_next_hops[location * n_nodes]);
+    }
+  };
+  runInParallel(thread_pool, ThreadPoolSubsystem::kCatalog,
+                std::min<size_t>(n_threads, locations.size()), work);
+}
+
+size_t AMR::WarehouseGraph::closestNode(
+    const AMR::Coordinates2D &point) const {
+  size_t closest = 0;
+  double closest_distance = std::numeric_limits<double>::max();
+  for (size_t node = 0; node < _nodes.size(); ++node) {
+    double node_distance = euclideanDistance(point, _nodes[node]);
+    if (node_distance < closest_distance) {
+      closest_distance = node_distance;
+      closest = node;
+    }
+  }
+  return closest;
+}
+
+void AMR::WarehouseGraph::shortestPaths(const size_t source, double *distances,
+                                        int *predecessors) const {
+  std::fill(distances, distances + _nodes.size(),
+            std::numeric_limits<double>::infinity());
+  std::fill(predecessors, predecessors + _nodes.size(), -1);
+  typedef std::pair<double, size_t> QueueEntry;
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+                      std::greater<QueueEntry>>
+      queue;
+  distances[source] = 0.0;
+  queue.emplace(0.0, source);
+  while (!queue.empty()) {
+    const QueueEntry entry = queue.top();
+    queue.pop();
+    const size_t node = entry.second;
+    if (entry.first > distances[node]) {
+      // outdated entry
+      continue;
+    }
+    for (size_t e = _adjacency_begin[node]; e < _adjacency_begin[node + 1];
+         ++e) {
+      const size_t neighbor = static_cast<size_t>(_adjacency[e].first);
+      const double length = entry.first + _adjacency[e].second;
+      if (length < distances[neighbor]) {
+        distances[neighbor] = length;
+        predecessors[neighbor] = static_cast<int>(node);
+        queue.emplace(length, neighbor);
+      }
+    }
+  }
+}
+
+double AMR::WarehouseGraph::distance(const AMR::Coordinates2D &from,
+                                     const AMR::Coordinates2D &to) const {
+  const size_t n_nodes = _nodes.size();
+  auto from_iter = _location_index.find(std::make_pair(from._x, from._y));
+  auto to_iter = _location_index.find(std::make_pair(to._x, to._y));
+  if (from_iter == _location_index.end() && to_iter != _location_index.end()) {
+    // the graph is undirected
+    return distance(to, from);
+  }
+  if (from_iter != _location_index.end()) {
+    const size_t location = static_cast<size_t>(from_iter->second);
+    if (to_iter != _location_index.end()) {
+      const size_t to_location = static_cast<size_t>(to_iter->second);
+      if (location == to_location) {
+        return 0.0;
+      }
+      return _location_offsets[location] +
+             _distances[location * n_nodes + _location_nodes[to_location]] +
+             _location_offsets[to_location];
+    }
+    const size_t to_node = closestNode(to);
+    return _location_offsets[location] +
+           _distances[location * n_nodes + to_node] +
+           euclideanDistance(_nodes[to_node], to);
+  }
+  // neither point is a pickup location
+  const size_t from_node = closestNode(from);
+  const size_t to_node = closestNode(to);
+  std::vector<double> distances(n_nodes);
+  std::vector<int> predecessors(n_nodes);
+  shortestPaths(from_node, distances.data(), predecessors.data());
+  return euclideanDistance(from, _nodes[from_node]) + distances[to_node] +
+         euclideanDistance(_nodes[to_node], to);
+}
+
+std::vector<int> AMR::WarehouseGraph::getRoute(
+    const AMR::Coordinates2D &from, const AMR::Coordinates2D &location) const {
+  std::vector<int> route;
+  auto location_iter =
+      _location_index.find(std::make_pair(location._x, location._y));
+  if (location_iter == _location_index.end()) {
+    return route;
+  }
+  const int *next_hops = &_next_hops[location_iter->second * _nodes.size()];
+  int node = static_cast<int>(closestNode(from));
+  const int target = static_cast<int>(_location_nodes[location_iter->second]);
+  while (node >= 0) {
+    route.push_back(node);
+    if (node == target) {
+      return route;
+    }
+    node = next_hops[node];
+  }
+  // the location cannot be reached
+  route.clear();
+  return route;
+}
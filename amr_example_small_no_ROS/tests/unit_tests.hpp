@@ -5,12 +5,38 @@
 #ifndef INCLUDE_AMR_UNIT_TESTS_HPP_
 #define INCLUDE_AMR_UNIT_TESTS_HPP_
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <numeric>
+#include <random>
+#include <sstream>
 #include <string>
+#include <thread>
 
 #include "amr.hpp"
+#include "yaml-cpp/yaml.h"
 
 namespace AMR {
 namespace tests {
+/**
+ * @brief Creates reproducible, uniformly distributed part locations.
+ */
+std::vector<Coordinates2D> randomPartLocations(const size_t n,
+                                               const unsigned int seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> distribution(0.0, 1000.0);
+  std::vector<Coordinates2D> part_locations;
+  for (size_t i = 0; i < n; ++i) {
+    double x = distribution(generator);
+    double y = distribution(generator);
+    part_locations.emplace_back(x, y);
+  }
+  return part_locations;
+}
+
 TEST(ParseOrder, missingOrderDetected) {
   constexpr uint32_t order_id = 66;
   const std::string dir_path = "./../tests/test_orders";
@@ -35,6 +61,694 @@ TEST(ParseOrder, OrderProcessedCorrectly) {
   EXPECT_EQ(ordered_products, reference_products);
 }
 
+TEST(OrderFileScanner, MatchesYamlParser) {
+  const std::string text =
+      "# orders of one day\n"
+      "- order: 7\n  cx: 1.5\n  cy: -2\n  products:\n  - 3\n  - 4\n"
+      "- order: 8\n  cx: 748.944\n  cy: 474.71707\n  products:\n"
+      "    - 902\n    - 293\n\n"
+      "- order: 9\n  cx: 0\n  cy: 0\n  products: []\n";
+  AMR::Coordinates2D delivery_point;
+  std::vector<long long int> ordered_products;
+  ASSERT_EQ(scanOrderFile(text.data(), text.size(), 8, delivery_point,
+                          ordered_products),
+            AMR::ScanResult::kFound);
+  const YAML::Node order = YAML::Load(text)[1];
+  EXPECT_EQ(delivery_point._x, order["cx"].as<double>());
+  EXPECT_EQ(delivery_point._y, order["cy"].as<double>());
+  EXPECT_EQ(ordered_products, std::vector<long long int>({902, 293}));
+  EXPECT_EQ(scanOrderFile(text.data(), text.size(), 9, delivery_point,
+                          ordered_products),
+            AMR::ScanResult::kFound);
+  EXPECT_EQ(ordered_products.size(), 2u);
+  EXPECT_EQ(scanOrderFile(text.data(), text.size(), 66, delivery_point,
+                          ordered_products),
+            AMR::ScanResult::kNotFound);
+
+  // other layouts are left to yaml-cpp
+  const std::string flow_text = "[{order: 8, cx: 1, cy: 2, products: [3]}]";
+  EXPECT_EQ(scanOrderFile(flow_text.data(), flow_text.size(), 8,
+                          delivery_point, ordered_products),
+            AMR::ScanResult::kRejected);
+  const std::string quoted_text =
+      "- order: 8\n  cx: \"1\"\n  cy: 2\n  products:\n  - 3\n";
+  EXPECT_EQ(scanOrderFile(quoted_text.data(), quoted_text.size(), 8,
+                          delivery_point, ordered_products),
+            AMR::ScanResult::kRejected);
+  EXPECT_EQ(ordered_products.size(), 2u);
+
+  // the test files are mapped and scanned
+  AMR::MappedFile file("./../tests/test_orders/orders_20201201.yaml");
+  ASSERT_TRUE(file.isOpen());
+  ordered_products.clear();
+  EXPECT_EQ(scanOrderFile(file.data(), file.size(), 1000001, delivery_point,
+                          ordered_products),
+            AMR::ScanResult::kFound);
+  EXPECT_DOUBLE_EQ(delivery_point._x, 748.944);
+}
+
+TEST(ParseOrder, EarliestFileWinsForDuplicateIds) {
+  const std::filesystem::path dir_path =
+      std::filesystem::temp_directory_path() / "amr_duplicate_orders_test";
+  std::filesystem::remove_all(dir_path);
+  std::filesystem::create_directories(dir_path);
+  for (int day = 1; day <= 5; ++day) {
+    std::ofstream stream(dir_path /
+                         ("orders_2020120" + std::to_string(day) + ".yaml"));
+    for (int i = 0; i < 1000; ++i) {
+      stream << "- order: " << day * 10000 + i
+             << "\n  cx: 1\n  cy: 2\n  products:\n  - 3\n";
+    }
+    // order 77 is contained in the files of the days 2, 4 and 5
+    if (day % 2 == 0 || day == 5) {
+      stream << "- order: 77\n  cx: " << day
+             << "\n  cy: 0\n  products:\n  - " << day << "\n";
+    }
+  }
+  AMR::Coordinates2D delivery_point;
+  std::vector<long long int> ordered_products;
+  for (int repetition = 0; repetition < 20; ++repetition) {
+    delivery_point = AMR::Coordinates2D();
+    ordered_products.clear();
+    ASSERT_TRUE(parseAllFilesToFindOrder(dir_path.string(), 77,
+                                         delivery_point, ordered_products));
+    EXPECT_DOUBLE_EQ(delivery_point._x, 2.0);
+    EXPECT_EQ(ordered_products, std::vector<long long int>{2});
+  }
+
+  // a file is not searched any further once an earlier file had a hit
+  AMR::OrderSearchToken token(5);
+  token.reportHit(3);
+  token.reportHit(1);
+  EXPECT_EQ(token.getFirstHit(), 1u);
+  AMR::MappedFile file((dir_path / "orders_20201205.yaml").string());
+  ordered_products.clear();
+  EXPECT_EQ(scanOrderFile(file.data(), file.size(), 77, delivery_point,
+                          ordered_products, &token, 4),
+            AMR::ScanResult::kStopped);
+  EXPECT_TRUE(ordered_products.empty());
+  std::filesystem::remove_all(dir_path);
+}
+
+TEST(OrderFileScanner, ChunksMatchWholeFile) {
+  // order 77 is contained twice, in different chunks of a large file
+  const std::filesystem::path dir_path =
+      std::filesystem::temp_directory_path() / "amr_order_chunks_test";
+  std::filesystem::remove_all(dir_path);
+  std::filesystem::create_directories(dir_path);
+  {
+    std::ofstream stream(dir_path / "orders_20201201.yaml");
+    for (int i = 0; i < 80000; ++i) {
+      const int order_id = i == 45000 || i == 70000 ? 77 : 1000000 + i;
+      stream << "- order: " << order_id << "\n  cx: " << i
+             << "\n  cy: 2\n  products:\n  - 3\n";
+    }
+  }
+  AMR::MappedFile file((dir_path / "orders_20201201.yaml").string());
+  const std::vector<size_t> chunk_offsets =
+      AMR::splitOrderFile(file.data(), file.size(), 4);
+  ASSERT_GT(chunk_offsets.size(), 2u);
+  std::vector<uint32_t> order_ids, chunk_order_ids;
+  ASSERT_TRUE(AMR::scanOrderIds(file.data(), file.size(), order_ids));
+  for (size_t i = 0; i < chunk_offsets.size(); ++i) {
+    EXPECT_EQ(AMR::findNextRecord(file.data() + chunk_offsets[i],
+                                  file.data() + file.size()),
+              file.data() + chunk_offsets[i]);
+    const size_t end =
+        i + 1 < chunk_offsets.size() ? chunk_offsets[i + 1] : file.size();
+    ASSERT_TRUE(AMR::scanOrderIds(file.data() + chunk_offsets[i],
+                                  end - chunk_offsets[i], chunk_order_ids));
+  }
+  EXPECT_EQ(chunk_order_ids, order_ids);
+
+  // the first record wins, whether or not the file is split
+  AMR::ThreadPool thread_pool;
+  thread_pool.start(4);
+  AMR::Coordinates2D delivery_point;
+  std::vector<long long int> ordered_products;
+  ASSERT_TRUE(parseAllFilesToFindOrder(dir_path.string(), 77, delivery_point,
+                                       ordered_products, &thread_pool));
+  EXPECT_DOUBLE_EQ(delivery_point._x, 45000.0);
+  EXPECT_EQ(thread_pool.getStatistics(AMR::ThreadPoolSubsystem::kOrderLookup)
+                ._n_tasks,
+            chunk_offsets.size());
+  std::vector<AMR::OrderInformation> orders;
+  EXPECT_TRUE(parseAllFilesToFindOrders(dir_path.string(), {1079999, 77},
+                                        orders, &thread_pool)
+                  .empty());
+  EXPECT_DOUBLE_EQ(orders[0]._delivery_point._x, 79999.0);
+  EXPECT_DOUBLE_EQ(orders[1]._delivery_point._x, 45000.0);
+  AMR::OrderIndex order_index, chunked_order_index;
+  order_index.build(dir_path.string(), "");
+  chunked_order_index.build(dir_path.string(), "", &thread_pool);
+  EXPECT_EQ(chunked_order_index.size(), order_index.size());
+  for (const uint32_t order_id : {77u, 1000000u, 1060000u, 1079999u}) {
+    AMR::OrderRecord record, chunked_record;
+    ASSERT_TRUE(order_index.find(order_id, record));
+    ASSERT_TRUE(chunked_order_index.find(order_id, chunked_record));
+    EXPECT_EQ(chunked_record._offset, record._offset);
+    EXPECT_EQ(chunked_record._length, record._length);
+  }
+  thread_pool.stop();
+  std::filesystem::remove_all(dir_path);
+}
+
+TEST(OrderIndex, FindsOrdersAndPersists) {
+  // the index is written next to the order files, so they are copied
+  const std::filesystem::path dir_path =
+      std::filesystem::temp_directory_path() / "amr_order_index_test";
+  std::filesystem::remove_all(dir_path);
+  std::filesystem::copy("./../tests/test_orders", dir_path);
+  const std::string index_path = (dir_path / ".order_index").string();
+  AMR::OrderIndex order_index;
+  EXPECT_EQ(order_index.build(dir_path.string(), index_path), 5u);
+  AMR::Coordinates2D delivery_point, reference_delivery_point;
+  std::vector<long long int> ordered_products, reference_products;
+  ASSERT_EQ(order_index.lookup(1000001, delivery_point, ordered_products),
+            AMR::OrderIndex::Status::kFound);
+  parseAllFilesToFindOrder(dir_path.string(), 1000001,
+                           reference_delivery_point, reference_products);
+  EXPECT_DOUBLE_EQ(delivery_point._x, reference_delivery_point._x);
+  EXPECT_DOUBLE_EQ(delivery_point._y, reference_delivery_point._y);
+  EXPECT_EQ(ordered_products, reference_products);
+  EXPECT_EQ(order_index.lookup(66, delivery_point, ordered_products),
+            AMR::OrderIndex::Status::kNotFound);
+
+  // unchanged files are taken from the persisted index
+  AMR::OrderIndex persisted_index;
+  EXPECT_EQ(persisted_index.build(dir_path.string(), index_path), 0u);
+  EXPECT_EQ(persisted_index.size(), order_index.size());
+
+  // a changed file is reported by the lookup and scanned again
+  {
+    std::ofstream stream(dir_path / "orders_20201205.yaml", std::ios::app);
+    stream << "- order: 1500001\n  cx: 1.5\n  cy: 2.5\n  products:\n"
+              "  - 401\n";
+  }
+  ordered_products.clear();
+  EXPECT_EQ(persisted_index.lookup(1400001, delivery_point, ordered_products),
+            AMR::OrderIndex::Status::kOutdated);
+  EXPECT_EQ(persisted_index.build(dir_path.string(), index_path), 1u);
+  ASSERT_EQ(persisted_index.lookup(1500001, delivery_point, ordered_products),
+            AMR::OrderIndex::Status::kFound);
+  EXPECT_DOUBLE_EQ(delivery_point._x, 1.5);
+  EXPECT_EQ(ordered_products, std::vector<long long int>{401});
+  std::filesystem::remove_all(dir_path);
+}
+
+TEST(OrderIndex, IgnoresCorruptPersistedIndex) {
+  const std::filesystem::path dir_path =
+      std::filesystem::temp_directory_path() / "amr_order_index_corrupt_test";
+  std::filesystem::remove_all(dir_path);
+  std::filesystem::copy("./../tests/test_orders", dir_path);
+  const std::string index_path = (dir_path / ".order_index").string();
+  auto writeValue = [](std::ofstream &stream, const uint64_t value) {
+    stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+  };
+  // counts that exceed the size of the index, and a truncated valid index
+  {
+    std::ofstream stream(index_path, std::ios::binary);
+    stream.write("AMROIDX1", 8);
+    writeValue(stream, uint64_t{1} << 60);
+  }
+  AMR::OrderIndex order_index;
+  EXPECT_EQ(order_index.build(dir_path.string(), index_path), 5u);
+  const size_t n_orders = order_index.size();
+  {
+    std::ofstream stream(index_path, std::ios::binary);
+    stream.write("AMROIDX1", 8);
+    writeValue(stream, 1);
+    writeValue(stream, 20);
+    stream.write("orders_20201201.yaml", 20);
+    writeValue(stream, ~uint64_t{0});
+    writeValue(stream, 0);
+    writeValue(stream, uint64_t{1} << 59);
+  }
+  AMR::OrderIndex corrupt_index;
+  EXPECT_EQ(corrupt_index.build(dir_path.string(), index_path), 5u);
+  EXPECT_EQ(corrupt_index.size(), n_orders);
+  std::filesystem::resize_file(index_path,
+                               std::filesystem::file_size(index_path) / 2);
+  AMR::OrderIndex truncated_index;
+  EXPECT_EQ(truncated_index.build(dir_path.string(), index_path), 5u);
+  EXPECT_EQ(truncated_index.size(), n_orders);
+  std::filesystem::remove_all(dir_path);
+}
+
+TEST(OrderIndex, RefreshesWhileLookupsArePending) {
+  AMR::ThreadPool thread_pool;
+  thread_pool.start(2);
+  AMR::OrderIndex order_index;
+  EXPECT_EQ(order_index.build("./../tests/test_orders", "", &thread_pool),
+            5u);
+  // the lookups are queued on the pool that also scans the files of the
+  // refresh, like the prefetches of the unit while the watcher refreshes
+  constexpr size_t n_lookups = 200;
+  std::atomic<size_t> n_found(0);
+  for (size_t i = 0; i < n_lookups; ++i) {
+    thread_pool.submit(AMR::ThreadPoolSubsystem::kOrderLookup, [&]() {
+      AMR::Coordinates2D delivery_point;
+      std::vector<long long int> ordered_products;
+      if (order_index.lookup(1000001, delivery_point, ordered_products) ==
+          AMR::OrderIndex::Status::kFound) {
+        ++n_found;
+      }
+    });
+  }
+  for (int refresh = 0; refresh < 5; ++refresh) {
+    EXPECT_EQ(order_index.refresh(), 5u);
+  }
+  thread_pool.stop();
+  EXPECT_EQ(n_found, n_lookups);
+  EXPECT_EQ(order_index.size(), 5u);
+}
+
+TEST(OrderIndex, UpdatesFilesWhileLookupsArePending) {
+  const std::filesystem::path dir_path =
+      std::filesystem::temp_directory_path() / "amr_order_update_test";
+  std::filesystem::remove_all(dir_path);
+  std::filesystem::copy("./../tests/test_orders", dir_path);
+  AMR::ThreadPool thread_pool;
+  thread_pool.start(2);
+  AMR::OrderIndex order_index;
+  EXPECT_EQ(order_index.build(dir_path.string(), "", &thread_pool), 5u);
+  // the files are scanned while lookups of the index are queued on the pool
+  constexpr size_t n_lookups = 200;
+  std::atomic<size_t> n_found(0);
+  for (size_t i = 0; i < n_lookups; ++i) {
+    thread_pool.submit(AMR::ThreadPoolSubsystem::kOrderLookup, [&]() {
+      AMR::Coordinates2D delivery_point;
+      std::vector<long long int> ordered_products;
+      if (order_index.lookup(1000001, delivery_point, ordered_products) ==
+          AMR::OrderIndex::Status::kFound) {
+        ++n_found;
+      }
+    });
+  }
+  auto lookup = [&order_index](const uint32_t order_id) {
+    AMR::Coordinates2D delivery_point;
+    std::vector<long long int> ordered_products;
+    return order_index.lookup(order_id, delivery_point, ordered_products);
+  };
+  const std::filesystem::path file_path = dir_path / "orders_20201206.yaml";
+  {
+    std::ofstream stream(file_path);
+    stream << "- order: 1600001\n  cx: 3.5\n  cy: 4.5\n  products:\n"
+              "  - 402\n";
+  }
+  EXPECT_TRUE(order_index.updateFile("orders_20201206.yaml"));
+  EXPECT_FALSE(order_index.updateFile("orders_20201206.yaml"));
+  EXPECT_EQ(lookup(1600001), AMR::OrderIndex::Status::kFound);
+  {
+    std::ofstream stream(file_path, std::ios::app);
+    stream << "- order: 1600002\n  cx: 5.5\n  cy: 6.5\n  products:\n"
+              "  - 403\n";
+  }
+  EXPECT_TRUE(order_index.updateFile("orders_20201206.yaml"));
+  EXPECT_EQ(lookup(1600001), AMR::OrderIndex::Status::kFound);
+  EXPECT_EQ(lookup(1600002), AMR::OrderIndex::Status::kFound);
+  {
+    // the file is rewritten, so its first record changed
+    std::ofstream stream(file_path, std::ios::trunc);
+    stream << "- order: 1600003\n  cx: 7.5\n  cy: 8.5\n  products:\n"
+              "  - 404\n";
+  }
+  EXPECT_TRUE(order_index.updateFile("orders_20201206.yaml"));
+  EXPECT_EQ(lookup(1600001), AMR::OrderIndex::Status::kNotFound);
+  EXPECT_EQ(lookup(1600003), AMR::OrderIndex::Status::kFound);
+  std::filesystem::remove(file_path);
+  EXPECT_TRUE(order_index.updateFile("orders_20201206.yaml"));
+  EXPECT_EQ(lookup(1600003), AMR::OrderIndex::Status::kNotFound);
+  EXPECT_EQ(order_index.getNumberOfFiles(), 5u);
+  thread_pool.stop();
+  EXPECT_EQ(n_found, n_lookups);
+  std::filesystem::remove_all(dir_path);
+}
+
+TEST(OrderDirectoryWatcher, IndexesNewAndAppendedFiles) {
+  const std::filesystem::path dir_path =
+      std::filesystem::temp_directory_path() / "amr_order_watcher_test";
+  std::filesystem::remove_all(dir_path);
+  std::filesystem::copy("./../tests/test_orders", dir_path);
+  AMR::OrderIndex order_index;
+  order_index.build(dir_path.string(), "");
+  AMR::OrderDirectoryWatcher watcher;
+  ASSERT_TRUE(watcher.start(dir_path.string(), order_index));
+  // waits until the watcher updated the index, for at most 2 s
+  auto waitForLookup = [&order_index](const uint32_t order_id,
+                                      const AMR::OrderIndex::Status status) {
+    AMR::Coordinates2D delivery_point;
+    std::vector<long long int> ordered_products;
+    for (int i = 0; i < 200; ++i) {
+      if (order_index.lookup(order_id, delivery_point, ordered_products) ==
+          status) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+  };
+
+  {
+    std::ofstream stream(dir_path / "orders_20201205.yaml", std::ios::app);
+    stream << "- order: 1500001\n  cx: 1.5\n  cy: 2.5\n  products:\n"
+              "  - 401\n";
+  }
+  EXPECT_TRUE(waitForLookup(1500001, AMR::OrderIndex::Status::kFound));
+  EXPECT_TRUE(waitForLookup(1400001, AMR::OrderIndex::Status::kFound));
+  {
+    std::ofstream stream(dir_path / "orders_20201206.yaml");
+    stream << "- order: 1600001\n  cx: 3.5\n  cy: 4.5\n  products:\n"
+              "  - 402\n";
+  }
+  EXPECT_TRUE(waitForLookup(1600001, AMR::OrderIndex::Status::kFound));
+  EXPECT_EQ(order_index.getNumberOfFiles(), 6u);
+  AMR::Coordinates2D delivery_point;
+  std::vector<long long int> ordered_products;
+  EXPECT_TRUE(parseAllFilesToFindOrder(dir_path.string(), 1600001,
+                                       delivery_point, ordered_products));
+  EXPECT_EQ(ordered_products, std::vector<long long int>{402});
+
+  std::filesystem::remove(dir_path / "orders_20201206.yaml");
+  EXPECT_TRUE(waitForLookup(1600001, AMR::OrderIndex::Status::kNotFound));
+  watcher.stop();
+  EXPECT_FALSE(watcher.isRunning());
+  std::filesystem::remove_all(dir_path);
+}
+
+TEST(OrderStore, MatchesOrderFiles) {
+  const std::string dir_path = "./../tests/test_orders";
+  const std::string store_path =
+      (std::filesystem::temp_directory_path() / "amr_orders.store").string();
+  ASSERT_TRUE(AMR::OrderStore::compile(dir_path, store_path));
+  AMR::OrderStore order_store;
+  ASSERT_TRUE(order_store.open(store_path));
+  // the first and the last order of every file are compared
+  size_t n_orders = 0;
+  for (const std::string &file_path : listOrderFiles(dir_path)) {
+    const YAML::Node orders = YAML::LoadFile(file_path);
+    n_orders += orders.size();
+    for (const YAML::Node &order : {orders[0], orders[orders.size() - 1]}) {
+      const uint32_t order_id = order["order"].as<uint32_t>();
+      AMR::StoredOrder stored_order;
+      ASSERT_TRUE(order_store.find(order_id, stored_order));
+      EXPECT_FLOAT_EQ(stored_order._x, order["cx"].as<float>());
+      EXPECT_FLOAT_EQ(stored_order._y, order["cy"].as<float>());
+      std::vector<long long int> products(
+          stored_order._products,
+          stored_order._products + stored_order._n_products);
+      EXPECT_EQ(products, order["products"].as<std::vector<long long int>>());
+    }
+  }
+  EXPECT_EQ(order_store.size(), n_orders);
+
+  // the store is used as backend of the search in all files
+  AMR::Coordinates2D delivery_point;
+  std::vector<long long int> ordered_products;
+  ASSERT_TRUE(parseAllFilesToFindOrder("/nonexistent", 1000001,
+                                       delivery_point, ordered_products,
+                                       nullptr, &order_store));
+  EXPECT_FLOAT_EQ(delivery_point._x, 748.944f);
+  EXPECT_EQ(ordered_products,
+            std::vector<long long int>({902, 293, 142, 56, 894}));
+  EXPECT_FALSE(parseAllFilesToFindOrder(dir_path, 66, delivery_point,
+                                        ordered_products, nullptr,
+                                        &order_store));
+  order_store.close();
+  EXPECT_FALSE(order_store.isOpen());
+  std::filesystem::remove(store_path);
+}
+
+TEST(OrderStore, IgnoresOrdersOfChangedFiles) {
+  const std::filesystem::path dir_path =
+      std::filesystem::temp_directory_path() / "amr_order_store_test";
+  std::filesystem::remove_all(dir_path);
+  std::filesystem::copy("./../tests/test_orders", dir_path);
+  const std::string store_path = (dir_path / "orders.store").string();
+  ASSERT_TRUE(AMR::OrderStore::compile(dir_path.string(), store_path));
+  AMR::OrderStore order_store;
+  ASSERT_TRUE(order_store.open(store_path));
+  AMR::Coordinates2D delivery_point;
+  std::vector<long long int> ordered_products;
+  EXPECT_TRUE(order_store.lookup(1000001, delivery_point, ordered_products));
+  EXPECT_TRUE(order_store.lookup(1400001, delivery_point, ordered_products));
+
+  // the first file is rewritten with other products for its first order, so
+  // its orders are searched in the files again, the others are still stored
+  {
+    std::ofstream stream(dir_path / "orders_20201201.yaml", std::ios::trunc);
+    stream << "- order: 1000001\n  cx: 1.5\n  cy: 2.5\n  products:\n"
+              "  - 401\n";
+  }
+  ordered_products.clear();
+  EXPECT_FALSE(order_store.lookup(1000001, delivery_point, ordered_products));
+  EXPECT_TRUE(ordered_products.empty());
+  AMR::StoredOrder stored_order;
+  ASSERT_TRUE(order_store.find(1000001, stored_order));
+  EXPECT_FALSE(order_store.isCurrent(stored_order._file));
+  EXPECT_TRUE(order_store.lookup(1400001, delivery_point, ordered_products));
+  ordered_products.clear();
+  ASSERT_TRUE(parseAllFilesToFindOrder(dir_path.string(), 1000001,
+                                       delivery_point, ordered_products,
+                                       nullptr, &order_store));
+  EXPECT_EQ(ordered_products, std::vector<long long int>{401});
+  std::filesystem::remove_all(dir_path);
+}
+
+TEST(ParseOrder, BatchLookupMatchesSingleLookups) {
+  const std::string dir_path = "./../tests/test_orders";
+  const std::vector<uint32_t> order_ids = {1000001, 66, 1400001, 1000001,
+                                           1200001, 66, 67};
+  std::vector<AMR::OrderInformation> orders;
+  const std::vector<uint32_t> missing_order_ids =
+      parseAllFilesToFindOrders(dir_path, order_ids, orders);
+  EXPECT_EQ(missing_order_ids, std::vector<uint32_t>({66, 67}));
+  ASSERT_EQ(orders.size(), order_ids.size());
+  AMR::OrderIndex order_index;
+  order_index.build(dir_path, "");
+  std::vector<AMR::OrderInformation> index_orders;
+  const std::vector<AMR::OrderIndex::Status> statuses =
+      order_index.lookup(order_ids, index_orders);
+  for (size_t i = 0; i < order_ids.size(); ++i) {
+    AMR::Coordinates2D delivery_point;
+    std::vector<long long int> ordered_products;
+    const bool found = parseAllFilesToFindOrder(
+        dir_path, order_ids[i], delivery_point, ordered_products);
+    EXPECT_EQ(orders[i]._found, found);
+    EXPECT_EQ(statuses[i], found ? AMR::OrderIndex::Status::kFound
+                                 : AMR::OrderIndex::Status::kNotFound);
+    EXPECT_DOUBLE_EQ(orders[i]._delivery_point._x, delivery_point._x);
+    EXPECT_DOUBLE_EQ(index_orders[i]._delivery_point._y, delivery_point._y);
+    EXPECT_EQ(orders[i]._ordered_products, ordered_products);
+    EXPECT_EQ(index_orders[i]._ordered_products, ordered_products);
+  }
+}
+
+TEST(OrderFileFilters, SkipFilesWithoutTheOrder) {
+  // a filter never rules out a contained id and rarely accepts another one
+  std::vector<uint32_t> order_ids;
+  for (uint32_t order_id = 1000001; order_id < 1020001; order_id += 2) {
+    order_ids.push_back(order_id);
+  }
+  const AMR::OrderIdFilter filter(order_ids);
+  size_t n_false_positives = 0;
+  for (const uint32_t order_id : order_ids) {
+    ASSERT_TRUE(filter.mayContain(order_id));
+    n_false_positives += filter.mayContain(order_id + 1);
+  }
+  EXPECT_LT(n_false_positives, 300u);
+  EXPECT_FALSE(filter.mayContain(999999));
+  EXPECT_FALSE(AMR::OrderIdFilter().mayContain(1000001));
+
+  const std::filesystem::path dir_path =
+      std::filesystem::temp_directory_path() / "amr_order_filters_test";
+  std::filesystem::remove_all(dir_path);
+  std::filesystem::copy("./../tests/test_orders", dir_path);
+  AMR::OrderFileFilters order_file_filters;
+  EXPECT_EQ(order_file_filters.build(dir_path.string()), 5u);
+  const std::vector<std::string> file_paths =
+      listOrderFiles(dir_path.string());
+  EXPECT_TRUE(order_file_filters.selectFiles(file_paths, 66).empty());
+  EXPECT_EQ(order_file_filters.selectFiles(file_paths, 1000001),
+            std::vector<std::string>{file_paths[0]});
+  AMR::Coordinates2D delivery_point;
+  std::vector<long long int> ordered_products;
+  EXPECT_TRUE(parseAllFilesToFindOrder(dir_path.string(), 1000001,
+                                       delivery_point, ordered_products,
+                                       nullptr, nullptr, &order_file_filters));
+  EXPECT_DOUBLE_EQ(delivery_point._x, 748.944);
+
+  // a file that changed is searched until its filter is updated
+  {
+    std::ofstream stream(dir_path / "orders_20201205.yaml", std::ios::app);
+    stream << "- order: 66\n  cx: 1.5\n  cy: 2.5\n  products:\n  - 401\n";
+  }
+  EXPECT_EQ(order_file_filters.selectFiles(file_paths, 66),
+            std::vector<std::string>{file_paths[4]});
+  EXPECT_TRUE(order_file_filters.updateFile("orders_20201205.yaml"));
+  EXPECT_EQ(order_file_filters.selectFiles(file_paths, 66),
+            std::vector<std::string>{file_paths[4]});
+  EXPECT_TRUE(order_file_filters.selectFiles(file_paths, 67).empty());
+  std::filesystem::remove_all(dir_path);
+}
+
+TEST(OrderExecutor, UsesPrefetchedOrder) {
+  const std::filesystem::path dir_path =
+      std::filesystem::temp_directory_path() / "amr_prefetch_test";
+  std::filesystem::remove_all(dir_path);
+  std::filesystem::create_directories(dir_path);
+  std::filesystem::copy("./../tests/test_configuration",
+                        dir_path / "configuration");
+  // the test configuration only contains the products 1 to 3
+  std::filesystem::create_directories(dir_path / "orders");
+  {
+    std::ofstream stream(dir_path / "orders" / "orders_20201201.yaml");
+    stream << "- order: 77\n  cx: 1.5\n  cy: 2.5\n  products:\n  - 1\n"
+              "  - 3\n";
+  }
+  AMR::AmrUnit amr_unit(dir_path.string());
+  amr_unit.setThreadPoolSize(2);
+  amr_unit.initialize();
+  AMR::OrderExecutor order_executor(77, "prefetched");
+  order_executor.prefetch(amr_unit);
+  for (int i = 0; i < 1000 && !order_executor.isPrefetched(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_TRUE(order_executor.isPrefetched());
+
+  // the order files are gone, so the order is only found if the planner
+  // uses the prefetched result instead of looking it up again
+  std::filesystem::remove_all(dir_path / "orders");
+  std::stringstream stream;
+  order_executor.execute(amr_unit, stream);
+  EXPECT_EQ(stream.str().find("not found"), std::string::npos);
+  EXPECT_NE(stream.str().find("Delivering to destination x: 1.5"),
+            std::string::npos);
+  AMR::OrderExecutor other_order_executor(77, "not prefetched");
+  stream.str("");
+  other_order_executor.execute(amr_unit, stream);
+  EXPECT_NE(stream.str().find("not found"), std::string::npos);
+  std::filesystem::remove_all(dir_path);
+}
+
+TEST(ThreadPool, RunsNestedGroupsAndCountsSubsystems) {
+  AMR::ThreadPool thread_pool;
+  thread_pool.start(3);
+  ASSERT_EQ(thread_pool.getSize(), 3u);
+  // the inner groups are run from workers, which help instead of blocking
+  std::atomic<size_t> sum(0);
+  thread_pool.run(AMR::ThreadPoolSubsystem::kSolver, 8, [&](size_t outer) {
+    thread_pool.run(AMR::ThreadPoolSubsystem::kCatalog, 4,
+                    [&](size_t inner) { sum += 10 * outer + inner; });
+  });
+  EXPECT_EQ(sum, 4 * 280u + 8 * 6u);
+  EXPECT_EQ(
+      thread_pool.getStatistics(AMR::ThreadPoolSubsystem::kSolver)._n_tasks,
+      8u);
+  EXPECT_EQ(
+      thread_pool.getStatistics(AMR::ThreadPoolSubsystem::kCatalog)._n_tasks,
+      32u);
+
+  // the results do not depend on whether the pool is used
+  AMR::Coordinates2D delivery_point;
+  std::vector<long long int> ordered_products;
+  ASSERT_TRUE(parseAllFilesToFindOrder("./../tests/test_orders", 1000001,
+                                       delivery_point, ordered_products,
+                                       &thread_pool));
+  EXPECT_EQ(ordered_products,
+            std::vector<long long int>({902, 293, 142, 56, 894}));
+  EXPECT_EQ(thread_pool.getStatistics(AMR::ThreadPoolSubsystem::kOrderLookup)
+                ._n_tasks,
+            5u);
+  const DistanceMatrix distances(Coordinates2D(0.0, 0.0),
+                                 randomPartLocations(14, 19),
+                                 Coordinates2D(500.0, 1000.0));
+  std::vector<int> pickup_order, pool_pickup_order;
+  const double length = solveHeldKarp(distances, pickup_order, 4);
+  EXPECT_EQ(solveHeldKarp(distances, pool_pickup_order, 0, nullptr,
+                          &thread_pool),
+            length);
+  EXPECT_EQ(pool_pickup_order, pickup_order);
+  const DistanceMatrix small_distances(Coordinates2D(0.0, 0.0),
+                                       randomPartLocations(9, 19),
+                                       Coordinates2D(500.0, 1000.0));
+  EXPECT_EQ(solveExhaustive(small_distances, pool_pickup_order, 0, nullptr,
+                            &thread_pool),
+            solveExhaustive(small_distances, pickup_order, 4));
+  EXPECT_EQ(pool_pickup_order, pickup_order);
+  thread_pool.stop();
+  EXPECT_EQ(thread_pool.getSize(), 0u);
+}
+
+TEST(ThreadPool, UtilizationCountsOnlyWorkers) {
+  AMR::ThreadPool thread_pool;
+  thread_pool.start(1);
+  // the calling thread and the worker sleep at the same time, and the
+  // worker also waits for a nested group
+  thread_pool.run(AMR::ThreadPoolSubsystem::kSolver, 4, [&](size_t) {
+    thread_pool.run(AMR::ThreadPoolSubsystem::kCatalog, 2, [](size_t) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    });
+  });
+  double busy_seconds = 0.0, utilization = 0.0;
+  for (const AMR::ThreadPoolSubsystem subsystem :
+       {AMR::ThreadPoolSubsystem::kSolver,
+        AMR::ThreadPoolSubsystem::kCatalog}) {
+    const AMR::ThreadPoolStatistics statistics =
+        thread_pool.getStatistics(subsystem);
+    busy_seconds += statistics._busy_seconds;
+    utilization += statistics._utilization;
+  }
+  EXPECT_EQ(thread_pool.getStatistics(AMR::ThreadPoolSubsystem::kCatalog)
+                ._n_tasks,
+            8u);
+  EXPECT_GT(busy_seconds, 0.0);
+  EXPECT_LE(utilization, 1.0);
+  thread_pool.stop();
+}
+
+TEST(ThreadPool, WaitingCallerOnlyExecutesItsOwnGroup) {
+  AMR::ThreadPool thread_pool;
+  thread_pool.start(1);
+  // the worker is blocked, so a submitted task stays pending while the
+  // calling thread waits for its group
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  thread_pool.submit(AMR::ThreadPoolSubsystem::kOrderLookup,
+                     [released]() { released.wait(); });
+  std::promise<std::thread::id> lookup_thread;
+  std::future<std::thread::id> lookup_thread_id = lookup_thread.get_future();
+  thread_pool.submit(AMR::ThreadPoolSubsystem::kOrderLookup, [&]() {
+    lookup_thread.set_value(std::this_thread::get_id());
+  });
+  std::atomic<size_t> n_calls(0);
+  thread_pool.run(AMR::ThreadPoolSubsystem::kSolver, 4,
+                  [&](size_t) { ++n_calls; });
+  EXPECT_EQ(n_calls, 4u);
+  release.set_value();
+  EXPECT_NE(lookup_thread_id.get(), std::this_thread::get_id());
+  thread_pool.stop();
+}
+
+TEST(ThreadPool, SubmitWhileStoppingExecutesEveryTask) {
+  AMR::ThreadPool thread_pool;
+  thread_pool.start(2);
+  // tasks are submitted by another thread while the pool is stopped; those
+  // submitted after the stop are executed by the submitting thread
+  std::atomic<size_t> n_executed(0);
+  std::thread submitter([&]() {
+    for (size_t i = 0; i < 10000; ++i) {
+      thread_pool.submit(AMR::ThreadPoolSubsystem::kOrderLookup,
+                         [&n_executed]() { ++n_executed; });
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  thread_pool.stop();
+  submitter.join();
+  EXPECT_EQ(n_executed, 10000u);
+  EXPECT_EQ(thread_pool.getSize(), 0u);
+}
+
 TEST(ParseConfiguration, ProductsParsedCorrectly) {
   const std::string dir_path = "./../tests/test_configuration";
   std::vector<AMR::Product> products;
@@ -69,6 +783,18 @@ TEST(ParseConfiguration, ProductsParsedCorrectly) {
   EXPECT_DOUBLE_EQ(product_parts.at(2)._coords._y, 68.39627);
 }
 
+TEST(ParseConfiguration, RejectsMalformedPlanningBudget) {
+  uint32_t planning_budget_ms = 7;
+  EXPECT_TRUE(parsePlanningBudget("250", planning_budget_ms));
+  EXPECT_EQ(planning_budget_ms, 250u);
+  for (const std::string text :
+       {"-5", "fast", "", "12ms", "1.5", "4294967296"}) {
+    planning_budget_ms = 7;
+    EXPECT_FALSE(parsePlanningBudget(text, planning_budget_ms)) << text;
+    EXPECT_EQ(planning_budget_ms, 0u);
+  }
+}
+
 TEST(ShortestPath, DeterminePathCorrectly) {
   const Coordinates2D starting_point(0.0, 0.0);
   const std::vector<Coordinates2D> part_locations_a{
@@ -90,6 +816,680 @@ TEST(ShortestPath, DeterminePathCorrectly) {
   EXPECT_EQ(pickup_order, std::vector<int>({1, 0, 2}));
 }
 
+TEST(PathCache, EvictsLeastRecentlyUsedEntry) {
+  PathCache path_cache(2, 10.0);
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(100.0, 100.0);
+  path_cache.insert({0, 1}, starting_point, delivery_point, {1, 0});
+  path_cache.insert({0, 2}, starting_point, delivery_point, {0, 2});
+  std::vector<long long int> pickup_order;
+  // points in the same grid cell share an entry
+  EXPECT_TRUE(path_cache.find({0, 1}, Coordinates2D(1.0, -2.0),
+                              delivery_point, pickup_order));
+  EXPECT_EQ(pickup_order, std::vector<long long int>({1, 0}));
+  EXPECT_FALSE(path_cache.find({0, 1}, starting_point,
+                               Coordinates2D(200.0, 100.0), pickup_order));
+  // {0, 2} is now the least recently used entry
+  path_cache.insert({1, 2}, starting_point, delivery_point, {2, 1});
+  EXPECT_EQ(path_cache.size(), 2u);
+  EXPECT_FALSE(
+      path_cache.find({0, 2}, starting_point, delivery_point, pickup_order));
+  EXPECT_TRUE(
+      path_cache.find({1, 2}, starting_point, delivery_point, pickup_order));
+  EXPECT_EQ(path_cache.getHits(), 2u);
+  EXPECT_EQ(path_cache.getMisses(), 2u);
+}
+
+TEST(PathCache, PreloadsRecentOrderFiles) {
+  std::vector<AMR::Product> products;
+  std::vector<AMR::ProductPart> product_parts;
+  parseConfigurationFiles("./../data/configuration", products, product_parts);
+  PathCache path_cache;
+  // the two most recent files contain 2 orders (1300001 and 1400001)
+  size_t n_preloaded =
+      path_cache.preload("./../tests/test_orders", 2, products, product_parts,
+                         Coordinates2D(0.0, 0.0), PathSolverOptions());
+  EXPECT_EQ(n_preloaded, 2u);
+  EXPECT_EQ(path_cache.size(), 2u);
+
+  // the orders are solved as when they are executed, i.e. with the table
+  // and the distances of the catalog
+  CatalogPathTable catalog_table;
+  ASSERT_TRUE(catalog_table.build(product_parts, 16, 1));
+  CatalogDistanceMatrix catalog_distances;
+  catalog_distances.build(product_parts);
+  PathCache catalog_path_cache;
+  EXPECT_EQ(catalog_path_cache.preload("./../tests/test_orders", 2, products,
+                                       product_parts, Coordinates2D(0.0, 0.0),
+                                       PathSolverOptions(), &catalog_table,
+                                       &catalog_distances),
+            2u);
+}
+
+TEST(PathCache, PreloadSkipsPathsCutShortByTheBudget) {
+  const std::filesystem::path dir_path =
+      std::filesystem::temp_directory_path() / "amr_path_cache_test";
+  std::filesystem::remove_all(dir_path);
+  std::filesystem::create_directories(dir_path);
+  {
+    std::ofstream stream(dir_path / "orders_20201201.yaml");
+    stream << "- order: 1\n  cx: 0\n  cy: 0\n  products:\n  - 0\n";
+  }
+  // a single product with more parts than the heuristic cutoff, so its path
+  // is never proven to be the shortest one
+  std::vector<AMR::ProductPart> product_parts;
+  std::vector<AMR::Product> products(1);
+  const std::vector<Coordinates2D> locations = randomPartLocations(30, 1201);
+  for (size_t i = 0; i < locations.size(); ++i) {
+    product_parts.emplace_back("part_" + std::to_string(i), locations[i]._x,
+                               locations[i]._y);
+    products[0]._parts[i] = 1;
+  }
+  PathSolverOptions options;
+  options._planning_budget_ms = 1;
+  PathCache path_cache;
+  EXPECT_EQ(path_cache.preload(dir_path.string(), 1, products, product_parts,
+                               Coordinates2D(0.0, 0.0), options),
+            0u);
+  EXPECT_EQ(path_cache.size(), 0u);
+  // without a budget, the heuristic path does not depend on the timing
+  options._planning_budget_ms = 0;
+  EXPECT_EQ(path_cache.preload(dir_path.string(), 1, products, product_parts,
+                               Coordinates2D(0.0, 0.0), options),
+            1u);
+  std::filesystem::remove_all(dir_path);
+}
+
+TEST(CatalogPathTable, MatchesHeldKarp) {
+  const std::vector<Coordinates2D> locations = randomPartLocations(10, 1100);
+  std::vector<AMR::ProductPart> product_parts;
+  for (size_t i = 0; i < 2 * locations.size(); ++i) {
+    // two parts share each location
+    const Coordinates2D& location = locations[i % locations.size()];
+    product_parts.emplace_back("part_" + std::to_string(i), location._x,
+                               location._y);
+  }
+  CatalogPathTable table;
+  ASSERT_TRUE(table.build(product_parts, 16, 3));
+  EXPECT_EQ(table.getNumberOfLocations(), locations.size());
+
+  std::mt19937 generator(1101);
+  std::uniform_int_distribution<size_t> part_distribution(
+      0, product_parts.size() - 1);
+  for (size_t n = 0; n <= 12; ++n) {
+    std::vector<Coordinates2D> part_locations;
+    for (size_t i = 0; i < n; ++i) {
+      part_locations.push_back(
+          product_parts[part_distribution(generator)]._coords);
+    }
+    const Coordinates2D starting_point(10.0 * n, 0.0);
+    const Coordinates2D delivery_point(800.0, 50.0 * n);
+    std::vector<int> pickup_order, held_karp_order;
+    double length = 0.0;
+    ASSERT_TRUE(table.solve(starting_point, part_locations, delivery_point,
+                            pickup_order, length));
+    ASSERT_EQ(pickup_order.size(), n);
+    EXPECT_DOUBLE_EQ(length,
+                     determinePathLength(starting_point, part_locations,
+                                         delivery_point, pickup_order));
+    // the table stores floats
+    double shortest_length = solveHeldKarp(starting_point, part_locations,
+                                           delivery_point, held_karp_order);
+    EXPECT_NEAR(length, shortest_length, 1e-4 * shortest_length);
+  }
+}
+
+TEST(CatalogPathTable, RejectsLargeCatalogsAndUnknownLocations) {
+  std::vector<AMR::ProductPart> product_parts;
+  for (const Coordinates2D& location : randomPartLocations(5, 1200)) {
+    product_parts.emplace_back("part", location._x, location._y);
+  }
+  CatalogPathTable table;
+  EXPECT_FALSE(table.build(product_parts, 4));
+  EXPECT_FALSE(table.isAvailable());
+  ASSERT_TRUE(table.build(product_parts, 5));
+  std::vector<int> pickup_order;
+  double length = 0.0;
+  EXPECT_FALSE(table.solve(Coordinates2D(0.0, 0.0),
+                           {product_parts[0]._coords, Coordinates2D(1.0, 1.0)},
+                           Coordinates2D(0.0, 0.0), pickup_order, length));
+}
+
+TEST(DistanceMatrix, CatalogDistancesMatchComputedDistances) {
+  const std::vector<Coordinates2D> locations = randomPartLocations(150, 1300);
+  std::vector<AMR::ProductPart> product_parts;
+  for (const Coordinates2D& location : locations) {
+    product_parts.emplace_back("part", location._x, location._y);
+  }
+  CatalogDistanceMatrix packed_distances, tiled_distances;
+  packed_distances.build(product_parts);
+  // room for two tiles, so tiles are evicted and recomputed
+  tiled_distances.build(product_parts, 2 * CatalogDistanceMatrix::kTileSize *
+                                           CatalogDistanceMatrix::kTileSize *
+                                           sizeof(double));
+  EXPECT_EQ(packed_distances.getLayout(),
+            CatalogDistanceMatrix::Layout::kPacked);
+  EXPECT_EQ(tiled_distances.getLayout(), CatalogDistanceMatrix::Layout::kTiled);
+  EXPECT_EQ(packed_distances.findLocation(Coordinates2D(-1.0, -1.0)), -1);
+
+  std::mt19937 generator(1301);
+  std::vector<Coordinates2D> part_locations = locations;
+  std::shuffle(part_locations.begin(), part_locations.end(), generator);
+  part_locations.resize(40);
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  DistanceMatrix computed(starting_point, part_locations, delivery_point);
+  DistanceMatrix packed(starting_point, part_locations, delivery_point,
+                        packed_distances);
+  DistanceMatrix tiled(starting_point, part_locations, delivery_point,
+                       tiled_distances);
+  for (size_t i = 0; i < computed.getNumberOfNodes(); ++i) {
+    for (size_t j = 0; j < computed.getNumberOfNodes(); ++j) {
+      ASSERT_EQ(packed(i, j), computed(i, j));
+      ASSERT_EQ(tiled(i, j), computed(i, j));
+    }
+  }
+}
+
+TEST(WarehouseGraph, DistancesFollowAisles) {
+  WarehouseGraph missing_graph;
+  EXPECT_FALSE(missing_graph.load("./../tests/test_configuration/none.yaml"));
+  EXPECT_FALSE(missing_graph.isLoaded());
+
+  WarehouseGraph graph;
+  ASSERT_TRUE(
+      graph.load("./../tests/test_configuration/warehouse_graph.yaml"));
+  EXPECT_EQ(graph.getNumberOfNodes(), 5);
+  std::vector<AMR::ProductPart> product_parts;
+  product_parts.emplace_back("left", 0.0, 0.0);
+  product_parts.emplace_back("right", 10.0, 0.0);
+  product_parts.emplace_back("outside", 21.0, 0.0);
+  graph.precompute(product_parts, 2);
+
+  // the rack has to be passed at its far end
+  EXPECT_DOUBLE_EQ(graph.distance(Coordinates2D(0.0, 0.0),
+                                  Coordinates2D(10.0, 0.0)),
+                   210.0);
+  EXPECT_DOUBLE_EQ(graph.distance(Coordinates2D(10.0, 0.0),
+                                  Coordinates2D(0.0, 0.0)),
+                   210.0);
+  // explicit edge length plus the way from the closest node
+  EXPECT_DOUBLE_EQ(graph.distance(Coordinates2D(10.0, 0.0),
+                                  Coordinates2D(21.0, 0.0)),
+                   16.0);
+  // neither point is a pickup location
+  EXPECT_DOUBLE_EQ(graph.distance(Coordinates2D(0.0, 60.0),
+                                  Coordinates2D(10.0, 60.0)),
+                   90.0);
+  EXPECT_EQ(graph.getRoute(Coordinates2D(10.0, 0.0), Coordinates2D(0.0, 0.0)),
+            std::vector<int>({3, 2, 1, 0}));
+  EXPECT_TRUE(
+      graph.getRoute(Coordinates2D(10.0, 0.0), Coordinates2D(5.0, 5.0))
+          .empty());
+}
+
+TEST(ShortestPath, UsesWarehouseGraphDistances) {
+  WarehouseGraph graph;
+  ASSERT_TRUE(
+      graph.load("./../tests/test_configuration/warehouse_graph.yaml"));
+  std::vector<AMR::ProductPart> product_parts;
+  product_parts.emplace_back("left", 0.0, 0.0);
+  product_parts.emplace_back("right", 10.0, 0.0);
+  graph.precompute(product_parts);
+
+  const Coordinates2D starting_point(5.0, 100.0);
+  const Coordinates2D delivery_point(10.0, -1.0);
+  const std::vector<Coordinates2D> part_locations = {Coordinates2D(10.0, 0.0),
+                                                     Coordinates2D(0.0, 0.0)};
+  // after the left part, the robot has to go around the rack
+  std::vector<int> pickup_order;
+  PathSolverResult result =
+      determineShortestPath(starting_point, part_locations, delivery_point,
+                            pickup_order, PathSolverOptions(), nullptr, &graph);
+  EXPECT_EQ(pickup_order, std::vector<int>({1, 0}));
+  EXPECT_DOUBLE_EQ(result._path_length, 316.0);
+  EXPECT_TRUE(result._proven_optimal);
+
+  // the straight line ignores the rack
+  std::vector<int> euclidean_order;
+  determineShortestPath(starting_point, part_locations, delivery_point,
+                        euclidean_order);
+  EXPECT_LT(determinePathLength(starting_point, part_locations,
+                                delivery_point, euclidean_order),
+            result._path_length);
+}
+
+TEST(DistanceMatrix, MetricKernelsMatchScalarDistance) {
+  const std::vector<Coordinates2D> part_locations =
+      randomPartLocations(13, 1400);
+  const Coordinates2D starting_point(10.0, 20.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  std::vector<Coordinates2D> nodes = {starting_point};
+  nodes.insert(nodes.end(), part_locations.begin(), part_locations.end());
+  nodes.push_back(delivery_point);
+  for (DistanceMetric metric :
+       {DistanceMetric::kEuclidean, DistanceMetric::kSquaredEuclidean,
+        DistanceMetric::kManhattan, DistanceMetric::kChebyshev}) {
+    // 15 nodes, so the vectorized rows have remainders of every length
+    const DistanceMatrix distances(starting_point, part_locations,
+                                   delivery_point, metric);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      for (size_t j = 0; j < nodes.size(); ++j) {
+        ASSERT_EQ(distances(i, j), computeDistance(metric, nodes[i], nodes[j]));
+      }
+    }
+    std::vector<int> pickup_order(part_locations.size());
+    std::iota(pickup_order.begin(), pickup_order.end(), 0);
+    EXPECT_EQ(distances.determinePathLength(pickup_order.data()),
+              determinePathLength(starting_point, part_locations,
+                                  delivery_point, pickup_order, metric));
+  }
+  const Coordinates2D a(1.0, 2.0), b(4.0, -2.0);
+  EXPECT_DOUBLE_EQ(computeDistance<EuclideanMetric>(a, b), 5.0);
+  EXPECT_DOUBLE_EQ(computeDistance<SquaredEuclideanMetric>(a, b), 25.0);
+  EXPECT_DOUBLE_EQ(computeDistance<ManhattanMetric>(a, b), 7.0);
+  EXPECT_DOUBLE_EQ(computeDistance<ChebyshevMetric>(a, b), 4.0);
+}
+
+TEST(DistanceMatrix, KernelsMatchPathLength) {
+  const Coordinates2D starting_point(10.0, 20.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  for (size_t n = 1; n <= 7; ++n) {
+    const std::vector<Coordinates2D> part_locations =
+        randomPartLocations(n, static_cast<unsigned int>(300 + n));
+    const DistanceMatrix distances(starting_point, part_locations,
+                                   delivery_point);
+    // all permutations, so that every kernel also processes a remainder
+    std::vector<int> pickup_order(n);
+    std::iota(pickup_order.begin(), pickup_order.end(), 0);
+    std::vector<int32_t> pickup_orders;
+    std::vector<double> reference_lengths;
+    do {
+      pickup_orders.insert(pickup_orders.end(), pickup_order.begin(),
+                           pickup_order.end());
+      reference_lengths.push_back(determinePathLength(
+          starting_point, part_locations, delivery_point, pickup_order));
+    } while (std::next_permutation(pickup_order.begin(), pickup_order.end()));
+    const size_t n_orders = reference_lengths.size();
+    std::vector<double> scalar_lengths(n_orders);
+    distances.evaluatePathLengths(pickup_orders.data(), n_orders,
+                                  scalar_lengths.data(), SimdLevel::kScalar);
+    for (size_t i = 0; i < n_orders; ++i) {
+      EXPECT_NEAR(scalar_lengths[i], reference_lengths[i], 1e-9);
+    }
+    std::vector<SimdLevel> simd_levels{SimdLevel::kScalar};
+    if (detectSimdLevel() != SimdLevel::kScalar) {
+      simd_levels.push_back(SimdLevel::kSse2);
+    }
+    if (detectSimdLevel() == SimdLevel::kAvx2) {
+      simd_levels.push_back(SimdLevel::kAvx2);
+    }
+    for (SimdLevel simd_level : simd_levels) {
+      std::vector<double> path_lengths(n_orders);
+      distances.evaluatePathLengths(pickup_orders.data(), n_orders,
+                                    path_lengths.data(), simd_level);
+      EXPECT_EQ(path_lengths, scalar_lengths);
+    }
+  }
+}
+
+TEST(PathEvaluator, PrecisionKernelsMatchScalarEvaluation) {
+  const Coordinates2D starting_point(10.0, 20.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  const std::vector<Coordinates2D> part_locations =
+      randomPartLocations(6, 1600);
+  const DistanceMatrix distances(starting_point, part_locations,
+                                 delivery_point);
+  const PathEvaluator<FloatPrecision> float_evaluator(distances);
+  const PathEvaluator<FixedPointPrecision> fixed_point_evaluator(distances);
+  // 720 permutations, so the 8-wide kernels also process a remainder when
+  // only a prefix is evaluated
+  std::vector<int> pickup_order(part_locations.size());
+  std::iota(pickup_order.begin(), pickup_order.end(), 0);
+  std::vector<int32_t> pickup_orders;
+  do {
+    pickup_orders.insert(pickup_orders.end(), pickup_order.begin(),
+                         pickup_order.end());
+  } while (std::next_permutation(pickup_order.begin(), pickup_order.end()));
+  const size_t n_orders = pickup_orders.size() / part_locations.size() - 3;
+  std::vector<float> float_lengths(n_orders);
+  std::vector<int32_t> fixed_point_lengths(n_orders);
+  float_evaluator.evaluatePathLengths(pickup_orders.data(), n_orders,
+                                      float_lengths.data());
+  fixed_point_evaluator.evaluatePathLengths(pickup_orders.data(), n_orders,
+                                            fixed_point_lengths.data());
+  for (size_t order = 0; order < n_orders; ++order) {
+    const int* current = &pickup_orders[order * part_locations.size()];
+    ASSERT_EQ(float_lengths[order],
+              float_evaluator.determinePathLength(current));
+    ASSERT_EQ(fixed_point_lengths[order],
+              fixed_point_evaluator.determinePathLength(current));
+    // each leg is rounded to the closest thousandth
+    const double length = distances.determinePathLength(current);
+    EXPECT_NEAR(PathEvaluator<FixedPointPrecision>::toLength(
+                    fixed_point_lengths[order]),
+                length, 0.0005 * (part_locations.size() + 1));
+    EXPECT_NEAR(float_lengths[order], length, 1e-6 * length);
+  }
+}
+
+TEST(ShortestPath, CollapsesColocatedLocations) {
+  const std::vector<Coordinates2D> part_locations{
+      {0.0, 0.0}, {5.0, 5.0}, {0.05, 0.0}, {5.0, 5.0}, {10.0, 0.0}};
+  std::vector<Coordinates2D> route_nodes;
+  std::vector<int> node_of_location;
+  collapseColocatedLocations(part_locations, 0.0, route_nodes,
+                             node_of_location);
+  EXPECT_EQ(route_nodes.size(), 4u);
+  EXPECT_EQ(node_of_location, std::vector<int>({0, 1, 2, 1, 3}));
+  collapseColocatedLocations(part_locations, 0.1, route_nodes,
+                             node_of_location);
+  EXPECT_EQ(route_nodes.size(), 3u);
+  EXPECT_EQ(node_of_location, std::vector<int>({0, 1, 0, 1, 2}));
+  std::vector<int> pickup_order;
+  expandRouteOrder({2, 0, 1}, node_of_location, pickup_order);
+  EXPECT_EQ(pickup_order, std::vector<int>({4, 0, 2, 1, 3}));
+}
+
+TEST(ShortestPath, SolvesColocatedPartsAsOneNode) {
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  // 24 parts on 4 shelves, too many for an exact solver without merging
+  const std::vector<Coordinates2D> shelves = randomPartLocations(4, 1000);
+  std::vector<Coordinates2D> part_locations;
+  for (size_t i = 0; i < 24; ++i) {
+    part_locations.push_back(shelves[i % shelves.size()]);
+  }
+  std::vector<int> pickup_order, shelf_order;
+  PathSolverResult result = determineShortestPath(
+      starting_point, part_locations, delivery_point, pickup_order,
+      PathSolverOptions());
+  EXPECT_TRUE(result._proven_optimal);
+  EXPECT_DOUBLE_EQ(result._path_length,
+                   solveBruteForce(starting_point, shelves, delivery_point,
+                                   shelf_order));
+  ASSERT_EQ(pickup_order.size(), part_locations.size());
+  // the parts of a shelf are picked up one after the other
+  for (size_t i = 0; i < pickup_order.size(); ++i) {
+    EXPECT_EQ(pickup_order[i] % 4, shelf_order[i / 6]);
+  }
+}
+
+TEST(ShortestPath, SmallSolverMatchesBruteForce) {
+  static_assert(
+      small_path_solvers::kPermutationTable<4>._permutations[23][0] == 3,
+      "the last permutation of 4 locations starts with 3");
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  for (size_t n = 0; n <= kSmallSolverMaxLocations; ++n) {
+    const std::vector<Coordinates2D> part_locations =
+        randomPartLocations(n, static_cast<unsigned int>(900 + n));
+    std::vector<int> pickup_order, brute_force_order;
+    double length =
+        solveSmall(starting_point, part_locations, delivery_point, pickup_order);
+    double brute_force_length = solveBruteForce(
+        starting_point, part_locations, delivery_point, brute_force_order);
+    // both add the legs in the same sequence and keep the first shortest
+    // pickup order, so the results are identical
+    EXPECT_EQ(length, brute_force_length);
+    EXPECT_EQ(pickup_order, brute_force_order);
+  }
+}
+
+TEST(ShortestPath, SmallSolverUsesSelectedMetric) {
+  const Coordinates2D starting_point(10.0, 20.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  const std::vector<Coordinates2D> part_locations =
+      randomPartLocations(6, 1500);
+  for (DistanceMetric metric :
+       {DistanceMetric::kManhattan, DistanceMetric::kChebyshev}) {
+    std::vector<int> small_order, held_karp_order;
+    const double small_length = solveSmall(
+        starting_point, part_locations, delivery_point, small_order, metric);
+    const double held_karp_length = solveHeldKarp(
+        DistanceMatrix(starting_point, part_locations, delivery_point, metric),
+        held_karp_order);
+    EXPECT_EQ(small_length, held_karp_length);
+    EXPECT_EQ(small_order, held_karp_order);
+  }
+  DistanceMetric metric = DistanceMetric::kEuclidean;
+  EXPECT_TRUE(parseDistanceMetric("manhattan", metric));
+  EXPECT_EQ(metric, DistanceMetric::kManhattan);
+  EXPECT_FALSE(parseDistanceMetric("taxicab", metric));
+  EXPECT_EQ(metric, DistanceMetric::kManhattan);
+}
+
+TEST(ShortestPath, HeldKarpMatchesBruteForce) {
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  for (size_t n = 1; n <= 8; ++n) {
+    const std::vector<Coordinates2D> part_locations =
+        randomPartLocations(n, static_cast<unsigned int>(n));
+    std::vector<int> brute_force_order, held_karp_order;
+    double brute_force_length = solveBruteForce(
+        starting_point, part_locations, delivery_point, brute_force_order);
+    double held_karp_length = solveHeldKarp(starting_point, part_locations,
+                                            delivery_point, held_karp_order);
+    EXPECT_NEAR(held_karp_length, brute_force_length, 1e-9);
+    EXPECT_NEAR(determinePathLength(starting_point, part_locations,
+                                    delivery_point, held_karp_order),
+                brute_force_length, 1e-9);
+  }
+}
+
+TEST(ShortestPath, HeldKarpSolvesLargeOrders) {
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  const std::vector<Coordinates2D> part_locations =
+      randomPartLocations(16, 16);
+  std::vector<int> pickup_order;
+  double length = solveHeldKarp(starting_point, part_locations,
+                                delivery_point, pickup_order);
+  std::vector<int> sorted_order = pickup_order;
+  std::sort(sorted_order.begin(), sorted_order.end());
+  std::vector<int> identity(part_locations.size());
+  std::iota(identity.begin(), identity.end(), 0);
+  EXPECT_EQ(sorted_order, identity);
+  EXPECT_NEAR(length,
+              determinePathLength(starting_point, part_locations,
+                                  delivery_point, pickup_order),
+              1e-9);
+  EXPECT_LE(length, determinePathLength(starting_point, part_locations,
+                                        delivery_point, identity));
+}
+
+TEST(ShortestPath, ExhaustiveMatchesBruteForce) {
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  for (size_t n = 0; n <= 8; ++n) {
+    const DistanceMatrix distances(
+        starting_point,
+        randomPartLocations(n, static_cast<unsigned int>(400 + n)),
+        delivery_point);
+    std::vector<int> brute_force_order, pickup_order;
+    double brute_force_length = solveBruteForce(distances, brute_force_order);
+    double length = solveExhaustive(distances, pickup_order);
+    EXPECT_EQ(length, brute_force_length);
+    EXPECT_EQ(pickup_order, brute_force_order);
+  }
+}
+
+TEST(ShortestPath, ParallelExhaustiveIsDeterministic) {
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  // a regular grid has many pickup orders of equal length
+  std::vector<Coordinates2D> part_locations;
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      part_locations.emplace_back(100.0 * i, 100.0 * j);
+    }
+  }
+  const DistanceMatrix distances(starting_point, part_locations,
+                                 delivery_point);
+  std::vector<int> reference_order;
+  double reference_length = solveBruteForce(distances, reference_order);
+  for (unsigned int n_threads : {1u, 2u, 3u, 8u}) {
+    std::vector<int> pickup_order;
+    double length = solveExhaustive(distances, pickup_order, n_threads);
+    EXPECT_EQ(length, reference_length);
+    EXPECT_EQ(pickup_order, reference_order);
+  }
+}
+
+TEST(ShortestPath, BranchAndBoundMatchesBruteForce) {
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  for (size_t n = 0; n <= 8; ++n) {
+    const std::vector<Coordinates2D> part_locations =
+        randomPartLocations(n, static_cast<unsigned int>(100 + n));
+    std::vector<int> brute_force_order, pickup_order;
+    double brute_force_length = solveBruteForce(
+        starting_point, part_locations, delivery_point, brute_force_order);
+    for (LowerBound lower_bound :
+         {LowerBound::kNearestNeighbor, LowerBound::kMinimumSpanningTree}) {
+      double length =
+          solveBranchAndBound(starting_point, part_locations, delivery_point,
+                              pickup_order, lower_bound);
+      EXPECT_NEAR(length, brute_force_length, 1e-9);
+      EXPECT_NEAR(determinePathLength(starting_point, part_locations,
+                                      delivery_point, pickup_order),
+                  brute_force_length, 1e-9);
+    }
+  }
+}
+
+TEST(ShortestPath, BranchAndBoundPrunesSearch) {
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  const std::vector<Coordinates2D> part_locations =
+      randomPartLocations(12, 12);
+  std::vector<int> pickup_order, held_karp_order;
+  PathSolverStatistics statistics;
+  double length = solveBranchAndBound(starting_point, part_locations,
+                                      delivery_point, pickup_order,
+                                      LowerBound::kMinimumSpanningTree,
+                                      &statistics);
+  EXPECT_NEAR(length,
+              solveHeldKarp(starting_point, part_locations, delivery_point,
+                            held_karp_order),
+              1e-9);
+  // 12! = 479001600 complete pickup orders exist
+  EXPECT_GT(statistics._nodes_pruned, 0u);
+  EXPECT_LT(statistics._nodes_explored, 479001600u);
+}
+
+TEST(ShortestPath, HeuristicFindsNearOptimalPath) {
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  for (size_t n = 0; n <= 14; ++n) {
+    const std::vector<Coordinates2D> part_locations =
+        randomPartLocations(n, static_cast<unsigned int>(200 + n));
+    std::vector<int> pickup_order, held_karp_order;
+    double length = solveHeuristic(starting_point, part_locations,
+                                   delivery_point, pickup_order);
+    double shortest_length = solveHeldKarp(starting_point, part_locations,
+                                           delivery_point, held_karp_order);
+    ASSERT_EQ(pickup_order.size(), n);
+    EXPECT_NEAR(length,
+                determinePathLength(starting_point, part_locations,
+                                    delivery_point, pickup_order),
+                1e-6);
+    EXPECT_LE(length, 1.1 * shortest_length);
+  }
+}
+
+TEST(ShortestPath, HeuristicHandlesLargeOrders) {
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  const std::vector<Coordinates2D> part_locations =
+      randomPartLocations(500, 500);
+  std::vector<int> pickup_order, greedy_order;
+  PathSolverOptions options;
+  options._heuristic_cutoff = 10;
+  determineShortestPath(starting_point, part_locations, delivery_point,
+                        pickup_order, options);
+  std::vector<int> sorted_order = pickup_order;
+  std::sort(sorted_order.begin(), sorted_order.end());
+  std::vector<int> identity(part_locations.size());
+  std::iota(identity.begin(), identity.end(), 0);
+  ASSERT_EQ(sorted_order, identity);
+  EXPECT_LT(determinePathLength(starting_point, part_locations,
+                                delivery_point, pickup_order),
+            solveNearestNeighbor(starting_point, part_locations,
+                                 delivery_point, greedy_order));
+}
+
+TEST(ShortestPath, PlanningBudgetBoundsSolveTime) {
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  const std::vector<Coordinates2D> part_locations =
+      randomPartLocations(20, 800);
+  for (ExactSolver exact_solver :
+       {ExactSolver::kHeldKarp, ExactSolver::kBranchAndBound,
+        ExactSolver::kExhaustive}) {
+    PathSolverOptions options;
+    options._exact_solver = exact_solver;
+    options._planning_budget_ms = 1;
+    std::vector<int> pickup_order;
+    auto begin = std::chrono::steady_clock::now();
+    PathSolverResult result =
+        determineShortestPath(starting_point, part_locations, delivery_point,
+                              pickup_order, options);
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    // 20 locations cannot be solved exactly within 1 ms, but the best path
+    // found so far is still a valid pickup order
+    EXPECT_FALSE(result._proven_optimal);
+    EXPECT_LT(elapsed, std::chrono::milliseconds(500));
+    std::vector<int> sorted_order = pickup_order;
+    std::sort(sorted_order.begin(), sorted_order.end());
+    std::vector<int> identity(part_locations.size());
+    std::iota(identity.begin(), identity.end(), 0);
+    ASSERT_EQ(sorted_order, identity);
+    EXPECT_NEAR(result._path_length,
+                determinePathLength(starting_point, part_locations,
+                                    delivery_point, pickup_order),
+                1e-6);
+  }
+
+  // The parts lie on a line in descending order, so every path of the first
+  // permutations starts at the far end and is longer than the nearest
+  // neighbor path. A search stopped early keeps the nearest neighbor path.
+  std::vector<Coordinates2D> line_locations;
+  for (int i = 19; i >= 0; --i) {
+    line_locations.emplace_back(static_cast<double>(i), 0.0);
+  }
+  const DistanceMatrix line_distances(starting_point, line_locations,
+                                      Coordinates2D(100.0, 0.0));
+  const Deadline deadline(std::chrono::milliseconds{1});
+  std::vector<int> pickup_order;
+  double length = solveExhaustive(line_distances, pickup_order, 1, &deadline);
+  EXPECT_NEAR(length, line_distances.determinePathLength(pickup_order.data()),
+              1e-6);
+  EXPECT_NEAR(length, 100.0, 1e-6);
+}
+
+TEST(ShortestPath, PlanningBudgetKeepsOptimalResult) {
+  const Coordinates2D starting_point(0.0, 0.0);
+  const Coordinates2D delivery_point(800.0, 800.0);
+  const std::vector<Coordinates2D> part_locations = randomPartLocations(9, 900);
+  std::vector<int> held_karp_order;
+  double shortest_length = solveHeldKarp(starting_point, part_locations,
+                                         delivery_point, held_karp_order);
+  for (ExactSolver exact_solver :
+       {ExactSolver::kHeldKarp, ExactSolver::kBranchAndBound,
+        ExactSolver::kExhaustive}) {
+    PathSolverOptions options;
+    options._exact_solver = exact_solver;
+    options._planning_budget_ms = 60000;
+    std::vector<int> pickup_order;
+    PathSolverResult result =
+        determineShortestPath(starting_point, part_locations, delivery_point,
+                              pickup_order, options);
+    EXPECT_TRUE(result._proven_optimal);
+    EXPECT_NEAR(result._path_length, shortest_length, 1e-9);
+  }
+}
+
 }  // namespace tests
 }  // namespace AMR
 